@@ -1,15 +1,10 @@
 #include "./app.h"
 
-// Initializes the application, SDL, window, and render engine.
-int application_init(Application* app, Canvas* canvas) {
-    // Ensure app and canvas are not NULL
-    if (app == NULL || canvas == NULL) {
-        fprintf(stderr, "Error: application_init received NULL pointer for app or canvas.\n");
-        return 1; // Indicate failure
-    }
-
-    // Assign the canvas to the application struct
+// Resets every resource pointer so that application_clean_up can be called at any point.
+static void application_reset(Application* app, Canvas* canvas, const Options* options) {
+    // Assign the canvas and options to the application struct
     app->canvas = canvas;
+    app->options = options;
 
     // CRUCIAL: Initialize all resource pointers to NULL.
     // This allows application_clean_up to safely check which resources need cleanup.
@@ -18,51 +13,54 @@ int application_init(Application* app, Canvas* canvas) {
     app->scene = NULL;
     app->camera = NULL;
     app->is_running = 0; // Not running yet
+    app->show_stats = 0;
+    app->has_rendered = 0; // Forces the first frame
+    app->rendered_camera_generation = 0;
+    app->rendered_scene_generation = 0;
+}
 
-    printf("Initializing SDL...\n");
-    // Initialize SDL video subsystem
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        fprintf(stderr, "SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
-        application_clean_up(app); // Call cleanup on failure
-        return 1;
-    }
-
-    printf("Creating window...\n");
-    // Create a window
-    app->window = SDL_CreateWindow(
-        "Simple SDL Window with Renderer", // window title
-        SDL_WINDOWPOS_UNDEFINED,           // initial x position
-        SDL_WINDOWPOS_UNDEFINED,           // initial y position
-        app->canvas->width,                // width, in pixels (using app->canvas)
-        app->canvas->height,               // height, in pixels (using app->canvas)
-        SDL_WINDOW_SHOWN                   // flags - SDL_WINDOW_SHOWN ensures it's visible
-    );
-
-    if (app->window == NULL) {
-        fprintf(stderr, "Window could not be created! SDL_Error: %s\n", SDL_GetError());
-        application_clean_up(app); // Call cleanup on failure
-        return 1;
-    }
-
+// Allocates and initializes the engine, scene and camera.
+// The engine presents into app->window when there is one and renders offscreen otherwise.
+static int application_init_resources(Application* app, Canvas* canvas) {
     printf("Allocating engine...\n");
-    // Allocate memory for the RenderEngine struct
-    app->engine = (Engine*)malloc(sizeof(Engine));
+    // Allocate memory for the RenderEngine struct, zeroed so that every
+    // sub-resource is in a known (NULL) state for engine_clean_up
+    app->engine = (Engine*)calloc(1, sizeof(Engine));
     if (app->engine == NULL) {
         fprintf(stderr, "Failed to allocate memory for RenderEngine.\n");
         application_clean_up(app); // Call cleanup on failure
         return 1;
     }
-    // Initialize the allocated RenderEngine to a known state
-    app->engine->renderer = NULL; // Initialize sub-members if necessary
 
     printf("Initializing engine...\n");
     // Initialize the render engine
-    if (engine_init(app->engine, app->window, canvas) != 0) {
+    int engine_status = (app->window != NULL)
+        ? engine_init(app->engine, app->window, canvas)
+        : engine_init_offscreen(app->engine, canvas);
+    if (engine_status != 0) {
         fprintf(stderr, "Failed to initialize render engine.\n");
         application_clean_up(app); // Call cleanup on failure
         return 1;
     }
 
+    app->engine->settings.use_packets = app->options->packets;
+    app->engine->settings.use_wavefront = app->options->wavefront;
+    app->engine->settings.recursion_depth = app->options->recursion_depth;
+    app->engine->settings.use_adaptive = app->options->adaptive;
+    app->engine->settings.adaptive_tolerance = app->options->adaptive_tolerance;
+    app->engine->settings.use_reprojection = app->options->reproject;
+
+    // A forced kernel level the CPU cannot run is fatal rather than silently measuring another one
+    if (app->options->cpu_level >= 0 && engine_set_cpu_level(app->engine, (CpuLevel)app->options->cpu_level) != 0) {
+        application_clean_up(app);
+        return 1;
+    }
+
+    // A failure here is not fatal: the engine keeps rendering on a single thread
+    engine_set_thread_count(app->engine, app->options->threads);
+    printf("Rendering with %d thread(s) and %s kernels.\n", app->engine->thread_pool.worker_count,
+           cpu_level_name(app->engine->cpu_level));
+
     printf("Allocating scene...\n");
     // Allocate memory for scene
     app->scene = (Scene*)malloc(sizeof(Scene));
@@ -73,8 +71,17 @@ int application_init(Application* app, Canvas* canvas) {
     }
 
     printf("Initializing scene...\n");
-    // Initialize scene
-    if (scene_init(app->scene) != 0) {
+    // Initialize scene from a binary or text description file, or the built-in demo scene
+    const char* scene_path = app->options->scene_path;
+    int scene_status;
+    if (scene_path == NULL) {
+        scene_status = scene_init(app->scene);
+    } else if (scene_binary_detect(scene_path)) {
+        scene_status = scene_binary_load(app->scene, scene_path);
+    } else {
+        scene_status = scene_file_load(app->scene, scene_path);
+    }
+    if (scene_status != 0) {
         fprintf(stderr, "Failed to initialize scene.\n");
         application_clean_up(app); // Call cleanup on failure
         return 1;
@@ -92,6 +99,54 @@ int application_init(Application* app, Canvas* canvas) {
     printf("Creating camera...\n");
     // Initialize camera struct itself
     *app->camera = camera_new(vector3_new(0, 0, 0), 1.0f, canvas);
+    if (app->scene->camera.is_set) {
+        app->camera->position = app->scene->camera.position;
+        app->camera->yaw = app->scene->camera.yaw;
+        app->camera->pitch = app->scene->camera.pitch;
+        camera_update_vectors(app->camera);
+    }
+
+    return 0;
+}
+
+// Initializes the application, SDL, window, and render engine.
+int application_init(Application* app, Canvas* canvas, const Options* options) {
+    // Ensure app, canvas and options are not NULL
+    if (app == NULL || canvas == NULL || options == NULL) {
+        fprintf(stderr, "Error: application_init received NULL pointer for app, canvas or options.\n");
+        return 1; // Indicate failure
+    }
+
+    application_reset(app, canvas, options);
+
+    printf("Initializing SDL...\n");
+    // Initialize SDL video subsystem
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        fprintf(stderr, "SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
+        application_clean_up(app); // Call cleanup on failure
+        return 1;
+    }
+
+    printf("Creating window...\n");
+    // Create a window
+    app->window = SDL_CreateWindow(
+        "Simple SDL Window with Renderer", // window title
+        SDL_WINDOWPOS_UNDEFINED,           // initial x position
+        SDL_WINDOWPOS_UNDEFINED,           // initial y position
+        app->canvas->width,                // width, in pixels (using app->canvas)
+        app->canvas->height,               // height, in pixels (using app->canvas)
+        SDL_WINDOW_SHOWN                   // flags - SDL_WINDOW_SHOWN ensures it's visible
+    );
+
+    if (app->window == NULL) {
+        fprintf(stderr, "Window could not be created! SDL_Error: %s\n", SDL_GetError());
+        application_clean_up(app); // Call cleanup on failure
+        return 1;
+    }
+
+    if (application_init_resources(app, canvas) != 0) {
+        return 1; // Resources were already cleaned up
+    }
 
     // Set initial application state
     app->is_running = 1; // Application is running
@@ -100,6 +155,246 @@ int application_init(Application* app, Canvas* canvas) {
     return 0; // Indicate success
 }
 
+// Initializes the application without SDL video: no window, offscreen framebuffer only.
+int application_init_headless(Application* app, Canvas* canvas, const Options* options) {
+    if (app == NULL || canvas == NULL || options == NULL) {
+        fprintf(stderr, "Error: application_init_headless received NULL pointer for app, canvas or options.\n");
+        return 1;
+    }
+
+    application_reset(app, canvas, options);
+
+    if (application_init_resources(app, canvas) != 0) {
+        return 1; // Resources were already cleaned up
+    }
+
+    app->is_running = 1;
+
+    printf("Headless application initialized successfully.\n");
+    return 0;
+}
+
+// Renders the given number of frames and returns the average frame time in milliseconds.
+static double application_time_frames(Application* app, int frames, int verbose) {
+    // The performance counter needs no SDL subsystem, so this works without video
+    const double ticks_per_ms = (double)SDL_GetPerformanceFrequency() / 1000.0;
+    const double pixels_per_frame = (double)app->canvas->width * app->canvas->height;
+    double total_ms = 0.0;
+
+    for (int frame = 0; frame < frames; ++frame) {
+        if (frame > 0 && app->options->pan != 0.0f) {
+            camera_rotate(app->camera, app->options->pan * (float)M_PI / 180.0f, 0.0f);
+        }
+
+        Uint64 frame_start = SDL_GetPerformanceCounter();
+
+        engine_render(app->engine, app->camera, app->scene, app->canvas);
+
+        double frame_ms = (double)(SDL_GetPerformanceCounter() - frame_start) / ticks_per_ms;
+        total_ms += frame_ms;
+        if (verbose) {
+            printf("Frame %d: %.2f ms (%.2f Mrays/s primary)", frame + 1, frame_ms, pixels_per_frame / (frame_ms * 1000.0));
+            if (app->engine->settings.use_adaptive) {
+                const int traced = SDL_AtomicGet(&app->engine->ray_counts.primary);
+                printf(", adaptive: %d of %.0f primary rays traced, %.1f%% saved",
+                    traced, pixels_per_frame, 100.0 * (1.0 - traced / pixels_per_frame));
+            }
+            if (app->engine->settings.use_reprojection) {
+                const int traced = SDL_AtomicGet(&app->engine->ray_counts.primary);
+                printf(", reprojection: %d of %.0f pixels traced, %.1f%% reused",
+                    traced, pixels_per_frame, 100.0 * (1.0 - traced / pixels_per_frame));
+            }
+            printf("\n");
+            if (ENGINE_STATS) {
+                engine_print_stats(app->engine, stdout);
+            }
+        }
+    }
+
+    return total_ms / frames;
+}
+
+// Times the same frames with 1, 2, 4, ... up to the configured thread count and prints the speedup.
+static void application_report_speedup(Application* app) {
+    const int max_threads = app->engine->thread_pool.worker_count;
+    double single_thread_ms = 0.0;
+
+    printf("Speedup report (%d frame(s) per run, %dx%d):\n", app->options->frames, app->canvas->width, app->canvas->height);
+    printf("  threads   ms/frame   speedup   efficiency\n");
+
+    for (int threads = 1; threads <= max_threads; threads = (threads * 2 > max_threads && threads < max_threads) ? max_threads : threads * 2) {
+        if (engine_set_thread_count(app->engine, threads) != 0) {
+            break;
+        }
+
+        double average_ms = application_time_frames(app, app->options->frames, 0);
+        if (threads == 1) {
+            single_thread_ms = average_ms;
+        }
+
+        double speedup = single_thread_ms / average_ms;
+        printf("  %7d   %8.2f   %6.2fx   %9.1f%%\n", threads, average_ms, speedup, 100.0 * speedup / threads);
+    }
+
+    // Leave the engine as configured
+    engine_set_thread_count(app->engine, max_threads);
+}
+
+// Renders a fixed number of frames offscreen, reports timings and optionally saves the last frame.
+int application_run_headless(Application* app) {
+    if (app == NULL || app->engine == NULL) {
+        fprintf(stderr, "Error: application_run_headless received an uninitialized application.\n");
+        return 1;
+    }
+
+    const Options* options = app->options;
+
+    if (options->speedup) {
+        application_report_speedup(app);
+    } else {
+        const double pixels_per_frame = (double)app->canvas->width * app->canvas->height;
+        double average_ms = application_time_frames(app, options->frames, 1);
+        printf("Rendered %d frame(s) at %dx%d on %d thread(s): average %.2f ms/frame, %.2f Mrays/s primary\n",
+            options->frames, app->canvas->width, app->canvas->height, app->engine->thread_pool.worker_count,
+            average_ms, pixels_per_frame / (average_ms * 1000.0));
+    }
+
+    if (options->output_path != NULL) {
+        if (render_target_write_ppm(&app->engine->target, options->output_path) != 0) {
+            fprintf(stderr, "Failed to write frame to %s.\n", options->output_path);
+            return 1;
+        }
+        printf("Wrote last frame to %s\n", options->output_path);
+    }
+
+    return 0;
+}
+
+// Applies a camera control key. Keys without a binding are ignored.
+static void application_handle_camera_key(Camera* camera, SDL_Keycode key) {
+    switch (key) {
+        // WASD moves in the horizontal plane
+        case SDLK_w: camera_translate(camera, vector3_new(0.0f, 0.0f, 0.1f)); break;
+        case SDLK_s: camera_translate(camera, vector3_new(0.0f, 0.0f, -0.1f)); break;
+        case SDLK_a: camera_translate(camera, vector3_new(0.1f, 0.0f, 0.0f)); break;
+        case SDLK_d: camera_translate(camera, vector3_new(-0.1f, 0.0f, 0.0f)); break;
+        // Space and C move up and down
+        case SDLK_SPACE: camera_translate(camera, vector3_new(0.0f, 0.1f, 0.0f)); break;
+        case SDLK_c: camera_translate(camera, vector3_new(0.0f, -0.1f, 0.0f)); break;
+        // Arrow keys rotate: left/right change the yaw, up/down the pitch
+        case SDLK_LEFT: camera_rotate(camera, 0.1f, 0.0f); break;
+        case SDLK_RIGHT: camera_rotate(camera, -0.1f, 0.0f); break;
+        case SDLK_UP: camera_rotate(camera, 0.0f, 0.1f); break;
+        case SDLK_DOWN: camera_rotate(camera, 0.0f, -0.1f); break;
+        default: break;
+    }
+}
+
+// Polls all pending events. Returns 1 when the window needs the last frame presented again.
+static int application_poll_events(Application* app) {
+    SDL_Event e;
+    int needs_present = 0;
+
+    while (SDL_PollEvent(&e) != 0) {
+        // User requests quit
+        if (e.type == SDL_QUIT) {
+            app->is_running = 0; // Set flag to exit main loop
+        } else if (e.type == SDL_KEYDOWN) {
+            if (e.key.keysym.sym == SDLK_ESCAPE) {
+                app->is_running = 0;
+            } else if (e.key.keysym.sym == SDLK_i) {
+                app->show_stats = !app->show_stats;
+                printf("Frame statistics %s.\n", app->show_stats ? "on" : "off");
+            } else {
+                application_handle_camera_key(app->camera, e.key.keysym.sym);
+            }
+        } else if (e.type == SDL_WINDOWEVENT &&
+                   (e.window.event == SDL_WINDOWEVENT_EXPOSED || e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)) {
+            needs_present = 1;
+        }
+    }
+
+    return needs_present;
+}
+
+// Returns 1 when the camera or scene changed since the last call, and remembers their current state.
+static int application_view_changed(Application* app) {
+    const unsigned int camera_generation = app->camera->generation;
+    const unsigned long scene_generation_now = scene_generation(app->scene);
+
+    if (app->has_rendered && camera_generation == app->rendered_camera_generation &&
+        scene_generation_now == app->rendered_scene_generation) {
+        return 0;
+    }
+
+    app->has_rendered = 1;
+    app->rendered_camera_generation = camera_generation;
+    app->rendered_scene_generation = scene_generation_now;
+    return 1;
+}
+
+// Sleeps until an event arrives or the idle timeout expires, without consuming the event
+static void application_wait_idle(void) {
+    SDL_WaitEventTimeout(NULL, APPLICATION_IDLE_WAIT_MS);
+}
+
+// Progressive loop: a coarse preview whenever the camera moves, refined in the background while it rests.
+// Refinement is traced in bands of tile rows so that input is polled every APPLICATION_REFINE_BUDGET_MS.
+static void application_loop_progressive(Application* app) {
+    const int tile_rows = engine_tile_row_count(app->canvas);
+
+    int refine_stride = 0; // Stride of the pass being refined; 0 once the frame is complete
+    int refine_tile_row = 0; // Next tile row of that pass
+
+    while (app->is_running) {
+        Uint32 frame_start = SDL_GetTicks();
+
+        int needs_present = application_poll_events(app);
+        if (!app->is_running) {
+            break;
+        }
+
+        if (application_view_changed(app)) {
+            // A full coarse frame is cheap enough to draw at interactive rates
+            engine_reset_ray_counts(app->engine);
+            engine_render_pass(app->engine, app->camera, app->scene, app->canvas, APPLICATION_PREVIEW_STRIDE, 0, 0, tile_rows);
+            engine_present(app->engine);
+
+            refine_stride = APPLICATION_PREVIEW_STRIDE / 2;
+            refine_tile_row = 0;
+            continue;
+        }
+
+        if (refine_stride > 0) {
+            // Trace bands of the current pass until the budget runs out, then go back to the events
+            do {
+                engine_render_pass(app->engine, app->camera, app->scene, app->canvas,
+                                   refine_stride, 1, refine_tile_row, refine_tile_row + 1);
+                ++refine_tile_row;
+            } while (refine_tile_row < tile_rows && (int)(SDL_GetTicks() - frame_start) < APPLICATION_REFINE_BUDGET_MS);
+
+            if (refine_tile_row == tile_rows) {
+                engine_present(app->engine); // Each finished pass is shown as it completes
+                refine_stride /= 2;
+                refine_tile_row = 0;
+
+                // The counters cover the preview and every refinement pass of this view
+                if (refine_stride == 0 && app->show_stats) {
+                    printf("Frame statistics (preview and refinement passes):\n");
+                    engine_print_stats(app->engine, stdout);
+                }
+            }
+            continue;
+        }
+
+        // Fully refined and unchanged: no tracing, only re-present when the window asks for it
+        if (needs_present) {
+            engine_present(app->engine);
+        }
+        application_wait_idle();
+    }
+}
+
 void application_loop(Application* app) {
     // Ensure app is not NULL
     if (app == NULL) {
@@ -107,7 +402,10 @@ void application_loop(Application* app) {
         return;
     }
 
-    SDL_Event e;
+    if (app->options->progressive) {
+        application_loop_progressive(app);
+        return;
+    }
 
     // --- Optimization: Frame Rate Control ---
     const int FPS = 5; // Desired frames per second
@@ -121,64 +419,23 @@ void application_loop(Application* app) {
         frameStart = SDL_GetTicks(); // Get the time at the start of the frame
 
         // Event polling loop
-        while (SDL_PollEvent(&e) != 0) {
-            // User requests quit
-            if (e.type == SDL_QUIT) {
-                app->is_running = 0; // Set flag to exit main loop
-            }
-            // Keyboard event handling
-            // Keyboard event handling
-            else if (e.type == SDL_KEYDOWN) {
-                // Check if the pressed key is ESC
-                if (e.key.keysym.sym == SDLK_ESCAPE) {
-                    app->is_running = 0; // Set flag to exit main loop
-                }
-                // Check for WASD keys
-                else if (e.key.keysym.sym == SDLK_w) {
-                    app->camera->position.z += 0.1; 
-                }
-                else if (e.key.keysym.sym == SDLK_s) {
-                    app->camera->position.z -= 0.1;
-                }
-                else if (e.key.keysym.sym == SDLK_a) {
-                    app->camera->position.x += 0.1;
-                }
-                else if (e.key.keysym.sym == SDLK_d) {
-                    app->camera->position.x -= 0.1;
-                }
-                // Check for Space key and C
-                else if (e.key.keysym.sym == SDLK_SPACE) {
-                    app->camera->position.y += 0.1;
-                }
-                else if (e.key.keysym.sym == SDLK_c) {
-                    app->camera->position.y -= 0.1;
-                }
-                // Check for Arrow keys
-                else if (e.key.keysym.sym == SDLK_LEFT) {
-                    app->camera->yaw += 0.1; // Rotate left (increase yaw)
-                    camera_update_vectors(app->camera); // Recalculate camera basis vectors
-                }
-                else if (e.key.keysym.sym == SDLK_RIGHT) {
-                    app->camera->yaw -= 0.1; // Rotate right (decrease yaw)
-                    camera_update_vectors(app->camera); // Recalculate camera basis vectors
-                }
-                else if (e.key.keysym.sym == SDLK_UP) {
-                    app->camera->pitch += 0.1; // Look up (increase pitch)
-                    // Clamp pitch to prevent camera flipping upside down (e.g., between -PI/2 and PI/2)
-                    if (app->camera->pitch > M_PI_2 - 0.01f) app->camera->pitch = M_PI_2 - 0.01f;
-                    camera_update_vectors(app->camera); // Recalculate camera basis vectors
-                }
-                else if (e.key.keysym.sym == SDLK_DOWN) {
-                    app->camera->pitch -= 0.1; // Look down (decrease pitch)
-                    // Clamp pitch to prevent camera flipping upside down
-                    if (app->camera->pitch < -M_PI_2 + 0.01f) app->camera->pitch = -M_PI_2 + 0.01f;
-                    camera_update_vectors(app->camera); // Recalculate camera basis vectors
-                }
+        int needs_present = application_poll_events(app);
+
+        if (!application_view_changed(app)) {
+            // Nothing changed: show the last frame again if needed and sleep until the next event
+            if (needs_present) {
+                engine_present(app->engine);
             }
+            application_wait_idle();
+            continue;
         }
 
         // Call the render function from the render engine
         engine_render(app->engine, app->camera, app->scene, app->canvas); // Correct call, app->render_engine is already a pointer
+        if (app->show_stats) {
+            printf("Frame statistics:\n");
+            engine_print_stats(app->engine, stdout);
+        }
 
         // --- Frame Rate Capping Logic ---
         frameTime = SDL_GetTicks() - frameStart; // Calculate time taken for this frame
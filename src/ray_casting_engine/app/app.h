@@ -6,15 +6,24 @@
 #include "../engine/engine.h"
 #include "../camera/camera.h"
 #include "../scene/scene.h"
+#include "../scene_file/scene_file.h"
+#include "../scene_binary/scene_binary.h"
 #include "../canvas/canvas.h"
+#include "../options/options.h"
 
 #ifndef _APP_H_
 #define _APP_H_
 
+#define APPLICATION_IDLE_WAIT_MS 100 ///< Longest sleep between checks for changes while nothing needs tracing.
+#define APPLICATION_PREVIEW_STRIDE 8 ///< Pixel stride of the preview drawn while the camera moves (a power of two).
+#define APPLICATION_REFINE_BUDGET_MS 30 ///< Time spent refining between two input checks.
+
 // Define the Application struct
 typedef struct Application {
     Canvas* canvas;
 
+    const Options* options;
+
     SDL_Window* window;
 
     Engine* engine;
@@ -24,10 +33,21 @@ typedef struct Application {
     Camera* camera;
 
     int is_running;
-    
+
+    int show_stats;             // Print frame statistics after every completed frame (toggled with I)
+
+    // Camera and scene generations the framebuffer was last traced with
+    int has_rendered;
+    unsigned int rendered_camera_generation;
+    unsigned long rendered_scene_generation;
+
 } Application;
 
-int application_init(Application* app, Canvas* canvas);
+int application_init(Application* app, Canvas* canvas, const Options* options);
+
+int application_init_headless(Application* app, Canvas* canvas, const Options* options);
+
+int application_run_headless(Application* app);
 
 void application_loop(Application* app);
 
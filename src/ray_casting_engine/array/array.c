@@ -0,0 +1,12 @@
+#include "./array.h"
+
+#include <stdlib.h>
+
+int array_reserve(void** array, size_t element_size, int count) {
+    void* resized = realloc(*array, element_size * (size_t)count);
+    if (!resized) {
+        return -1;
+    }
+    *array = resized;
+    return 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stddef.h>
+
+#ifndef _ARRAY_H_
+#define _ARRAY_H_
+
+// Grows a heap array to hold at least count elements; keeps the old block on failure.
+// Returns 0 on success, -1 when the allocation fails.
+int array_reserve(void** array, size_t element_size, int count);
+
+#endif
@@ -0,0 +1,478 @@
+// Headless benchmark for the ray casting engine.
+// Renders a fixed set of deterministic scenes and reports rays/s, frame time
+// percentiles and peak memory as text on stdout and optionally as JSON.
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "../engine/engine.h"
+#include "../scene/scene.h"
+#include "../scene_generator/scene_generator.h"
+#include "../camera/camera.h"
+#include "../canvas/canvas.h"
+#include "../options/options.h"
+
+#define BENCH_DEFAULT_FRAMES 5
+#define BENCH_DEFAULT_WARMUP 1
+#define BENCH_MESH_RADIUS 3.0f      // Sphere mesh of the mesh cases, placed among the generated spheres
+#define BENCH_ANIMATION_SPEED 0.05f // Largest distance an animated sphere drifts along each axis per frame
+
+/**
+ * @brief One benchmark scenario.
+ * Scenes with object_count == 0 use the built-in demo scene from scene_init.
+ */
+typedef struct BenchCase {
+    const char* name;
+    SceneGeneratorLayout layout;
+    int object_count;          ///< Generated objects: the ground plane and spheres.
+    int light_count;           ///< Lights including the ambient light.
+    int width;
+    int height;
+    int recursion_depth;
+    int animated;              ///< Percentage of the spheres moved before every frame (0 for a static scene).
+    int mesh_rings;            ///< Rings of a UV sphere mesh added in view, with twice as many segments (0 for none).
+} BenchCase;
+
+static const BenchCase bench_cases[] = {
+    { "demo",           SCENE_GENERATOR_UNIFORM,   0,      0,  640, 480, 3, 0,   0 },
+    { "spheres-64",     SCENE_GENERATOR_UNIFORM,   64,     4,  320, 240, 3, 0,   0 },
+    { "spheres-1k",     SCENE_GENERATOR_UNIFORM,   1024,   4,  320, 240, 3, 0,   0 },
+    { "spheres-16k",    SCENE_GENERATOR_UNIFORM,   16384,  4,  320, 240, 3, 0,   0 },
+    { "spheres-256k",   SCENE_GENERATOR_UNIFORM,   262144, 4,  320, 240, 3, 0,   0 },
+    { "clustered-16k",  SCENE_GENERATOR_CLUSTERED, 16384,  4,  320, 240, 3, 0,   0 },
+    { "clustered-256k", SCENE_GENERATOR_CLUSTERED, 262144, 4,  320, 240, 3, 0,   0 },
+    { "grid-4k",        SCENE_GENERATOR_GRID,      4096,   64, 160, 120, 3, 0,   0 },
+    { "lights-1",       SCENE_GENERATOR_UNIFORM,   1024,   1,  320, 240, 3, 0,   0 },
+    { "lights-16",      SCENE_GENERATOR_UNIFORM,   1024,   16, 320, 240, 3, 0,   0 },
+    { "lights-64",      SCENE_GENERATOR_UNIFORM,   1024,   64, 320, 240, 3, 0,   0 },
+    { "depth-0",        SCENE_GENERATOR_UNIFORM,   1024,   4,  320, 240, 0, 0,   0 },
+    { "depth-8",        SCENE_GENERATOR_UNIFORM,   1024,   4,  320, 240, 8, 0,   0 },
+    { "animated-16k",   SCENE_GENERATOR_UNIFORM,   16384,  4,  320, 240, 3, 100, 0 },
+    { "animated-256k",  SCENE_GENERATOR_UNIFORM,   262144, 4,  320, 240, 3, 10,  0 },
+    { "mesh-16k",       SCENE_GENERATOR_UNIFORM,   64,     4,  320, 240, 3, 0,   64 },
+    { "mesh-1m",        SCENE_GENERATOR_UNIFORM,   64,     4,  320, 240, 3, 0,   512 },
+    { "instances-100k", SCENE_GENERATOR_INSTANCED, 100000, 4,  320, 240, 3, 0,   0 },
+};
+
+/**
+ * @brief Command line configuration of the benchmark.
+ */
+typedef struct BenchOptions {
+    int frames;                ///< Timed frames per case.
+    int warmup;                ///< Untimed frames per case.
+    int threads;               ///< Render threads; 0 means one per logical CPU.
+    CpuLevel cpu_level;        ///< SIMD kernels of every case: the best the CPU supports unless --cpu forces a level.
+    const char* json_path;     ///< JSON report destination (NULL to skip).
+    const char* filter;        ///< Only run cases whose name contains this string (NULL for all).
+    EngineSettings settings;   ///< Engine modes; the recursion depth is set per case.
+    float pan;                 ///< Degrees the camera turns left before every frame, so frames differ.
+} BenchOptions;
+
+/**
+ * @brief Measurements of one case.
+ */
+typedef struct BenchResult {
+    const BenchCase* bench_case;
+    int object_count;          ///< Objects actually in the scene.
+    int light_count;           ///< Lights actually in the scene.
+    double mean_ms;
+    double min_ms;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+    double primary_rays_per_frame;
+    double shadow_rays_per_frame;
+    double reflection_rays_per_frame;
+    double primary_rays_per_second;
+    double total_rays_per_second;
+    long peak_rss_kb;          ///< Process peak after the case (monotonic across cases).
+    double update_mean_ms;     ///< Animated cases: moving the spheres and updating the BVH, per timed frame.
+    double update_max_ms;
+    int rebuilds;              ///< Animated cases: timed frames whose update rebuilt the BVH instead of refitting.
+} BenchResult;
+
+// Peak resident set size of the process in kilobytes
+static long bench_peak_rss_kb(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024; // Reported in bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+// Builds the case's scene: the built-in demo scene or a seeded procedural one, plus the case's mesh
+static int bench_build_scene(Scene* scene, const BenchCase* bench_case) {
+    if (bench_case->object_count == 0) {
+        return scene_init(scene);
+    }
+
+    SceneGeneratorParams params;
+    scene_generator_params_init(&params, bench_case->object_count, bench_case->light_count);
+    params.layout = bench_case->layout;
+
+    if (scene_generator_populate(scene, &params) != 0) {
+        return -1;
+    }
+
+    if (bench_case->mesh_rings > 0) {
+        Mesh mesh;
+        if (mesh_init_sphere(&mesh, BENCH_MESH_RADIUS, bench_case->mesh_rings, 2 * bench_case->mesh_rings) != 0) {
+            return -1;
+        }
+        const int mesh_index = meshList_add(scene->meshes, &mesh);
+        if (mesh_index < 0) {
+            mesh_free(&mesh);
+            return -1;
+        }
+        // Straight ahead of the camera, with the generated palette's first material
+        if (objectList_add(scene->objects, object_new_mesh(vector3_new(0.0f, 0.5f, 10.0f), mesh_index, -1, 0)) != 0) {
+            return -1;
+        }
+    }
+    return scene_build_acceleration(scene);
+}
+
+/**
+ * @brief Spheres moved by an animated case. Each drifts with its own constant velocity,
+ * so the BVH loosens from frame to frame until a rebuild becomes worthwhile.
+ */
+typedef struct BenchAnimation {
+    Vector3* base;             ///< Starting position of each moved sphere; entry i belongs to object id i + 1.
+    int count;                 ///< Moved spheres. The ground plane (id 0) stays put.
+} BenchAnimation;
+
+// Velocity component of an animated sphere, from an integer hash of its id
+static float bench_animation_velocity(unsigned int id, unsigned int axis) {
+    unsigned int h = id * 0x9E3779B9u + axis * 0x85EBCA6Bu;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return ((float)(h >> 8) / 16777216.0f * 2.0f - 1.0f) * BENCH_ANIMATION_SPEED;
+}
+
+// Records the starting positions of the case's animated spheres. Returns 0 on success, 1 on failure.
+static int bench_animation_init(BenchAnimation* animation, const Scene* scene, const BenchCase* bench_case) {
+    animation->base = NULL;
+    animation->count = (int)((long long)(scene->objects->count - 1) * bench_case->animated / 100);
+    if (animation->count <= 0) {
+        animation->count = 0;
+        return 0;
+    }
+
+    animation->base = (Vector3*)malloc(sizeof(Vector3) * (size_t)animation->count);
+    if (animation->base == NULL) {
+        fprintf(stderr, "Error: Failed to allocate %d animated spheres.\n", animation->count);
+        return 1;
+    }
+    for (int i = 0; i < animation->count; ++i) {
+        animation->base[i] = scene->objects->objects[scene_object_index(scene, i + 1)].position;
+    }
+    return 0;
+}
+
+// Moves the animated spheres to where they are at the given frame and updates the BVH.
+// Returns 1 if the BVH was rebuilt, 0 if it was refitted and -1 on failure.
+static int bench_animate(Scene* scene, const BenchAnimation* animation, int frame) {
+    for (int i = 0; i < animation->count; ++i) {
+        const unsigned int id = (unsigned int)i + 1;
+        Vector3 offset = vector3_new(bench_animation_velocity(id, 0), bench_animation_velocity(id, 1), bench_animation_velocity(id, 2));
+        if (scene_move_object(scene, (int)id, vector3_add(animation->base[i], vector3_scale(offset, (float)frame))) != 0) {
+            return -1;
+        }
+    }
+    return scene_update_acceleration(scene);
+}
+
+static int bench_compare_doubles(const void* a, const void* b) {
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double bench_percentile(const double* sorted, int count, double percentile) {
+    int rank = (int)(percentile / 100.0 * count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+// Renders one case and fills the result. Returns 0 on success, 1 on failure.
+static int bench_run_case(const BenchCase* bench_case, const BenchOptions* options, BenchResult* result) {
+    Canvas canvas = { bench_case->width, bench_case->height };
+    Scene scene;
+    Engine engine;
+    memset(&engine, 0, sizeof(engine));
+
+    if (bench_build_scene(&scene, bench_case) != 0) {
+        fprintf(stderr, "Error: Failed to build the scene of case '%s'.\n", bench_case->name);
+        scene_clean_up(&scene);
+        return 1;
+    }
+    if (engine_init_offscreen(&engine, &canvas) != 0) {
+        scene_clean_up(&scene);
+        return 1;
+    }
+
+    engine.settings = options->settings;
+    engine.settings.recursion_depth = bench_case->recursion_depth;
+    engine_set_thread_count(&engine, options->threads);
+    if (engine_set_cpu_level(&engine, options->cpu_level) != 0) {
+        engine_clean_up(&engine);
+        scene_clean_up(&scene);
+        return 1;
+    }
+
+    Camera camera = camera_new(vector3_new(0.0f, 0.0f, 0.0f), 1.0f, &canvas);
+    const float pan = options->pan * (float)M_PI / 180.0f;
+
+    BenchAnimation animation;
+    double* frame_ms = (double*)malloc(sizeof(double) * (size_t)options->frames);
+    if (frame_ms == NULL || bench_animation_init(&animation, &scene, bench_case) != 0) {
+        fprintf(stderr, "Error: Failed to allocate the frame state of case '%s'.\n", bench_case->name);
+        free(frame_ms);
+        engine_clean_up(&engine);
+        scene_clean_up(&scene);
+        return 1;
+    }
+
+    const double ticks_per_ms = (double)SDL_GetPerformanceFrequency() / 1000.0;
+    double total_ms = 0.0;
+    double primary = 0.0, shadow = 0.0, reflection = 0.0;
+    double update_total_ms = 0.0, update_max_ms = 0.0;
+    int rebuilds = 0;
+
+    // Warm-up frames come first and are not recorded
+    for (int frame = -options->warmup; frame < options->frames; ++frame) {
+        if (pan != 0.0f) {
+            camera_rotate(&camera, pan, 0.0f);
+        }
+        if (animation.count > 0) {
+            Uint64 update_start = SDL_GetPerformanceCounter();
+            const int updated = bench_animate(&scene, &animation, frame + options->warmup + 1);
+            const double update_ms = (double)(SDL_GetPerformanceCounter() - update_start) / ticks_per_ms;
+            if (updated < 0) {
+                fprintf(stderr, "Error: Failed to animate case '%s'.\n", bench_case->name);
+                free(animation.base);
+                free(frame_ms);
+                engine_clean_up(&engine);
+                scene_clean_up(&scene);
+                return 1;
+            }
+            if (frame >= 0) {
+                update_total_ms += update_ms;
+                update_max_ms = (update_ms > update_max_ms) ? update_ms : update_max_ms;
+                rebuilds += updated;
+            }
+        }
+        if (frame < 0) {
+            engine_render(&engine, &camera, &scene, &canvas);
+            continue;
+        }
+
+        Uint64 frame_start = SDL_GetPerformanceCounter();
+        engine_render(&engine, &camera, &scene, &canvas);
+        frame_ms[frame] = (double)(SDL_GetPerformanceCounter() - frame_start) / ticks_per_ms;
+        total_ms += frame_ms[frame];
+
+        primary += SDL_AtomicGet(&engine.ray_counts.primary);
+        shadow += SDL_AtomicGet(&engine.ray_counts.shadow);
+        reflection += SDL_AtomicGet(&engine.ray_counts.reflection);
+    }
+
+    qsort(frame_ms, (size_t)options->frames, sizeof(double), bench_compare_doubles);
+
+    result->bench_case = bench_case;
+    result->object_count = scene.objects->count;
+    result->light_count = (int)scene.lights->count;
+    result->mean_ms = total_ms / options->frames;
+    result->min_ms = frame_ms[0];
+    result->p50_ms = bench_percentile(frame_ms, options->frames, 50.0);
+    result->p90_ms = bench_percentile(frame_ms, options->frames, 90.0);
+    result->p99_ms = bench_percentile(frame_ms, options->frames, 99.0);
+    result->max_ms = frame_ms[options->frames - 1];
+    result->primary_rays_per_frame = primary / options->frames;
+    result->shadow_rays_per_frame = shadow / options->frames;
+    result->reflection_rays_per_frame = reflection / options->frames;
+    result->primary_rays_per_second = primary / (total_ms / 1000.0);
+    result->total_rays_per_second = (primary + shadow + reflection) / (total_ms / 1000.0);
+    result->peak_rss_kb = bench_peak_rss_kb();
+    result->update_mean_ms = update_total_ms / options->frames;
+    result->update_max_ms = update_max_ms;
+    result->rebuilds = rebuilds;
+
+    free(animation.base);
+    free(frame_ms);
+    engine_clean_up(&engine);
+    scene_clean_up(&scene);
+    return 0;
+}
+
+static void bench_print_result(const BenchResult* result) {
+    const BenchCase* bench_case = result->bench_case;
+    printf("%-14s %7d obj %3d lights %4dx%-4d depth %d | %8.2f ms/frame (p50 %.2f, p90 %.2f, p99 %.2f) | "
+           "%7.3f Mrays/s primary %7.3f Mrays/s total | peak RSS %ld KiB",
+        bench_case->name, result->object_count, result->light_count, bench_case->width, bench_case->height,
+        bench_case->recursion_depth, result->mean_ms, result->p50_ms, result->p90_ms, result->p99_ms,
+        result->primary_rays_per_second / 1e6, result->total_rays_per_second / 1e6, result->peak_rss_kb);
+    if (bench_case->animated > 0) {
+        printf(" | %d%% moved: update %.3f ms (max %.3f), %d rebuild(s)",
+            bench_case->animated, result->update_mean_ms, result->update_max_ms, result->rebuilds);
+    }
+    printf("\n");
+}
+
+static int bench_write_json(const char* path, const BenchOptions* options, int threads, const BenchResult* results, int count) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        perror("Failed to open the JSON report");
+        return 1;
+    }
+
+    fprintf(file, "{\n  \"benchmark\": \"ray_casting_engine\",\n");
+    fprintf(file, "  \"threads\": %d,\n  \"frames\": %d,\n  \"warmup\": %d,\n", threads, options->frames, options->warmup);
+    fprintf(file, "  \"kernels\": \"%s\",\n", cpu_level_name(options->cpu_level));
+    fprintf(file, "  \"packets\": %s,\n  \"wavefront\": %s,\n  \"adaptive\": %s,\n  \"reproject\": %s,\n  \"pan_degrees\": %.3f,\n",
+        options->settings.use_packets ? "true" : "false", options->settings.use_wavefront ? "true" : "false",
+        options->settings.use_adaptive ? "true" : "false", options->settings.use_reprojection ? "true" : "false",
+        options->pan);
+    fprintf(file, "  \"cases\": [\n");
+
+    for (int i = 0; i < count; ++i) {
+        const BenchResult* r = &results[i];
+        const BenchCase* c = r->bench_case;
+        fprintf(file,
+            "    {\"name\": \"%s\", \"objects\": %d, \"lights\": %d, \"width\": %d, \"height\": %d, \"depth\": %d,\n"
+            "     \"ms_per_frame\": {\"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n"
+            "     \"rays_per_frame\": {\"primary\": %.0f, \"shadow\": %.0f, \"reflection\": %.0f},\n"
+            "     \"primary_rays_per_sec\": %.1f, \"total_rays_per_sec\": %.1f, \"peak_rss_kb\": %ld,\n"
+            "     \"animated_percent\": %d, \"update_ms\": {\"mean\": %.4f, \"max\": %.4f}, \"rebuilds\": %d}%s\n",
+            c->name, r->object_count, r->light_count, c->width, c->height, c->recursion_depth,
+            r->mean_ms, r->min_ms, r->p50_ms, r->p90_ms, r->p99_ms, r->max_ms,
+            r->primary_rays_per_frame, r->shadow_rays_per_frame, r->reflection_rays_per_frame,
+            r->primary_rays_per_second, r->total_rays_per_second, r->peak_rss_kb,
+            c->animated, r->update_mean_ms, r->update_max_ms, r->rebuilds,
+            (i + 1 < count) ? "," : "");
+    }
+
+    fprintf(file, "  ],\n  \"peak_rss_kb\": %ld\n}\n", bench_peak_rss_kb());
+    fclose(file);
+    return 0;
+}
+
+static void bench_print_usage(const char* program_name) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --frames <count>    Timed frames per case (default %d)\n"
+        "  --warmup <count>    Untimed frames per case (default %d)\n"
+        "  --threads <count>   Render threads (default: one per logical CPU)\n"
+        "  --cpu <level>       SIMD kernels: scalar, sse, avx2 or avx512 (default: the best the CPU supports)\n"
+        "  --json <file>       Also write the results as JSON\n"
+        "  --filter <text>     Only run cases whose name contains the text\n"
+        "  --no-packets        Trace primary rays one by one\n"
+        "  --wavefront         Trace tiles breadth first through ray queues\n"
+        "  --adaptive          Interpolate smooth regions from sparse primary rays\n"
+        "  --reproject         Reuse the previous frame where it reprojects into the new view\n"
+        "  --pan <degrees>     Turn the camera by this angle before every frame (use with --reproject)\n",
+        program_name, BENCH_DEFAULT_FRAMES, BENCH_DEFAULT_WARMUP);
+}
+
+static int bench_parse_options(BenchOptions* options, int argc, char* argv[]) {
+    options->frames = BENCH_DEFAULT_FRAMES;
+    options->warmup = BENCH_DEFAULT_WARMUP;
+    options->threads = 0;
+    options->cpu_level = cpu_detect_level();
+    options->json_path = NULL;
+    options->filter = NULL;
+    options->settings = engine_default_settings();
+    options->pan = 0.0f;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--no-packets") == 0) {
+            options->settings.use_packets = 0;
+        } else if (strcmp(arg, "--wavefront") == 0) {
+            options->settings.use_wavefront = 1;
+        } else if (strcmp(arg, "--adaptive") == 0) {
+            options->settings.use_adaptive = 1;
+        } else if (strcmp(arg, "--reproject") == 0) {
+            options->settings.use_reprojection = 1;
+        } else if (strcmp(arg, "--pan") == 0 && value != NULL) {
+            if (options_parse_degrees(arg, value, &options->pan) != 0) return 1;
+            ++i;
+        } else if (strcmp(arg, "--frames") == 0 && value != NULL) {
+            if (options_parse_positive_int(arg, value, &options->frames) != 0) return 1;
+            ++i;
+        } else if (strcmp(arg, "--warmup") == 0 && value != NULL) {
+            if (options_parse_non_negative_int(arg, value, &options->warmup) != 0) return 1;
+            ++i;
+        } else if (strcmp(arg, "--threads") == 0 && value != NULL) {
+            if (options_parse_positive_int(arg, value, &options->threads) != 0) return 1;
+            ++i;
+        } else if (strcmp(arg, "--cpu") == 0 && value != NULL) {
+            if (cpu_parse_level(value, &options->cpu_level) != 0) {
+                fprintf(stderr, "Error: --cpu expects scalar, sse, avx2 or avx512.\n");
+                return 1;
+            }
+            ++i;
+        } else if (strcmp(arg, "--json") == 0 && value != NULL) {
+            options->json_path = value;
+            ++i;
+        } else if (strcmp(arg, "--filter") == 0 && value != NULL) {
+            options->filter = value;
+            ++i;
+        } else {
+            fprintf(stderr, "Error: unknown option or missing value for '%s'.\n", arg);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (bench_parse_options(&options, argc, argv) != 0) {
+        bench_print_usage(argv[0]);
+        return 1;
+    }
+
+    const int case_count = (int)(sizeof(bench_cases) / sizeof(bench_cases[0]));
+    BenchResult results[sizeof(bench_cases) / sizeof(bench_cases[0])];
+    int result_count = 0;
+    const int threads = (options.threads > 0) ? options.threads : thread_pool_default_worker_count();
+
+    printf("Ray casting benchmark: %d thread(s), %s kernels, %d frame(s) per case after %d warm-up frame(s)\n",
+        threads, cpu_level_name(options.cpu_level), options.frames, options.warmup);
+
+    for (int i = 0; i < case_count; ++i) {
+        if (options.filter != NULL && strstr(bench_cases[i].name, options.filter) == NULL) {
+            continue;
+        }
+
+        if (bench_run_case(&bench_cases[i], &options, &results[result_count]) != 0) {
+            return 1;
+        }
+        bench_print_result(&results[result_count]);
+        ++result_count;
+    }
+
+    if (options.json_path != NULL) {
+        if (bench_write_json(options.json_path, &options, threads, results, result_count) != 0) {
+            return 1;
+        }
+        printf("Wrote JSON report to %s\n", options.json_path);
+    }
+
+    return 0;
+}
@@ -0,0 +1,437 @@
+#include "./bvh.h"
+
+#define BVH_TRAVERSAL_COST 1.0f     // Cost of visiting a node, the unit of primitive costs
+
+typedef struct BvhBin {
+    Aabb bounds;
+    int count;
+    float cost;
+} BvhBin;
+
+// Range of primitives waiting to become a node
+typedef struct BvhBuildTask {
+    int node;
+    int first;
+    int count;
+    int depth;
+} BvhBuildTask;
+
+static Aabb aabb_empty(void) {
+    Aabb box = {
+        { FLT_MAX, FLT_MAX, FLT_MAX },
+        { -FLT_MAX, -FLT_MAX, -FLT_MAX }
+    };
+    return box;
+}
+
+static float vector3_axis(Vector3 v, int axis) {
+    return (axis == 0) ? v.x : (axis == 1) ? v.y : v.z;
+}
+
+Aabb aabb_union(Aabb a, Aabb b) {
+    Aabb box = {
+        { fminf(a.min.x, b.min.x), fminf(a.min.y, b.min.y), fminf(a.min.z, b.min.z) },
+        { fmaxf(a.max.x, b.max.x), fmaxf(a.max.y, b.max.y), fmaxf(a.max.z, b.max.z) }
+    };
+    return box;
+}
+
+float aabb_half_area(Aabb box) {
+    Vector3 extent = vector3_subtract(box.max, box.min);
+    if (extent.x < 0.0f || extent.y < 0.0f || extent.z < 0.0f) {
+        return 0.0f; // Empty box
+    }
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+void bvh_init(Bvh* bvh) {
+    bvh->nodes = NULL;
+    bvh->node_count = 0;
+    bvh->primitive_count = 0;
+    bvh->external = 0;
+    bvh->parents = NULL;
+    bvh->primitive_leaves = NULL;
+    bvh->marked_leaves = NULL;
+    bvh->marked_count = 0;
+    bvh->marked = NULL;
+    bvh->built_areas = NULL;
+    bvh->inflation_sum = 0.0;
+}
+
+static Aabb bvh_node_bounds(const BvhNode* node) {
+    Aabb box = { node->bounds_min, node->bounds_max };
+    return box;
+}
+
+int bvh_attach(Bvh* bvh, BvhNode* nodes, int node_count, int primitive_count) {
+    if (bvh == NULL || bvh->nodes != NULL || node_count < 0 || (node_count > 0 && nodes == NULL)) {
+        fprintf(stderr, "Error: bvh_attach needs an empty hierarchy and a valid node array.\n");
+        return -1;
+    }
+
+    bvh->nodes = nodes;
+    bvh->node_count = node_count;
+    bvh->primitive_count = primitive_count;
+    bvh->external = 1;
+    return 0;
+}
+
+void bvh_free(Bvh* bvh) {
+    if (bvh != NULL) {
+        if (!bvh->external) {
+            free(bvh->nodes);
+        }
+        free(bvh->parents);
+        free(bvh->primitive_leaves);
+        free(bvh->marked_leaves);
+        free(bvh->marked);
+        free(bvh->built_areas);
+        bvh_init(bvh);
+    }
+}
+
+// Allocates the parent and leaf links that refitting walks, once per tree
+static int bvh_prepare_refit(Bvh* bvh) {
+    if (bvh->parents != NULL) {
+        return 0;
+    }
+
+    bvh->parents = (int*)malloc((size_t)bvh->node_count * sizeof(int));
+    bvh->primitive_leaves = (int*)malloc((size_t)bvh->primitive_count * sizeof(int));
+    bvh->marked_leaves = (int*)malloc((size_t)bvh->node_count * sizeof(int));
+    bvh->marked = (unsigned char*)calloc((size_t)bvh->node_count, 1);
+    bvh->built_areas = (float*)malloc((size_t)bvh->node_count * sizeof(float));
+    if (bvh->parents == NULL || bvh->primitive_leaves == NULL || bvh->marked_leaves == NULL ||
+        bvh->marked == NULL || bvh->built_areas == NULL) {
+        fprintf(stderr, "Error: failed to allocate BVH refit links for %d nodes.\n", bvh->node_count);
+        free(bvh->parents);
+        free(bvh->primitive_leaves);
+        free(bvh->marked_leaves);
+        free(bvh->marked);
+        free(bvh->built_areas);
+        bvh->parents = NULL;
+        bvh->primitive_leaves = NULL;
+        bvh->marked_leaves = NULL;
+        bvh->marked = NULL;
+        bvh->built_areas = NULL;
+        return -1;
+    }
+
+    bvh->parents[0] = -1;
+    for (int i = 0; i < bvh->node_count; ++i) {
+        const BvhNode* node = &bvh->nodes[i];
+        bvh->built_areas[i] = aabb_half_area(bvh_node_bounds(node));
+        if (node->primitive_count > 0) {
+            for (int p = node->left_first; p < node->left_first + node->primitive_count; ++p) {
+                bvh->primitive_leaves[p] = i;
+            }
+        } else {
+            bvh->parents[node->left_first] = i;
+            bvh->parents[node->left_first + 1] = i;
+        }
+    }
+
+    bvh->marked_count = 0;
+    bvh->inflation_sum = (double)bvh->node_count;
+    return 0;
+}
+
+int bvh_mark_primitive(Bvh* bvh, int primitive) {
+    if (bvh == NULL || primitive < 0 || primitive >= bvh->primitive_count) {
+        return -1;
+    }
+    if (bvh_prepare_refit(bvh) != 0) {
+        return -1;
+    }
+
+    const int leaf = bvh->primitive_leaves[primitive];
+    if (!bvh->marked[leaf]) {
+        bvh->marked[leaf] = 1;
+        bvh->marked_leaves[bvh->marked_count++] = leaf;
+    }
+    return 0;
+}
+
+// Stores new bounds in a node and keeps the inflation sum current. Returns 0 if the bounds did not change.
+static int bvh_set_bounds(Bvh* bvh, int index, Aabb box) {
+    BvhNode* node = &bvh->nodes[index];
+    if (node->bounds_min.x == box.min.x && node->bounds_min.y == box.min.y && node->bounds_min.z == box.min.z &&
+        node->bounds_max.x == box.max.x && node->bounds_max.y == box.max.y && node->bounds_max.z == box.max.z) {
+        return 0;
+    }
+
+    const float built_area = bvh->built_areas[index];
+    if (built_area > 0.0f) {
+        bvh->inflation_sum += ((double)aabb_half_area(box) - (double)aabb_half_area(bvh_node_bounds(node))) / built_area;
+    }
+    node->bounds_min = box.min;
+    node->bounds_max = box.max;
+    return 1;
+}
+
+void bvh_refit(Bvh* bvh, BvhBoundsFunction bounds, const void* context) {
+    if (bvh == NULL || bounds == NULL || bvh->marked_count == 0) {
+        return;
+    }
+
+    // After each path every node off the remaining paths encloses its children again,
+    // so a path can stop as soon as a node's bounds come out unchanged
+    for (int m = 0; m < bvh->marked_count; ++m) {
+        const int leaf = bvh->marked_leaves[m];
+        const BvhNode* node = &bvh->nodes[leaf];
+        bvh->marked[leaf] = 0;
+
+        Aabb box = aabb_empty();
+        for (int p = node->left_first; p < node->left_first + node->primitive_count; ++p) {
+            box = aabb_union(box, bounds(context, p));
+        }
+
+        int index = leaf;
+        while (bvh_set_bounds(bvh, index, box)) {
+            index = bvh->parents[index];
+            if (index < 0) {
+                break;
+            }
+            const BvhNode* left = &bvh->nodes[bvh->nodes[index].left_first];
+            box = aabb_union(bvh_node_bounds(left), bvh_node_bounds(left + 1));
+        }
+    }
+
+    bvh->marked_count = 0;
+}
+
+float bvh_inflation(const Bvh* bvh) {
+    if (bvh == NULL || bvh->built_areas == NULL || bvh->node_count == 0) {
+        return 1.0f;
+    }
+    return (float)(bvh->inflation_sum / bvh->node_count);
+}
+
+static float bvh_primitive_cost(const float* costs, int primitive) {
+    return (costs != NULL) ? costs[primitive] : BVH_PRIMITIVE_COST;
+}
+
+// Finds the cheapest binned SAH split of a primitive range and sums the cost of testing all of it.
+// Returns the split cost, or FLT_MAX when the centroids cannot be separated.
+static float bvh_find_split(const Aabb* bounds, const Vector3* centroids, const float* costs, const int* order, int first, int count,
+                            int* out_axis, float* out_position, float* out_range_cost) {
+    Aabb centroid_bounds = aabb_empty();
+    float range_cost = 0.0f;
+    for (int i = first; i < first + count; ++i) {
+        Aabb point = { centroids[order[i]], centroids[order[i]] };
+        centroid_bounds = aabb_union(centroid_bounds, point);
+        range_cost += bvh_primitive_cost(costs, order[i]);
+    }
+    *out_range_cost = range_cost;
+
+    float best_cost = FLT_MAX;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        const float axis_min = vector3_axis(centroid_bounds.min, axis);
+        const float axis_max = vector3_axis(centroid_bounds.max, axis);
+        if (axis_max - axis_min <= 1e-6f) {
+            continue; // All centroids coincide along this axis
+        }
+
+        BvhBin bins[BVH_BIN_COUNT];
+        for (int b = 0; b < BVH_BIN_COUNT; ++b) {
+            bins[b].bounds = aabb_empty();
+            bins[b].count = 0;
+            bins[b].cost = 0.0f;
+        }
+
+        const float bin_scale = BVH_BIN_COUNT / (axis_max - axis_min);
+        for (int i = first; i < first + count; ++i) {
+            int b = (int)((vector3_axis(centroids[order[i]], axis) - axis_min) * bin_scale);
+            if (b >= BVH_BIN_COUNT) b = BVH_BIN_COUNT - 1;
+            bins[b].count++;
+            bins[b].cost += bvh_primitive_cost(costs, order[i]);
+            bins[b].bounds = aabb_union(bins[b].bounds, bounds[order[i]]);
+        }
+
+        // Sweep from the right to get the area, count and cost of every right-hand side
+        float right_area[BVH_BIN_COUNT - 1];
+        int right_count[BVH_BIN_COUNT - 1];
+        float right_cost[BVH_BIN_COUNT - 1];
+        Aabb right_box = aabb_empty();
+        int right_sum = 0;
+        float right_cost_sum = 0.0f;
+        for (int b = BVH_BIN_COUNT - 1; b > 0; --b) {
+            right_box = aabb_union(right_box, bins[b].bounds);
+            right_sum += bins[b].count;
+            right_cost_sum += bins[b].cost;
+            right_area[b - 1] = aabb_half_area(right_box);
+            right_count[b - 1] = right_sum;
+            right_cost[b - 1] = right_cost_sum;
+        }
+
+        // Then from the left, evaluating each of the BVH_BIN_COUNT - 1 planes
+        Aabb left_box = aabb_empty();
+        int left_sum = 0;
+        float left_cost_sum = 0.0f;
+        for (int b = 0; b < BVH_BIN_COUNT - 1; ++b) {
+            left_box = aabb_union(left_box, bins[b].bounds);
+            left_sum += bins[b].count;
+            left_cost_sum += bins[b].cost;
+            if (left_sum == 0 || right_count[b] == 0) {
+                continue;
+            }
+            float cost = left_cost_sum * aabb_half_area(left_box) + right_cost[b] * right_area[b];
+            if (cost < best_cost) {
+                best_cost = cost;
+                *out_axis = axis;
+                *out_position = axis_min + (b + 1) / bin_scale;
+            }
+        }
+    }
+
+    return best_cost;
+}
+
+// Chooses where to split a primitive range: a binned SAH plane, or the middle of the range when the
+// centroids cannot be separated. Returns the index of the first right-hand primitive, or -1 for a leaf.
+static int bvh_split_range(const Aabb* bounds, const Vector3* centroids, const float* costs, int* order, int first, int count,
+                           Aabb range_bounds) {
+    if (count <= 1) {
+        return -1;
+    }
+
+    int axis = 0;
+    float split_position = 0.0f;
+    float leaf_cost = 0.0f;
+    const float split_cost = bvh_find_split(bounds, centroids, costs, order, first, count, &axis, &split_position, &leaf_cost);
+    const float node_area = aabb_half_area(range_bounds);
+    const float relative_split_cost = (node_area > 0.0f)
+        ? BVH_TRAVERSAL_COST + split_cost / node_area
+        : FLT_MAX;
+
+    int middle;
+    if (split_cost < FLT_MAX) {
+        if (count <= BVH_MAX_LEAF_SIZE && leaf_cost <= relative_split_cost) {
+            return -1; // Splitting does not pay off
+        }
+        // Partition the range around the chosen plane
+        int i = first;
+        int j = first + count - 1;
+        while (i <= j) {
+            if (vector3_axis(centroids[order[i]], axis) < split_position) {
+                ++i;
+            } else {
+                int swap = order[i];
+                order[i] = order[j];
+                order[j--] = swap;
+            }
+        }
+        middle = i;
+    } else {
+        middle = first; // Coincident centroids, fall through to the median split below
+    }
+
+    if (middle == first || middle == first + count) {
+        if (count <= BVH_MAX_LEAF_SIZE) {
+            return -1;
+        }
+        middle = first + count / 2; // Degenerate split: halve the range by index
+    }
+    return middle;
+}
+
+// Moves the primitives of the first primitive's kind to the front of a range.
+// Returns the index of the first other primitive, or -1 when the range holds a single kind.
+static int bvh_split_kinds(const unsigned char* kinds, int* order, int first, int count) {
+    const unsigned char kind = kinds[order[first]];
+    int i = first + 1;
+    int j = first + count - 1;
+    while (i <= j) {
+        if (kinds[order[i]] == kind) {
+            ++i;
+        } else {
+            int swap = order[i];
+            order[i] = order[j];
+            order[j--] = swap;
+        }
+    }
+    return (i < first + count) ? i : -1;
+}
+
+int bvh_build(Bvh* bvh, const Aabb* bounds, const unsigned char* kinds, const float* costs, int count, int* primitive_order) {
+    if (bvh == NULL || (count > 0 && (bounds == NULL || primitive_order == NULL))) {
+        fprintf(stderr, "Error: bvh_build received a NULL pointer.\n");
+        return -1;
+    }
+
+    bvh_free(bvh);
+    if (count <= 0) {
+        return 0;
+    }
+
+    // A binary tree with at most one primitive per leaf has 2n - 1 nodes
+    bvh->nodes = (BvhNode*)malloc((size_t)(2 * count - 1) * sizeof(BvhNode));
+    Vector3* centroids = (Vector3*)malloc((size_t)count * sizeof(Vector3));
+    BvhBuildTask* stack = (BvhBuildTask*)malloc(BVH_MAX_DEPTH * 2 * sizeof(BvhBuildTask));
+    if (bvh->nodes == NULL || centroids == NULL || stack == NULL) {
+        fprintf(stderr, "Error: failed to allocate BVH build memory for %d primitives.\n", count);
+        free(centroids);
+        free(stack);
+        bvh_free(bvh);
+        return -1;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        centroids[i] = vector3_scale(vector3_add(bounds[i].min, bounds[i].max), 0.5f);
+        primitive_order[i] = i;
+    }
+
+    bvh->primitive_count = count;
+    bvh->node_count = 1;
+
+    int stack_size = 0;
+    BvhBuildTask root = { 0, 0, count, 0 };
+    stack[stack_size++] = root;
+
+    while (stack_size > 0) {
+        BvhBuildTask task = stack[--stack_size];
+        BvhNode* node = &bvh->nodes[task.node];
+
+        Aabb node_bounds = aabb_empty();
+        for (int i = task.first; i < task.first + task.count; ++i) {
+            node_bounds = aabb_union(node_bounds, bounds[primitive_order[i]]);
+        }
+        node->bounds_min = node_bounds.min;
+        node->bounds_max = node_bounds.max;
+        node->left_first = task.first;
+        node->primitive_count = task.count;
+
+        // Kind splits may use the levels reserved below the SAH depth limit
+        int middle = (task.depth < BVH_MAX_DEPTH - BVH_MAX_KINDS)
+            ? bvh_split_range(bounds, centroids, costs, primitive_order, task.first, task.count, node_bounds)
+            : -1;
+        if (middle < 0 && kinds != NULL && task.depth < BVH_MAX_DEPTH - 1) {
+            middle = bvh_split_kinds(kinds, primitive_order, task.first, task.count);
+        }
+        if (middle < 0) {
+            continue; // Leaf
+        }
+
+        const int left = bvh->node_count;
+        bvh->node_count += 2;
+        node->left_first = left;
+        node->primitive_count = 0;
+
+        BvhBuildTask right_task = { left + 1, middle, task.first + task.count - middle, task.depth + 1 };
+        BvhBuildTask left_task = { left, task.first, middle - task.first, task.depth + 1 };
+        stack[stack_size++] = right_task;
+        stack[stack_size++] = left_task;
+    }
+
+    free(stack);
+    free(centroids);
+
+    // Give back the slack of the worst-case allocation
+    BvhNode* shrunk = (BvhNode*)realloc(bvh->nodes, (size_t)bvh->node_count * sizeof(BvhNode));
+    if (shrunk != NULL) {
+        bvh->nodes = shrunk;
+    }
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+
+#include "../vector/vector.h"
+
+#ifndef _BVH_H_
+#define _BVH_H_
+
+#define BVH_MAX_LEAF_SIZE 16  ///< Leaves are split further once they hold more primitives than this (if SAH agrees).
+#define BVH_PRIMITIVE_COST 0.125f ///< SAH cost of a sphere or triangle, tested several per SIMD step, in node visits.
+#define BVH_MAX_DEPTH 64      ///< Hard depth limit; also the traversal stack size.
+#define BVH_BIN_COUNT 12      ///< Number of centroid bins evaluated per axis by the SAH builder.
+#define BVH_MAX_KINDS 5       ///< Primitive kinds bvh_build keeps apart; SAH splitting stops this many levels above BVH_MAX_DEPTH.
+#define BVH_REBUILD_INFLATION 2.0f ///< Refitted trees should be rebuilt once their nodes have grown by this factor on average.
+
+/**
+ * @brief Axis-aligned bounding box.
+ */
+typedef struct Aabb {
+    Vector3 min;
+    Vector3 max;
+} Aabb;
+
+/**
+ * @brief Flattened BVH node, 32 bytes so two siblings share a cache line.
+ * Siblings are stored next to each other: the right child of an internal
+ * node is always left_first + 1.
+ */
+typedef struct BvhNode {
+    Vector3 bounds_min;
+    int left_first;        ///< Internal node: index of the left child. Leaf: index of the first primitive.
+    Vector3 bounds_max;
+    int primitive_count;   ///< 0 for internal nodes, number of primitives for leaves.
+} BvhNode;
+
+/**
+ * @brief Bounding volume hierarchy over an array of primitives.
+ * Leaves reference contiguous primitive ranges; bvh_build reports the
+ * primitive order those ranges refer to so the caller can reorder its data.
+ */
+typedef struct Bvh {
+    BvhNode* nodes;        ///< nodes[0] is the root.
+    int node_count;
+    int primitive_count;
+    int external;          ///< Nodes are owned elsewhere (e.g. a mapped scene file) and are not freed.
+
+    // Refit bookkeeping, allocated by the first bvh_mark_primitive and always owned
+    int* parents;          ///< Parent of every node, -1 for the root.
+    int* primitive_leaves; ///< Leaf holding every primitive.
+    int* marked_leaves;    ///< Leaves whose primitives moved since the last bvh_refit.
+    int marked_count;
+    unsigned char* marked; ///< Per node: already listed in marked_leaves.
+    float* built_areas;    ///< Half area of every node before the first refit (0 counts as never growing).
+    double inflation_sum;  ///< Sum over nodes of current over built area, updated by bvh_refit.
+} Bvh;
+
+/**
+ * @brief Returns the bounding box of one primitive, in the primitive order of the hierarchy.
+ */
+typedef Aabb (*BvhBoundsFunction)(const void* context, int primitive);
+
+// Initializes an empty hierarchy
+void bvh_init(Bvh* bvh);
+
+/**
+ * @brief Builds the hierarchy with a binned surface area heuristic.
+ * When kinds are given, a range that would become a leaf holding several kinds is split by kind
+ * instead, so every leaf can be handed to a single intersection kernel.
+ * @param bvh Pointer to the Bvh to (re)build.
+ * @param bounds Bounding box of every primitive.
+ * @param kinds Kind of every primitive (at most BVH_MAX_KINDS distinct values), or NULL if leaves may mix them.
+ * @param costs SAH cost of testing every primitive in node visits, or NULL when all cost BVH_PRIMITIVE_COST.
+ * @param count Number of primitives.
+ * @param primitive_order Output, count entries: leaf primitive i is the caller's primitive primitive_order[i].
+ * @return 0 on success, -1 on failure.
+ */
+int bvh_build(Bvh* bvh, const Aabb* bounds, const unsigned char* kinds, const float* costs, int count, int* primitive_order);
+
+// Points an empty hierarchy at node_count nodes owned by the caller, without copying
+int bvh_attach(Bvh* bvh, BvhNode* nodes, int node_count, int primitive_count);
+
+/**
+ * @brief Records that a primitive moved so that bvh_refit updates its leaf.
+ * @param primitive Index in the hierarchy's primitive order (the order bvh_build reported).
+ * @return 0 on success, -1 on failure (out of range, or the bookkeeping could not be allocated).
+ */
+int bvh_mark_primitive(Bvh* bvh, int primitive);
+
+/**
+ * @brief Recomputes the bounds of the marked leaves and of their ancestors, bottom up.
+ * Each path stops at the first node whose bounds do not change, so the cost grows with the
+ * number of moved primitives rather than with the size of the tree. The topology is kept;
+ * check bvh_inflation to decide when a rebuild pays off.
+ * @param bounds Returns the current bounds of a primitive.
+ * @param context Passed through to bounds.
+ */
+void bvh_refit(Bvh* bvh, BvhBoundsFunction bounds, const void* context);
+
+// Mean ratio of each node's surface area to its area as built: 1 for a fresh tree, growing as refits loosen it.
+// Unlike the SAH cost of the whole tree, it is not masked by a few huge primitives near the root.
+float bvh_inflation(const Bvh* bvh);
+
+// Releases the nodes of the hierarchy
+void bvh_free(Bvh* bvh);
+
+// Returns the box enclosing both boxes
+Aabb aabb_union(Aabb a, Aabb b);
+
+// Returns half the surface area of a box (the constant factor cancels out in the SAH)
+float aabb_half_area(Aabb box);
+
+#endif
@@ -19,6 +19,7 @@ Camera camera_new(Vector3 position, float projection_plane_z, Canvas* canvas) {
     // results in a forward vector of (0, 0, -1) when pitch is 0.
     camera.yaw = M_PI_2; // Start looking down -Z
     camera.pitch = 0.0f;  // No initial vertical tilt
+    camera.generation = 0;
 
     // Initialize vectors. These will be updated by camera_update_vectors.
     // Call camera_update_vectors to set the initial forward, up, and right vectors.
@@ -44,12 +45,47 @@ void camera_update_vectors(Camera* camera) {
     // Calculate true Up vector as cross product of Right and Forward
     // This ensures Up is perpendicular to Forward and Right, forming an orthonormal basis.
     camera->up = vector3_normalize(vector3_cross(camera->right, camera->forward));
+
+    camera->generation++;
+}
+
+void camera_translate(Camera* camera, Vector3 offset) {
+    camera->position = vector3_add(camera->position, offset);
+    camera->generation++;
+}
+
+void camera_rotate(Camera* camera, float yaw_delta, float pitch_delta) {
+    camera->yaw += yaw_delta;
+    camera->pitch += pitch_delta;
+
+    // Clamp pitch to prevent camera flipping upside down (e.g., between -PI/2 and PI/2)
+    if (camera->pitch > M_PI_2 - 0.01f) camera->pitch = M_PI_2 - 0.01f;
+    if (camera->pitch < -M_PI_2 + 0.01f) camera->pitch = -M_PI_2 + 0.01f;
+
+    camera_update_vectors(camera); // Recalculate camera basis vectors
 }
 
 void camera_cleanup(Camera* camera) {
     (void)camera;
 }
 
+void camera_prepare(const Camera* camera, const Canvas* canvas, CameraFrame* frame) {
+    frame->origin = camera->position;
+    frame->plane_center = vector3_scale(camera->forward, camera->viewport.projection_plane_z);
+    frame->pixel_right = vector3_scale(camera->right, camera->viewport.width / (float)canvas->width);
+    frame->pixel_up = vector3_scale(camera->up, camera->viewport.height / (float)canvas->height);
+}
+
+Vector3 camera_frame_ray_direction(const CameraFrame* frame, int x, int y) {
+    const float fx = (float)x;
+    const float fy = (float)y;
+    return vector3_normalize(vector3_new(
+        frame->plane_center.x + fx * frame->pixel_right.x + fy * frame->pixel_up.x,
+        frame->plane_center.y + fx * frame->pixel_right.y + fy * frame->pixel_up.y,
+        frame->plane_center.z + fx * frame->pixel_right.z + fy * frame->pixel_up.z
+    ));
+}
+
 Vector3 canvas_to_viewport(const Camera* camera, const Canvas* canvas, int x, int y) {
     if (camera == NULL || canvas->width <= 0 || canvas->height <= 0) {
         return vector3_new(0.0f, 0.0f, 0.0f);
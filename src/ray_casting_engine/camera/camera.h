@@ -34,8 +34,20 @@ typedef struct Camera {
     float pitch;               // Rotation around the camera's local X-axis (radians)
 
     ViewPort viewport;         // Camera's viewport properties
+
+    unsigned int generation;   // Incremented on every change of position or orientation
 } Camera;
 
+// Per-frame primary ray terms baked from a Camera and Canvas by camera_prepare.
+// The direction through viewport pixel (x, y) is normalize(plane_center + x * pixel_right + y * pixel_up),
+// which replaces the per-pixel canvas_to_viewport divisions and basis transform.
+typedef struct CameraFrame {
+    Vector3 origin;            // Shared origin of all primary rays
+    Vector3 plane_center;      // forward * projection_plane_z
+    Vector3 pixel_right;       // World-space step of one pixel to the right on the projection plane
+    Vector3 pixel_up;          // World-space step of one pixel up on the projection plane
+} CameraFrame;
+
 // Creates a new Camera instance
 // position: 3D position of the camera
 // projection_plane_z: Distance to projection plane (recommended: 1.0)
@@ -45,9 +57,21 @@ Camera camera_new(Vector3 position, float projection_plane_z, Canvas* canvas);
 // Updates the camera's forward, up, and right vectors based on its yaw and pitch angles.
 void camera_update_vectors(Camera* camera);
 
+// Moves the camera by a world-space offset
+void camera_translate(Camera* camera, Vector3 offset);
+
+// Turns the camera by the given yaw and pitch deltas (radians); pitch is clamped short of straight up/down
+void camera_rotate(Camera* camera, float yaw_delta, float pitch_delta);
+
 // Cleans up camera resources (currently placeholder)
 void camera_cleanup(Camera* camera);
 
+// Bakes the primary ray terms of the current camera pose for a canvas
+void camera_prepare(const Camera* camera, const Canvas* canvas, CameraFrame* frame);
+
+// Unit direction of the primary ray through a viewport pixel (origin at the canvas center, y up)
+Vector3 camera_frame_ray_direction(const CameraFrame* frame, int x, int y);
+
 // Converts 2D canvas coordinates to 3D viewport coordinates in camera's LOCAL space.
 Vector3 canvas_to_viewport(const Camera* camera, const Canvas* canvas, int x, int y);
 
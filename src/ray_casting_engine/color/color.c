@@ -7,3 +7,10 @@ Color color_new(unsigned char r, unsigned char g, unsigned char b) {
     c.b = b;
     return c;
 }
+
+unsigned int color_to_argb8888(const Color* color) {
+    return 0xFF000000u
+        | ((unsigned int)(unsigned char)color->r << 16)
+        | ((unsigned int)(unsigned char)color->g << 8)
+        | (unsigned int)(unsigned char)color->b;
+}
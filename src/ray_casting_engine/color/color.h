@@ -14,4 +14,7 @@ typedef struct Color {
 
 Color color_new(unsigned char r, unsigned char g, unsigned char b);
 
+// Packs a color into a single ARGB8888 value (alpha is always opaque)
+unsigned int color_to_argb8888(const Color* color);
+
 #endif
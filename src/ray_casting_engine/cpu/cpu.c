@@ -0,0 +1,64 @@
+#include "./cpu.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define CPU_X86 1
+#else
+#define CPU_X86 0
+#endif
+
+#define CPU_XCR0_AVX 0x06u      // XMM and YMM state
+#define CPU_XCR0_AVX512 0xE6u   // Plus opmask, upper halves of ZMM0-15 and ZMM16-31
+
+static const char* const cpu_level_names[CPU_LEVEL_COUNT] = { "scalar", "sse", "avx2", "avx512" };
+
+#if CPU_X86
+// Extended control register 0: the register state the OS saves on context switches.
+// Only valid when CPUID reports OSXSAVE.
+static unsigned long long cpu_xgetbv(void) {
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+}
+#endif
+
+CpuLevel cpu_detect_level(void) {
+#if CPU_X86
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_2)) {
+        return CPU_LEVEL_SCALAR;
+    }
+
+    // AVX registers are only usable when the OS saves them
+    if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return CPU_LEVEL_SSE;
+    }
+    const unsigned long long xcr0 = cpu_xgetbv();
+    if ((xcr0 & CPU_XCR0_AVX) != CPU_XCR0_AVX || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & bit_AVX2)) {
+        return CPU_LEVEL_SSE;
+    }
+
+    if ((ebx & bit_AVX512F) && (xcr0 & CPU_XCR0_AVX512) == CPU_XCR0_AVX512) {
+        return CPU_LEVEL_AVX512;
+    }
+    return CPU_LEVEL_AVX2;
+#else
+    return CPU_LEVEL_SCALAR;
+#endif
+}
+
+int cpu_parse_level(const char* name, CpuLevel* level) {
+    for (int i = 0; i < CPU_LEVEL_COUNT; ++i) {
+        if (strcmp(name, cpu_level_names[i]) == 0) {
+            *level = (CpuLevel)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* cpu_level_name(CpuLevel level) {
+    return ((unsigned int)level < CPU_LEVEL_COUNT) ? cpu_level_names[level] : "unknown";
+}
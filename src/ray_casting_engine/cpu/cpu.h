@@ -0,0 +1,25 @@
+#pragma once
+
+#ifndef _CPU_H_
+#define _CPU_H_
+
+// Instruction set levels the SIMD kernels are built for, in increasing order
+typedef enum CpuLevel {
+    CPU_LEVEL_SCALAR,      // Plain C, any CPU
+    CPU_LEVEL_SSE,         // SSE4.2
+    CPU_LEVEL_AVX2,        // AVX2
+    CPU_LEVEL_AVX512,      // AVX-512F
+    CPU_LEVEL_COUNT
+} CpuLevel;
+
+// Highest level this CPU supports and the OS saves the registers of, from CPUID and XGETBV.
+// Always CPU_LEVEL_SCALAR on other architectures.
+CpuLevel cpu_detect_level(void);
+
+// Parses "scalar", "sse", "avx2" or "avx512". Returns 0 on success, -1 for unknown names.
+int cpu_parse_level(const char* name, CpuLevel* level);
+
+// Returns the name parsed by cpu_parse_level, or "unknown" for invalid levels
+const char* cpu_level_name(CpuLevel level);
+
+#endif
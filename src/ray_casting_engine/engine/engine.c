@@ -1,9 +1,85 @@
 #include "./engine.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h> // SIMD packet and box kernels
+#endif
+
 #define EPSILON 0.05f
+#define ENGINE_NODE_EXIT_SCALE 1.0000008f // 1 + 2 * gamma(3), the bound on the rounding error of a slab distance
+
+/**
+ * @brief Rays traced by the current thread since its last flush into Engine.ray_counts.
+ * Thread-local so the hot path never touches shared cache lines.
+ */
+typedef struct EngineLocalRayCounts {
+    int primary;
+    int shadow;
+    int reflection;
+} EngineLocalRayCounts;
+
+static _Thread_local EngineLocalRayCounts engine_local_ray_counts;
 
-// Assuming canvas_to_viewport, vector3_add, vector3_scale, vector3_subtract,
-// vector3_normalize, vector3_dot, color_new are defined in their respective headers.
+#if ENGINE_STATS
+_Thread_local EngineStats engine_thread_stats;
+
+// Recursion level of the ray currently being shaded by this thread
+static _Thread_local int engine_stats_level;
+#endif
+
+/**
+ * @brief Read-only description of one frame, shared by all tile workers.
+ */
+typedef struct RenderJob {
+    Engine* engine;
+    CameraFrame camera;     ///< Primary ray terms of the frame's camera.
+    const PreparedScene* scene;
+    const Canvas* canvas;
+    int tiles_x;            ///< Number of tile columns.
+    int tiles_y;            ///< Number of tile rows.
+    int first_tile;         ///< Row-major index of the job's first tile.
+    int stride;             ///< Edge length of the pixel blocks sharing one primary ray.
+    int refine;             ///< Skip the samples the previous pass (at twice the stride) already traced.
+    Reprojection* reprojection; ///< History to reuse pixels from, or NULL to trace every pixel.
+} RenderJob;
+
+// Reflection bounces of the recursive paths, which recurse through engine_trace_ray once per bounce
+static int engine_recursive_depth(const Engine* engine) {
+    const int depth = engine->settings.recursion_depth;
+    return (depth < ENGINE_MAX_RECURSIVE_DEPTH) ? depth : ENGINE_MAX_RECURSIVE_DEPTH;
+}
+
+// Reciprocal of a direction component that never divides by zero
+static float engine_safe_inverse(float component) {
+    const float tiny = 1e-20f;
+    return 1.0f / ((fabsf(component) > tiny) ? component : copysignf(tiny, component));
+}
+
+// Minimum and maximum of operands that are never NaN, such as slab distances with a safe inverse.
+// fminf and fmaxf must also handle NaN and stay library calls without -ffast-math; these compile to minss and maxss.
+static inline float engine_min(float a, float b) {
+    return (a < b) ? a : b;
+}
+
+static inline float engine_max(float a, float b) {
+    return (a > b) ? a : b;
+}
+
+/**
+ * @brief Returns the settings a freshly initialized engine renders with.
+ */
+EngineSettings engine_default_settings(void) {
+    EngineSettings settings;
+    settings.recursion_depth = ENGINE_DEFAULT_RECURSION_DEPTH;
+    settings.use_packets = 1;
+    settings.use_wavefront = 0;
+    settings.use_adaptive = 0;
+    settings.adaptive_tolerance = ENGINE_DEFAULT_ADAPTIVE_TOLERANCE;
+    settings.use_reprojection = 0;
+    return settings;
+}
 
 /**
  * @brief Initializes the rendering engine.
@@ -18,68 +94,1033 @@ int engine_init(Engine* engine, SDL_Window* window, Canvas* canvas) {
         return 1;
     }
 
-    engine->renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-    if (!engine->renderer) {
-        fprintf(stderr, "Renderer creation failed: %s\n", SDL_GetError());
-        // No need to destroy window/quit SDL here, it should be handled by the caller
-        return 1;
-    }
+    engine->settings = engine_default_settings();
+    engine->wavefronts = NULL;
+    engine->wavefront_count = 0;
+    scene_prepared_init(&engine->prepared_scene);
+    reprojection_init(&engine->reprojection);
+
+    engine->cpu_level = cpu_detect_level();
+    engine->kernels = kernels_for_level(engine->cpu_level);
+
+    // Start single-threaded; engine_set_thread_count can widen the pool afterwards
+    if (thread_pool_init(&engine->thread_pool, 1) != 0) {
+        return 1;
+    }
+
+    return render_target_init_sdl(&engine->target, window, canvas);
+}
+
+/**
+ * @brief Initializes the rendering engine with an in-memory framebuffer only.
+ * Does not require the SDL video subsystem, so it works on display-less machines.
+ * @param engine Pointer to the Engine struct to initialize.
+ * @param canvas Pointer to the Canvas struct.
+ * @return 0 on success, 1 on failure.
+ */
+int engine_init_offscreen(Engine* engine, Canvas* canvas) {
+    if (!engine || !canvas) {
+        fprintf(stderr, "Error: NULL pointer passed to engine_init_offscreen.\n");
+        return 1;
+    }
+
+    engine->settings = engine_default_settings();
+    engine->wavefronts = NULL;
+    engine->wavefront_count = 0;
+    scene_prepared_init(&engine->prepared_scene);
+    reprojection_init(&engine->reprojection);
+    engine->cpu_level = cpu_detect_level();
+    engine->kernels = kernels_for_level(engine->cpu_level);
+
+    if (thread_pool_init(&engine->thread_pool, 1) != 0) {
+        return 1;
+    }
+
+    return render_target_init_offscreen(&engine->target, canvas);
+}
+
+/**
+ * @brief Forces the SIMD kernels of an instruction set level instead of the one detected by engine_init.
+ * Takes effect from the next frame this engine renders.
+ * @param engine Pointer to the Engine struct.
+ * @param level Level to use; must not exceed what cpu_detect_level reports.
+ * @return 0 on success, 1 if the CPU does not support the level (the kernels are left unchanged).
+ */
+int engine_set_cpu_level(Engine* engine, CpuLevel level) {
+    if (!engine) {
+        fprintf(stderr, "Error: NULL engine passed to engine_set_cpu_level.\n");
+        return 1;
+    }
+
+    const CpuLevel supported = cpu_detect_level();
+    if ((unsigned int)level > (unsigned int)supported) {
+        fprintf(stderr, "Error: This CPU does not support %s kernels (the highest level is %s).\n",
+                cpu_level_name(level), cpu_level_name(supported));
+        return 1;
+    }
+
+    engine->cpu_level = level;
+    engine->kernels = kernels_for_level(level);
+    return 0;
+}
+
+/**
+ * @brief Sets how many threads trace each frame.
+ * @param engine Pointer to the Engine struct.
+ * @param thread_count Number of worker threads including the caller; 0 selects one per logical CPU.
+ * @return 0 on success, 1 on failure (the engine then falls back to a single thread).
+ */
+int engine_set_thread_count(Engine* engine, int thread_count) {
+    if (!engine) {
+        fprintf(stderr, "Error: NULL engine passed to engine_set_thread_count.\n");
+        return 1;
+    }
+
+    if (thread_count <= 0) {
+        thread_count = thread_pool_default_worker_count();
+    }
+    if (thread_count == engine->thread_pool.worker_count) {
+        return 0;
+    }
+
+    thread_pool_clean_up(&engine->thread_pool);
+    if (thread_pool_init(&engine->thread_pool, thread_count) != 0) {
+        fprintf(stderr, "Failed to start %d render threads, falling back to one.\n", thread_count);
+        thread_pool_init(&engine->thread_pool, 1);
+        return 1;
+    }
+
+    return 0;
+}
+
+#if defined(__SSE2__)
+
+// Smallest of the four lanes
+static float engine_horizontal_min(__m128 values) {
+    values = _mm_min_ps(values, _mm_shuffle_ps(values, values, _MM_SHUFFLE(2, 3, 0, 1)));
+    values = _mm_min_ps(values, _mm_shuffle_ps(values, values, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(values);
+}
+
+/**
+ * @brief Slab test of all packet rays against one BVH node.
+ * @return Per-lane entry distance, FLT_MAX in lanes that miss or cannot beat their closest hit.
+ */
+static __m128 engine_packet_node_entry(const BvhNode* node, const RayPacket* packet, __m128 inverse_x, __m128 inverse_y, __m128 inverse_z,
+                                       __m128 t_min, __m128 closest_t) {
+    ENGINE_STATS_ADD(node_tests, ENGINE_PACKET_SIZE);
+
+    const __m128 tx1 = _mm_mul_ps(_mm_set1_ps(node->bounds_min.x - packet->origin.x), inverse_x);
+    const __m128 tx2 = _mm_mul_ps(_mm_set1_ps(node->bounds_max.x - packet->origin.x), inverse_x);
+    const __m128 ty1 = _mm_mul_ps(_mm_set1_ps(node->bounds_min.y - packet->origin.y), inverse_y);
+    const __m128 ty2 = _mm_mul_ps(_mm_set1_ps(node->bounds_max.y - packet->origin.y), inverse_y);
+    const __m128 tz1 = _mm_mul_ps(_mm_set1_ps(node->bounds_min.z - packet->origin.z), inverse_z);
+    const __m128 tz2 = _mm_mul_ps(_mm_set1_ps(node->bounds_max.z - packet->origin.z), inverse_z);
+
+    const __m128 t_near = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx1, tx2), _mm_min_ps(ty1, ty2)), _mm_min_ps(tz1, tz2));
+    const __m128 t_far = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2)), _mm_max_ps(tz1, tz2));
+
+    const __m128 hit = _mm_and_ps(_mm_cmpge_ps(t_far, t_near),
+                       _mm_and_ps(_mm_cmpgt_ps(t_far, t_min), _mm_cmplt_ps(t_near, closest_t)));
+    return _mm_or_ps(_mm_and_ps(hit, t_near), _mm_andnot_ps(hit, _mm_set1_ps(FLT_MAX)));
+}
+
+// Keeps the lanes of t selected by hit as the packet's new closest hits on object index
+static inline void engine_packet_keep(__m128 hit, __m128 t, int index, __m128* closest_t, __m128i* closest_index) {
+    const __m128i hit_mask = _mm_castps_si128(hit);
+    *closest_t = _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, *closest_t));
+    *closest_index = _mm_or_si128(_mm_and_si128(hit_mask, _mm_set1_epi32(index)), _mm_andnot_si128(hit_mask, *closest_index));
+}
+
+// Packet against a range of spheres. Because all rays start at the same origin,
+// the c coefficient is computed once per sphere instead of once per ray.
+static void engine_packet_spheres(const SphereSoA* spheres, int first, int count, const RayPacket* packet,
+                                  __m128 dx, __m128 dy, __m128 dz, __m128 t_min, __m128* closest_t, __m128i* closest_index) {
+    const __m128 zero = _mm_setzero_ps();
+
+    ENGINE_STATS_ADD(sphere_tests, (long long)count * ENGINE_PACKET_SIZE);
+    for (int i = first; i < first + count; ++i) {
+        const float lx = packet->origin.x - spheres->center_x[i];
+        const float ly = packet->origin.y - spheres->center_y[i];
+        const float lz = packet->origin.z - spheres->center_z[i];
+        const __m128 c = _mm_set1_ps(lx * lx + ly * ly + lz * lz - spheres->radius_sq[i]);
+
+        const __m128 half_b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(lx), dx), _mm_mul_ps(_mm_set1_ps(ly), dy)), _mm_mul_ps(_mm_set1_ps(lz), dz));
+        const __m128 discriminant = _mm_sub_ps(_mm_mul_ps(half_b, half_b), c);
+        const __m128 real = _mm_cmpge_ps(discriminant, zero);
+
+        const __m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+        const __m128 near_root = _mm_sub_ps(_mm_sub_ps(zero, half_b), root);
+        const __m128 far_root = _mm_add_ps(_mm_sub_ps(zero, half_b), root);
+
+        const __m128 near_ok = _mm_and_ps(_mm_cmpgt_ps(near_root, t_min), _mm_cmplt_ps(near_root, *closest_t));
+        const __m128 t = _mm_or_ps(_mm_and_ps(near_ok, near_root), _mm_andnot_ps(near_ok, far_root));
+        const __m128 hit = _mm_and_ps(real, _mm_and_ps(_mm_cmpgt_ps(t, t_min), _mm_cmplt_ps(t, *closest_t)));
+        engine_packet_keep(hit, t, i, closest_t, closest_index);
+    }
+}
+
+// Packet against a range of cubes and cuboids: the node slab test, keeping the exit distance for rays starting inside
+static void engine_packet_boxes(const Object* objects, int first, int count, const RayPacket* packet,
+                                __m128 inverse_x, __m128 inverse_y, __m128 inverse_z, __m128 t_min, __m128* closest_t, __m128i* closest_index) {
+    ENGINE_STATS_ADD(box_tests, (long long)count * ENGINE_PACKET_SIZE);
+    for (int i = first; i < first + count; ++i) {
+        const Vector3 center = vector3_subtract(objects[i].position, packet->origin);
+        const Vector3 half = objects[i].data.boxData.half_extents;
+
+        const __m128 tx1 = _mm_mul_ps(_mm_set1_ps(center.x - half.x), inverse_x);
+        const __m128 tx2 = _mm_mul_ps(_mm_set1_ps(center.x + half.x), inverse_x);
+        const __m128 ty1 = _mm_mul_ps(_mm_set1_ps(center.y - half.y), inverse_y);
+        const __m128 ty2 = _mm_mul_ps(_mm_set1_ps(center.y + half.y), inverse_y);
+        const __m128 tz1 = _mm_mul_ps(_mm_set1_ps(center.z - half.z), inverse_z);
+        const __m128 tz2 = _mm_mul_ps(_mm_set1_ps(center.z + half.z), inverse_z);
+
+        const __m128 t_near = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx1, tx2), _mm_min_ps(ty1, ty2)), _mm_min_ps(tz1, tz2));
+        const __m128 t_far = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2)), _mm_max_ps(tz1, tz2));
+
+        const __m128 near_ok = _mm_cmpgt_ps(t_near, t_min);
+        const __m128 t = _mm_or_ps(_mm_and_ps(near_ok, t_near), _mm_andnot_ps(near_ok, t_far));
+        const __m128 hit = _mm_and_ps(_mm_cmpge_ps(t_far, t_near), _mm_and_ps(_mm_cmpgt_ps(t, t_min), _mm_cmplt_ps(t, *closest_t)));
+        engine_packet_keep(hit, t, i, closest_t, closest_index);
+    }
+}
+
+// Packet against a range of planes; the distance from the shared origin to each plane is computed once
+static void engine_packet_planes(const Object* objects, int first, int count, const RayPacket* packet,
+                                 __m128 dx, __m128 dy, __m128 dz, __m128 t_min, __m128* closest_t, __m128i* closest_index) {
+    ENGINE_STATS_ADD(plane_tests, (long long)count * ENGINE_PACKET_SIZE);
+    for (int i = first; i < first + count; ++i) {
+        const Vector3 normal = objects[i].data.planeData.normal;
+        const __m128 distance = _mm_set1_ps(vector3_dot(normal, vector3_subtract(objects[i].position, packet->origin)));
+        const __m128 denominator = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(normal.x), dx), _mm_mul_ps(_mm_set1_ps(normal.y), dy)),
+                                              _mm_mul_ps(_mm_set1_ps(normal.z), dz));
+
+        // Parallel rays divide by zero; the comparisons reject the resulting infinities and NaNs
+        const __m128 t = _mm_div_ps(distance, denominator);
+        const __m128 hit = _mm_and_ps(_mm_cmpgt_ps(t, t_min), _mm_cmplt_ps(t, *closest_t));
+        engine_packet_keep(hit, t, i, closest_t, closest_index);
+    }
+}
+
+// Single-ray instance kernel, defined with the other single-ray kernels below
+static int engine_intersect_instances(const PreparedScene* scene, int first, int count, Vector3 ray_origin, Vector3 ray_direction,
+                                      Vector3 inverse_direction, float t_min, float t_max, float* closest_t, int* primitive, int any_hit);
+
+// Packet against a range of mesh or sphere set instances. The rays of a packet spread over many small
+// nodes of the shared geometry, so every lane walks the instance hierarchies on its own with the single-ray kernel.
+static void engine_packet_instances(const PreparedScene* scene, int first, int count, const RayPacket* packet,
+                                    const float inverse_values[3][ENGINE_PACKET_SIZE], float t_min,
+                                    __m128* closest_t, __m128i* closest_index, int primitives[ENGINE_PACKET_SIZE]) {
+    float closest_values[ENGINE_PACKET_SIZE];
+    int index_values[ENGINE_PACKET_SIZE];
+    _mm_storeu_ps(closest_values, *closest_t);
+    _mm_storeu_si128((__m128i*)index_values, *closest_index);
+
+    for (int lane = 0; lane < ENGINE_PACKET_SIZE; ++lane) {
+        const Vector3 direction = vector3_new(packet->direction_x[lane], packet->direction_y[lane], packet->direction_z[lane]);
+        const Vector3 inverse = vector3_new(inverse_values[0][lane], inverse_values[1][lane], inverse_values[2][lane]);
+        const int hit = engine_intersect_instances(scene, first, count, packet->origin, direction, inverse, t_min, FLT_MAX,
+                                                   &closest_values[lane], &primitives[lane], 0);
+        if (hit >= 0) {
+            index_values[lane] = hit;
+        }
+    }
+
+    *closest_t = _mm_loadu_ps(closest_values);
+    *closest_index = _mm_loadu_si128((const __m128i*)index_values);
+}
+
+/**
+ * @brief Finds the nearest hit of every ray in a packet.
+ * The packet first tests the planes, then shares one BVH walk: a subtree is
+ * entered when any ray can hit something closer inside it. Every leaf goes to
+ * the packet kernel of its object type.
+ * @param hits Output, one nearest hit per packet ray.
+ */
+static void engine_intersect_packet(const PreparedScene* scene, const RayPacket* packet, float t_min_value, ClosestIntersection hits[ENGINE_PACKET_SIZE]) {
+    const ObjectList* objects = scene->objects;
+    const SphereSoA* spheres = &objects->spheres;
+    const Bvh* bvh = scene->bvh;
+
+    const __m128 dx = _mm_loadu_ps(packet->direction_x);
+    const __m128 dy = _mm_loadu_ps(packet->direction_y);
+    const __m128 dz = _mm_loadu_ps(packet->direction_z);
+    const __m128 t_min = _mm_set1_ps(t_min_value);
+    const __m128 zero = _mm_setzero_ps();
+
+    float inverse_values[3][ENGINE_PACKET_SIZE];
+    for (int lane = 0; lane < ENGINE_PACKET_SIZE; ++lane) {
+        inverse_values[0][lane] = engine_safe_inverse(packet->direction_x[lane]);
+        inverse_values[1][lane] = engine_safe_inverse(packet->direction_y[lane]);
+        inverse_values[2][lane] = engine_safe_inverse(packet->direction_z[lane]);
+    }
+    const __m128 inverse_x = _mm_loadu_ps(inverse_values[0]);
+    const __m128 inverse_y = _mm_loadu_ps(inverse_values[1]);
+    const __m128 inverse_z = _mm_loadu_ps(inverse_values[2]);
+
+    __m128 closest_t = _mm_set1_ps(FLT_MAX);
+    __m128i closest_index = _mm_set1_epi32(-1);
+    int primitives[ENGINE_PACKET_SIZE] = { -1, -1, -1, -1 };
+
+    // Pending subtrees with the smallest entry distance over the packet
+    int stack_nodes[BVH_MAX_DEPTH];
+    float stack_entries[BVH_MAX_DEPTH];
+    int stack_size = 0;
+
+    int node_index = 0;
+    int first = 0;
+    int count = objects->count;
+
+    if (bvh->node_count > 0) {
+        engine_packet_planes(objects->objects, scene->plane_first, scene->plane_count, packet, dx, dy, dz, t_min, &closest_t, &closest_index);
+        const __m128 root_entry = engine_packet_node_entry(&bvh->nodes[0], packet, inverse_x, inverse_y, inverse_z, t_min, closest_t);
+        node_index = (engine_horizontal_min(root_entry) == FLT_MAX) ? -1 : 0;
+    }
+
+    while (node_index >= 0) {
+        if (bvh->node_count > 0) {
+            const BvhNode* node = &bvh->nodes[node_index];
+            first = node->left_first;
+            count = node->primitive_count;
+
+            if (count == 0) {
+                int near_child = node->left_first;
+                int far_child = node->left_first + 1;
+                float near_entry = engine_horizontal_min(engine_packet_node_entry(&bvh->nodes[near_child], packet, inverse_x, inverse_y, inverse_z, t_min, closest_t));
+                float far_entry = engine_horizontal_min(engine_packet_node_entry(&bvh->nodes[far_child], packet, inverse_x, inverse_y, inverse_z, t_min, closest_t));
+
+                if (far_entry < near_entry) {
+                    int swap_child = near_child; near_child = far_child; far_child = swap_child;
+                    float swap_entry = near_entry; near_entry = far_entry; far_entry = swap_entry;
+                }
+
+                if (near_entry != FLT_MAX) {
+                    if (far_entry != FLT_MAX) {
+                        stack_nodes[stack_size] = far_child;
+                        stack_entries[stack_size] = far_entry;
+                        stack_size++;
+                    }
+                    node_index = near_child;
+                    continue;
+                }
+            }
+        }
+
+        // Leaf (or the whole list without a BVH), one run of equal types at a time
+        const int end = first + count;
+        while (first < end) {
+            int run_end = first + 1;
+            if (bvh->node_count == 0) {
+                while (run_end < end && objects->objects[run_end].type == objects->objects[first].type) {
+                    ++run_end;
+                }
+            } else {
+                run_end = end;   // Leaves hold a single type
+            }
+
+            switch (objects->objects[first].type) {
+                case OBJECT_TYPE_SPHERE:
+                    engine_packet_spheres(spheres, first, run_end - first, packet, dx, dy, dz, t_min, &closest_t, &closest_index);
+                    break;
+                case OBJECT_TYPE_CUBE:
+                case OBJECT_TYPE_CUBOID:
+                    engine_packet_boxes(objects->objects, first, run_end - first, packet, inverse_x, inverse_y, inverse_z, t_min, &closest_t, &closest_index);
+                    break;
+                case OBJECT_TYPE_PLANE:
+                    engine_packet_planes(objects->objects, first, run_end - first, packet, dx, dy, dz, t_min, &closest_t, &closest_index);
+                    break;
+                case OBJECT_TYPE_MESH:
+                case OBJECT_TYPE_SPHERE_SET:
+                    engine_packet_instances(scene, first, run_end - first, packet, (const float (*)[ENGINE_PACKET_SIZE])inverse_values, t_min_value,
+                                            &closest_t, &closest_index, primitives);
+                    break;
+            }
+            first = run_end;
+        }
+
+        if (bvh->node_count == 0) {
+            break;
+        }
+
+        // Resume with the nearest pending subtree that can still improve some ray
+        const float farthest_closest = -engine_horizontal_min(_mm_sub_ps(zero, closest_t));
+        node_index = -1;
+        while (stack_size > 0) {
+            stack_size--;
+            if (stack_entries[stack_size] < farthest_closest) {
+                node_index = stack_nodes[stack_size];
+                break;
+            }
+        }
+    }
+
+    float closest_values[ENGINE_PACKET_SIZE];
+    int index_values[ENGINE_PACKET_SIZE];
+    _mm_storeu_ps(closest_values, closest_t);
+    _mm_storeu_si128((__m128i*)index_values, closest_index);
+
+    for (int lane = 0; lane < ENGINE_PACKET_SIZE; ++lane) {
+        hits[lane].closest_object = (index_values[lane] >= 0) ? &objects->objects[index_values[lane]] : NULL;
+        hits[lane].closest_t = closest_values[lane];
+        hits[lane].primitive = primitives[lane];
+    }
+}
+
+#endif // __SSE2__
+
+/**
+ * @brief Traces a 2x2 pixel block as one primary ray packet.
+ * The nearest hits are found together; shading and any reflection bounces,
+ * which diverge quickly, continue as single rays.
+ * @param row0 Framebuffer row of the upper two pixels; row1 is the row below.
+ * @param sdl_x Framebuffer column of the left pixels.
+ * @param pixel_x Viewport x of the left pixels.
+ * @param pixel_y Viewport y of the upper pixels.
+ */
+static void engine_trace_packet(const RenderJob* job, unsigned int* row0, unsigned int* row1, int sdl_x, int pixel_x, int pixel_y) {
+    const int recursion_depth = engine_recursive_depth(job->engine);
+
+    RayPacket packet;
+    packet.origin = job->camera.origin;
+    for (int lane = 0; lane < ENGINE_PACKET_SIZE; ++lane) {
+        // Lanes 0,1 are the upper pixels, 2,3 the lower ones
+        Vector3 direction = camera_frame_ray_direction(&job->camera, pixel_x + (lane & 1), pixel_y - (lane >> 1));
+        packet.direction_x[lane] = direction.x;
+        packet.direction_y[lane] = direction.y;
+        packet.direction_z[lane] = direction.z;
+    }
+
+    Color colors[ENGINE_PACKET_SIZE];
+    engine_local_ray_counts.primary += ENGINE_PACKET_SIZE;
+
+#if defined(__SSE2__)
+    ClosestIntersection hits[ENGINE_PACKET_SIZE];
+    engine_intersect_packet(job->scene, &packet, EPSILON, hits);
+
+    for (int lane = 0; lane < ENGINE_PACKET_SIZE; ++lane) {
+        Vector3 direction = vector3_new(packet.direction_x[lane], packet.direction_y[lane], packet.direction_z[lane]);
+        colors[lane] = engine_shade_intersection(job->scene, packet.origin, direction, &hits[lane], recursion_depth);
+    }
+#else
+    for (int lane = 0; lane < ENGINE_PACKET_SIZE; ++lane) {
+        Vector3 direction = vector3_new(packet.direction_x[lane], packet.direction_y[lane], packet.direction_z[lane]);
+        colors[lane] = engine_trace_ray(packet.origin, job->scene, direction, recursion_depth, EPSILON, FLT_MAX);
+    }
+#endif
+
+    // Color is three floats, so the block is packed as one RGB array
+    unsigned int pixels[ENGINE_PACKET_SIZE];
+    job->scene->kernels->pack_pixels(&colors[0].r, pixels, ENGINE_PACKET_SIZE);
+    row0[sdl_x] = pixels[0];
+    row0[sdl_x + 1] = pixels[1];
+    row1[sdl_x] = pixels[2];
+    row1[sdl_x + 1] = pixels[3];
+}
+
+/**
+ * @brief Traces one primary ray per stride x stride block of a tile and fills the block with its color.
+ * Samples sit on the top-left pixel of each block, so a pass at half the stride only has to
+ * trace the three new samples of every old block; with refine set the old sample is kept.
+ * @param row_begin First framebuffer row of the tile; row_end is one past the last.
+ * @param column_begin First framebuffer column of the tile; column_end is one past the last.
+ */
+static void engine_render_tile_strided(const RenderJob* job, int row_begin, int row_end, int column_begin, int column_end) {
+    const CameraFrame* camera = &job->camera;
+    const Canvas* canvas = job->canvas;
+    RenderTarget* target = &job->engine->target;
+
+    const int canvas_half_width = canvas->width / 2;
+    const int top_pixel_y = canvas->height - canvas->height / 2 - 1;
+    const int stride = job->stride;
+    const int previous_stride = stride * 2;
+    const int recursion_depth = engine_recursive_depth(job->engine);
+
+    // Tile edges are multiples of ENGINE_TILE_SIZE, so block corners line up with the framebuffer grid
+    for (int sdl_y = row_begin; sdl_y < row_end; sdl_y += stride) {
+        const int block_height = (sdl_y + stride < row_end) ? stride : row_end - sdl_y;
+
+        for (int sdl_x = column_begin; sdl_x < column_end; sdl_x += stride) {
+            if (job->refine && sdl_y % previous_stride == 0 && sdl_x % previous_stride == 0) {
+                continue; // Traced by the previous pass, which also filled this block
+            }
+
+            Vector3 ray_direction = camera_frame_ray_direction(camera, sdl_x - canvas_half_width, top_pixel_y - sdl_y);
+            Color pixel_color = engine_trace_ray(camera->origin, job->scene, ray_direction, recursion_depth, EPSILON, FLT_MAX);
+            engine_local_ray_counts.primary++;
+            const unsigned int argb = color_to_argb8888(&pixel_color);
+
+            const int block_width = (sdl_x + stride < column_end) ? stride : column_end - sdl_x;
+            for (int dy = 0; dy < block_height; ++dy) {
+                unsigned int* row = target->pixel_buffer + (size_t)(sdl_y + dy) * target->width + sdl_x;
+                for (int dx = 0; dx < block_width; ++dx) {
+                    row[dx] = argb;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Primary samples of one adaptive tile, indexed by tile-local pixel.
+ */
+typedef struct AdaptiveTile {
+    const RenderJob* job;
+    int row_begin;
+    int column_begin;
+    int width;
+    Color colors[ENGINE_TILE_SIZE * ENGINE_TILE_SIZE];
+    const Object* objects[ENGINE_TILE_SIZE * ENGINE_TILE_SIZE];  ///< Object hit by the primary ray (NULL for background).
+    unsigned char traced[ENGINE_TILE_SIZE * ENGINE_TILE_SIZE];
+} AdaptiveTile;
+
+// Traces the primary ray of a tile-local pixel once and writes it to the framebuffer
+static int engine_adaptive_sample(AdaptiveTile* tile, int x, int y) {
+    const int index = y * tile->width + x;
+    if (tile->traced[index]) {
+        return index;
+    }
+
+    const RenderJob* job = tile->job;
+    const Canvas* canvas = job->canvas;
+    const int sdl_x = tile->column_begin + x;
+    const int sdl_y = tile->row_begin + y;
+    Vector3 ray_direction = camera_frame_ray_direction(&job->camera, sdl_x - canvas->width / 2,
+                                                       canvas->height - canvas->height / 2 - 1 - sdl_y);
+
+    ClosestIntersection closest_intersection = engine_calculate_closest_intersection(job->scene, job->camera.origin, ray_direction, EPSILON, FLT_MAX);
+    tile->colors[index] = engine_shade_intersection(job->scene, job->camera.origin, ray_direction, &closest_intersection,
+                                                    engine_recursive_depth(job->engine));
+    tile->objects[index] = closest_intersection.closest_object;
+    tile->traced[index] = 1;
+    engine_local_ray_counts.primary++;
+
+    RenderTarget* target = &job->engine->target;
+    target->pixel_buffer[(size_t)sdl_y * target->width + sdl_x] = color_to_argb8888(&tile->colors[index]);
+    return index;
+}
+
+// True when two samples are within the tolerance in every channel
+static int engine_adaptive_similar(const Color* a, const Color* b, int tolerance) {
+    return fabsf(a->r - b->r) <= tolerance && fabsf(a->g - b->g) <= tolerance && fabsf(a->b - b->b) <= tolerance;
+}
+
+/**
+ * @brief Fills the cell spanning tile-local pixels [x0, x1] x [y0, y1] (corners included).
+ * The corners are traced; if they hit the same object and agree within the tolerance the
+ * interior is interpolated bilinearly, otherwise the cell is split into four and refined.
+ */
+static void engine_adaptive_cell(AdaptiveTile* tile, int x0, int y0, int x1, int y1) {
+    const int c00 = engine_adaptive_sample(tile, x0, y0);
+    const int c10 = engine_adaptive_sample(tile, x1, y0);
+    const int c01 = engine_adaptive_sample(tile, x0, y1);
+    const int c11 = engine_adaptive_sample(tile, x1, y1);
+
+    // Cells of at most 2x2 pixels consist of their corners only
+    if (x1 - x0 <= 1 && y1 - y0 <= 1) {
+        return;
+    }
+
+    const int tolerance = tile->job->engine->settings.adaptive_tolerance;
+    const Color* colors = tile->colors;
+    const int smooth =
+        tile->objects[c00] == tile->objects[c10] && tile->objects[c00] == tile->objects[c01] && tile->objects[c00] == tile->objects[c11] &&
+        engine_adaptive_similar(&colors[c00], &colors[c10], tolerance) &&
+        engine_adaptive_similar(&colors[c00], &colors[c01], tolerance) &&
+        engine_adaptive_similar(&colors[c00], &colors[c11], tolerance) &&
+        engine_adaptive_similar(&colors[c10], &colors[c01], tolerance) &&
+        engine_adaptive_similar(&colors[c10], &colors[c11], tolerance) &&
+        engine_adaptive_similar(&colors[c01], &colors[c11], tolerance);
+
+    if (!smooth) {
+        const int mid_x = (x0 + x1) / 2;
+        const int mid_y = (y0 + y1) / 2;
+        // Degenerate halves (one pixel wide) collapse onto the shared edge, which is harmless
+        engine_adaptive_cell(tile, x0, y0, mid_x, mid_y);
+        engine_adaptive_cell(tile, mid_x, y0, x1, mid_y);
+        engine_adaptive_cell(tile, x0, mid_y, mid_x, y1);
+        engine_adaptive_cell(tile, mid_x, mid_y, x1, y1);
+        return;
+    }
+
+    RenderTarget* target = &tile->job->engine->target;
+    const float inverse_width = 1.0f / (float)((x1 > x0) ? x1 - x0 : 1);
+    const float inverse_height = 1.0f / (float)((y1 > y0) ? y1 - y0 : 1);
+
+    for (int y = y0; y <= y1; ++y) {
+        const float v = (float)(y - y0) * inverse_height;
+        unsigned int* row = target->pixel_buffer + (size_t)(tile->row_begin + y) * target->width + tile->column_begin;
+
+        for (int x = x0; x <= x1; ++x) {
+            // Traced pixels (including those of finer neighbouring cells) keep their exact color
+            if (tile->traced[y * tile->width + x]) {
+                continue;
+            }
+
+            const float u = (float)(x - x0) * inverse_width;
+            const float w00 = (1.0f - u) * (1.0f - v), w10 = u * (1.0f - v), w01 = (1.0f - u) * v, w11 = u * v;
+            Color interpolated = color_new(
+                (unsigned char)(w00 * colors[c00].r + w10 * colors[c10].r + w01 * colors[c01].r + w11 * colors[c11].r + 0.5f),
+                (unsigned char)(w00 * colors[c00].g + w10 * colors[c10].g + w01 * colors[c01].g + w11 * colors[c11].g + 0.5f),
+                (unsigned char)(w00 * colors[c00].b + w10 * colors[c10].b + w01 * colors[c01].b + w11 * colors[c11].b + 0.5f)
+            );
+            row[x] = color_to_argb8888(&interpolated);
+        }
+    }
+}
+
+/**
+ * @brief Traces a tile adaptively: a grid of ENGINE_ADAPTIVE_CELL_SIZE cells is sampled at
+ * its corners and only cells whose corners disagree are refined down to single pixels.
+ * @param row_begin First framebuffer row of the tile; row_end is one past the last.
+ * @param column_begin First framebuffer column of the tile; column_end is one past the last.
+ */
+static void engine_render_tile_adaptive(const RenderJob* job, int row_begin, int row_end, int column_begin, int column_end) {
+    AdaptiveTile tile;
+    tile.job = job;
+    tile.row_begin = row_begin;
+    tile.column_begin = column_begin;
+    tile.width = column_end - column_begin;
+    memset(tile.traced, 0, sizeof(tile.traced));
+
+    const int last_x = column_end - column_begin - 1;
+    const int last_y = row_end - row_begin - 1;
+
+    // Cells share their corner rows and columns; the last cell of a partial tile is narrower
+    for (int y0 = 0; y0 < last_y || y0 == 0; y0 += ENGINE_ADAPTIVE_CELL_SIZE) {
+        const int y1 = (y0 + ENGINE_ADAPTIVE_CELL_SIZE < last_y) ? y0 + ENGINE_ADAPTIVE_CELL_SIZE : last_y;
+        for (int x0 = 0; x0 < last_x || x0 == 0; x0 += ENGINE_ADAPTIVE_CELL_SIZE) {
+            const int x1 = (x0 + ENGINE_ADAPTIVE_CELL_SIZE < last_x) ? x0 + ENGINE_ADAPTIVE_CELL_SIZE : last_x;
+            engine_adaptive_cell(&tile, x0, y0, x1, y1);
+        }
+    }
+}
+
+/**
+ * @brief Traces one tile breadth first: all primary rays are queued, then each
+ * bounce's rays, shadow rays and reflections are processed as whole queues.
+ * @param wavefront The executing worker's queues.
+ * @param row_begin First framebuffer row of the tile; row_end is one past the last.
+ * @param column_begin First framebuffer column of the tile; column_end is one past the last.
+ * @return 0 on success, -1 if the queues could not be allocated (the tile is left untouched).
+ */
+static int engine_render_tile_wavefront(const RenderJob* job, Wavefront* wavefront, int row_begin, int row_end, int column_begin, int column_end) {
+    const CameraFrame* camera = &job->camera;
+    const Canvas* canvas = job->canvas;
+    RenderTarget* target = &job->engine->target;
+
+    const int canvas_half_width = canvas->width / 2;
+    const int top_pixel_y = canvas->height - canvas->height / 2 - 1;
+    const int tile_width = column_end - column_begin;
+    const int pixel_count = tile_width * (row_end - row_begin);
+
+    if (wavefront_begin(wavefront, pixel_count, job->scene->light_count) != 0) {
+        return -1;
+    }
+
+    for (int sdl_y = row_begin; sdl_y < row_end; ++sdl_y) {
+        for (int sdl_x = column_begin; sdl_x < column_end; ++sdl_x) {
+            Vector3 ray_direction = camera_frame_ray_direction(camera, sdl_x - canvas_half_width, top_pixel_y - sdl_y);
+            wavefront_push_primary(wavefront, camera->origin, ray_direction, (sdl_y - row_begin) * tile_width + (sdl_x - column_begin));
+        }
+    }
+
+    engine_local_ray_counts.primary += pixel_count;
+    engine_local_ray_counts.reflection += wavefront_trace(wavefront, job->scene, job->engine->settings.recursion_depth, EPSILON);
+
+    // The radiance of a tile row is contiguous, so each row is packed with one kernel call
+    for (int sdl_y = row_begin; sdl_y < row_end; ++sdl_y) {
+        unsigned int* row = target->pixel_buffer + (size_t)sdl_y * target->width;
+        job->scene->kernels->pack_pixels(&wavefront->radiance[3 * (sdl_y - row_begin) * tile_width], row + column_begin, tile_width);
+    }
+    return 0;
+}
+
+/**
+ * @brief Renders a tile from the reprojected history, tracing only the pixels it cannot supply.
+ * A reprojected pixel is reused when the new primary ray still hits the object its source saw;
+ * one ray-object test replaces the full traversal and shading. Every pixel's hit is recorded
+ * as the history of the next frame.
+ * @param row_begin First framebuffer row of the tile; row_end is one past the last.
+ * @param column_begin First framebuffer column of the tile; column_end is one past the last.
+ */
+static void engine_render_tile_reprojected(const RenderJob* job, int row_begin, int row_end, int column_begin, int column_end) {
+    const CameraFrame* camera = &job->camera;
+    const Canvas* canvas = job->canvas;
+    const PreparedScene* scene = job->scene;
+    const Object* objects = scene->objects->objects;
+    Reprojection* reprojection = job->reprojection;
+    RenderTarget* target = &job->engine->target;
+    const int recursion_depth = engine_recursive_depth(job->engine);
+
+    const int canvas_half_width = canvas->width / 2;
+    const int top_pixel_y = canvas->height - canvas->height / 2 - 1;
+
+    for (int sdl_y = row_begin; sdl_y < row_end; ++sdl_y) {
+        unsigned int* row = target->pixel_buffer + (size_t)sdl_y * target->width;
+        for (int sdl_x = column_begin; sdl_x < column_end; ++sdl_x) {
+            const int pixel = sdl_y * canvas->width + sdl_x;
+            Vector3 ray_direction = camera_frame_ray_direction(camera, sdl_x - canvas_half_width, top_pixel_y - sdl_y);
+
+            const int source = reprojection_source(reprojection, sdl_x, sdl_y);
+            if (source >= 0) {
+                const int object = reprojection->history.objects[source];
+                const unsigned int color = reprojection->history.colors[source];
+
+                if (object < 0) {
+                    row[sdl_x] = color;
+                    reprojection_store(reprojection, pixel, ray_direction, -1, color);
+                    continue;
+                }
+
+                const float t = engine_ray_object_intersection(scene, camera->origin, ray_direction, &objects[object], EPSILON, FLT_MAX);
+                if (t < FLT_MAX) {
+                    row[sdl_x] = color;
+                    reprojection_store(reprojection, pixel, vector3_add(camera->origin, vector3_scale(ray_direction, t)), object, color);
+                    continue;
+                }
+                // The surface no longer covers this pixel; trace it
+            }
+
+            ClosestIntersection closest_intersection = engine_calculate_closest_intersection(scene, camera->origin, ray_direction, EPSILON, FLT_MAX);
+            Color pixel_color = engine_shade_intersection(scene, camera->origin, ray_direction, &closest_intersection, recursion_depth);
+            engine_local_ray_counts.primary++;
+
+            const unsigned int color = color_to_argb8888(&pixel_color);
+            row[sdl_x] = color;
+            if (closest_intersection.closest_object) {
+                Vector3 hit_point = vector3_add(camera->origin, vector3_scale(ray_direction, closest_intersection.closest_t));
+                reprojection_store(reprojection, pixel, hit_point, (int)(closest_intersection.closest_object - objects), color);
+            } else {
+                reprojection_store(reprojection, pixel, ray_direction, -1, color);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Traces every pixel of one tile and writes the results into the framebuffer.
+ * Tiles never overlap, so workers write to disjoint parts of the framebuffer.
+ * @param context Pointer to the frame's RenderJob.
+ * @param tile_index Index of the tile within the job, counted from job->first_tile in row-major tile order.
+ * @param worker_index Index of the executing worker, selecting its wavefront queues.
+ */
+static void engine_trace_tile(void* context, int tile_index, int worker_index) {
+    const RenderJob* job = (const RenderJob*)context;
+    const CameraFrame* camera = &job->camera;
+    const Canvas* canvas = job->canvas;
+    RenderTarget* target = &job->engine->target;
+
+    // Calculate half dimensions for clearer loop bounds.
+    // Odd sizes put the extra column on the right and the extra row at the top.
+    const int canvas_half_width = canvas->width / 2;
+    const int canvas_half_height = canvas->height / 2;
+    const int top_pixel_y = canvas->height - canvas_half_height - 1;
+
+    // Tile bounds in SDL screen coordinates (top-left origin)
+    tile_index += job->first_tile;
+    const int row_begin = (tile_index / job->tiles_x) * ENGINE_TILE_SIZE;
+    const int column_begin = (tile_index % job->tiles_x) * ENGINE_TILE_SIZE;
+    const int row_end = (row_begin + ENGINE_TILE_SIZE < canvas->height) ? row_begin + ENGINE_TILE_SIZE : canvas->height;
+    const int column_end = (column_begin + ENGINE_TILE_SIZE < canvas->width) ? column_begin + ENGINE_TILE_SIZE : canvas->width;
+
+    const int recursion_depth = engine_recursive_depth(job->engine);
+    const int use_packets = job->engine->settings.use_packets;
+
+    if (job->stride > 1 || job->refine) {
+        engine_render_tile_strided(job, row_begin, row_end, column_begin, column_end);
+        return;
+    }
+
+    if (job->reprojection) {
+        engine_render_tile_reprojected(job, row_begin, row_end, column_begin, column_end);
+        return;
+    }
+
+    if (job->engine->settings.use_adaptive) {
+        engine_render_tile_adaptive(job, row_begin, row_end, column_begin, column_end);
+        return;
+    }
+
+    // Tiles whose wavefront queues cannot be allocated are traced recursively below instead
+    if (job->engine->wavefronts &&
+        engine_render_tile_wavefront(job, &job->engine->wavefronts[worker_index], row_begin, row_end, column_begin, column_end) == 0) {
+        return;
+    }
+
+    // Rows are walked top to bottom in pairs so that 2x2 blocks can be traced as packets.
+    for (int sdl_y = row_begin; sdl_y < row_end; sdl_y += 2) {
+        // SDL y-coordinates increase downwards, so the viewport y is inverted
+        const int pixel_y = top_pixel_y - sdl_y;
+        unsigned int* row = target->pixel_buffer + (size_t)sdl_y * target->width;
+        const int has_second_row = (sdl_y + 1 < row_end);
+
+        for (int sdl_x = column_begin; sdl_x < column_end; sdl_x += 2) {
+            const int pixel_x = sdl_x - canvas_half_width;
+
+            if (use_packets && has_second_row && sdl_x + 1 < column_end) {
+                engine_trace_packet(job, row, row + target->width, sdl_x, pixel_x, pixel_y);
+                continue;
+            }
+
+            // Single rays for the block (packets disabled, or a partial block at the canvas edge)
+            for (int dy = 0; dy < 1 + has_second_row; ++dy) {
+                for (int dx = 0; dx < 2 && sdl_x + dx < column_end; ++dx) {
+                    Vector3 ray_direction = camera_frame_ray_direction(camera, pixel_x + dx, pixel_y - dy);
+
+                    // Trace the ray to find the color of the pixel
+                    Color pixel_color = engine_trace_ray(camera->origin, job->scene, ray_direction, recursion_depth, EPSILON, FLT_MAX);
+                    engine_local_ray_counts.primary++;
+
+                    // Write the computed color straight into the framebuffer
+                    row[dy * target->width + sdl_x + dx] = color_to_argb8888(&pixel_color);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Thread pool task: traces one tile, then publishes the rays it traced.
+ * @param context Pointer to the frame's RenderJob.
+ * @param tile_index Index of the tile within the job.
+ * @param worker_index Index of the executing worker.
+ */
+static void engine_render_tile(void* context, int tile_index, int worker_index) {
+    const RenderJob* job = (const RenderJob*)context;
+    EngineRayCounts* counts = &job->engine->ray_counts;
+
+    engine_trace_tile(context, tile_index, worker_index);
+
+    // One atomic add per counter and tile keeps the shared counters out of the per-ray path
+    SDL_AtomicAdd(&counts->primary, engine_local_ray_counts.primary);
+    SDL_AtomicAdd(&counts->shadow, engine_local_ray_counts.shadow);
+    SDL_AtomicAdd(&counts->reflection, engine_local_ray_counts.reflection);
+    memset(&engine_local_ray_counts, 0, sizeof(engine_local_ray_counts));
+
+#if ENGINE_STATS
+    EngineStats* stats = &job->engine->stats;
+    SDL_AtomicLock(&job->engine->stats_lock);
+    stats->sphere_tests += engine_thread_stats.sphere_tests;
+    stats->box_tests += engine_thread_stats.box_tests;
+    stats->plane_tests += engine_thread_stats.plane_tests;
+    stats->triangle_tests += engine_thread_stats.triangle_tests;
+    stats->node_tests += engine_thread_stats.node_tests;
+    stats->closest_hits += engine_thread_stats.closest_hits;
+    stats->occluded_shadow_rays += engine_thread_stats.occluded_shadow_rays;
+    stats->lights_evaluated += engine_thread_stats.lights_evaluated;
+    for (int level = 0; level < ENGINE_STATS_DEPTH_BUCKETS; ++level) {
+        stats->depth_histogram[level] += engine_thread_stats.depth_histogram[level];
+    }
+    SDL_AtomicUnlock(&job->engine->stats_lock);
+    memset(&engine_thread_stats, 0, sizeof(engine_thread_stats));
+#endif
+}
+
+/**
+ * @brief Clears the engine's ray counters. engine_render does this at the start of every frame.
+ * @param engine Pointer to the Engine struct.
+ */
+void engine_reset_ray_counts(Engine* engine) {
+    if (!engine) {
+        return;
+    }
+
+    SDL_AtomicSet(&engine->ray_counts.primary, 0);
+    SDL_AtomicSet(&engine->ray_counts.shadow, 0);
+    SDL_AtomicSet(&engine->ray_counts.reflection, 0);
+    memset(&engine->stats, 0, sizeof(engine->stats));
+}
+
+/**
+ * @brief Prints the ray counters and, when compiled with ENGINE_STATS, the detailed statistics.
+ * @param engine Pointer to the Engine struct.
+ * @param stream Destination stream.
+ */
+void engine_print_stats(const Engine* engine, FILE* stream) {
+    if (!engine || !stream) {
+        return;
+    }
+
+    // SDL_AtomicGet takes a non-const pointer; the counters are only read here
+    EngineRayCounts* counts = (EngineRayCounts*)&engine->ray_counts;
+    fprintf(stream, "  rays: %d primary, %d reflection, %d shadow\n",
+        SDL_AtomicGet(&counts->primary), SDL_AtomicGet(&counts->reflection), SDL_AtomicGet(&counts->shadow));
+
+#if ENGINE_STATS
+    const EngineStats* stats = &engine->stats;
+    fprintf(stream, "  tests: %lld ray-sphere, %lld ray-box, %lld ray-plane, %lld ray-triangle, %lld ray-node; hits: %lld closest, %lld occluded shadow rays\n",
+        stats->sphere_tests, stats->box_tests, stats->plane_tests, stats->triangle_tests, stats->node_tests, stats->closest_hits,
+        stats->occluded_shadow_rays);
+    fprintf(stream, "  lights evaluated: %lld\n  depth histogram:", stats->lights_evaluated);
+
+    int last_level = 0;
+    for (int level = 0; level < ENGINE_STATS_DEPTH_BUCKETS; ++level) {
+        if (stats->depth_histogram[level] > 0) {
+            last_level = level;
+        }
+    }
+    for (int level = 0; level <= last_level; ++level) {
+        fprintf(stream, " [%d%s] %lld", level, (level == ENGINE_STATS_DEPTH_BUCKETS - 1) ? "+" : "", stats->depth_histogram[level]);
+    }
+    fprintf(stream, "\n");
+#else
+    fprintf(stream, "  (detailed counters are compiled out; rebuild with make STATS=1)\n");
+#endif
+}
+
+// Frees the per-worker wavefront queues
+static void engine_release_wavefronts(Engine* engine) {
+    for (int i = 0; i < engine->wavefront_count; ++i) {
+        wavefront_free(&engine->wavefronts[i]);
+    }
+    free(engine->wavefronts);
+    engine->wavefronts = NULL;
+    engine->wavefront_count = 0;
+}
+
+// Gives every pool worker its own wavefront queues; they grow on first use and are kept across frames
+static int engine_prepare_wavefronts(Engine* engine) {
+    if (engine->wavefronts && engine->wavefront_count == engine->thread_pool.worker_count) {
+        return 0;
+    }
+
+    engine_release_wavefronts(engine);
+    engine->wavefronts = malloc(sizeof(Wavefront) * (size_t)engine->thread_pool.worker_count);
+    if (!engine->wavefronts) {
+        fprintf(stderr, "Error: Failed to allocate wavefront queues.\n");
+        return 1;
+    }
+
+    engine->wavefront_count = engine->thread_pool.worker_count;
+    for (int i = 0; i < engine->wavefront_count; ++i) {
+        wavefront_init(&engine->wavefronts[i]);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Renders the entire scene from the camera's perspective onto the canvas.
+ * The frame is split into ENGINE_TILE_SIZE tiles that are traced by the engine's thread pool.
+ * @param engine Pointer to the Engine struct.
+ * @param camera Pointer to the Camera struct.
+ * @param scene Pointer to the Scene struct containing objects and lights.
+ * @param canvas Pointer to the Canvas struct.
+ */
+void engine_render(Engine* engine, const Camera* camera, const Scene* scene, const Canvas* canvas) {
+    if (!engine || !camera || !scene || !canvas) {
+        fprintf(stderr, "Error: NULL pointer passed to engine_render.\n");
+        return;
+    }
+
+    engine_reset_ray_counts(engine);
+    engine_render_pass(engine, camera, scene, canvas, 1, 0, 0, engine_tile_row_count(canvas));
+
+    // Display rendered frame
+    engine_present(engine);
+}
+
+/**
+ * @brief Returns the number of ENGINE_TILE_SIZE tile rows covering the canvas.
+ */
+int engine_tile_row_count(const Canvas* canvas) {
+    return (canvas->height + ENGINE_TILE_SIZE - 1) / ENGINE_TILE_SIZE;
+}
+
+/**
+ * @brief Renders a band of tile rows into the framebuffer without presenting it.
+ * Strides above 1 trace one primary ray per stride x stride block and fill the block with it,
+ * which is how the interactive viewer previews and progressively refines frames.
+ * @param engine Pointer to the Engine struct.
+ * @param camera Pointer to the Camera struct.
+ * @param scene Pointer to the Scene struct containing objects and lights.
+ * @param canvas Pointer to the Canvas struct.
+ * @param stride Pixel block edge length: a power of two no larger than ENGINE_TILE_SIZE.
+ * @param refine Non-zero when the band was last rendered at twice the stride with the same view;
+ * the samples of that pass are kept and only the new ones are traced.
+ * @param tile_row_begin First tile row to render.
+ * @param tile_row_end One past the last tile row to render.
+ */
+void engine_render_pass(Engine* engine, const Camera* camera, const Scene* scene, const Canvas* canvas,
+                        int stride, int refine, int tile_row_begin, int tile_row_end) {
+    if (!engine || !camera || !scene || !canvas) {
+        fprintf(stderr, "Error: NULL pointer passed to engine_render_pass.\n");
+        return;
+    }
+    if (stride < 1 || stride > ENGINE_TILE_SIZE || (stride & (stride - 1)) != 0) {
+        fprintf(stderr, "Error: Invalid pixel stride %d passed to engine_render_pass.\n", stride);
+        return;
+    }
+
+    const int tile_row_count = engine_tile_row_count(canvas);
+    if (tile_row_begin < 0) {
+        tile_row_begin = 0;
+    }
+    if (tile_row_end > tile_row_count) {
+        tile_row_end = tile_row_count;
+    }
+    if (tile_row_begin >= tile_row_end) {
+        return;
+    }
+
+    // Bake the frame's invariants; the snapshot is only rebuilt when the scene changed
+    if (scene_prepare(scene, &engine->prepared_scene) != 0) {
+        return;
+    }
+    engine->prepared_scene.kernels = engine->kernels;
+
+    CameraFrame camera_frame;
+    camera_prepare(camera, canvas, &camera_frame);
+
+    RenderJob job = {
+        engine, camera_frame, &engine->prepared_scene, canvas,
+        (canvas->width + ENGINE_TILE_SIZE - 1) / ENGINE_TILE_SIZE,
+        tile_row_count,
+        0, stride, refine && stride < ENGINE_TILE_SIZE, NULL
+    };
+    job.first_tile = tile_row_begin * job.tiles_x;
+
+    if (engine->settings.use_wavefront && engine_prepare_wavefronts(engine) != 0) {
+        fprintf(stderr, "Falling back to per-pixel tracing.\n");
+        engine->settings.use_wavefront = 0;
+    }
+    if (!engine->settings.use_wavefront) {
+        engine_release_wavefronts(engine);
+    }
+
+    // The history only follows full frames; preview and refinement bands trace as usual and leave it alone
+    if (engine->settings.use_reprojection && stride == 1 && !job.refine && tile_row_begin == 0 && tile_row_end == tile_row_count) {
+        if (reprojection_begin(&engine->reprojection, &camera_frame, canvas->width, canvas->height,
+                               &engine->prepared_scene, engine->settings.recursion_depth) == 0) {
+            job.reprojection = &engine->reprojection;
+        } else {
+            fprintf(stderr, "Falling back to tracing every pixel.\n");
+            engine->settings.use_reprojection = 0;
+        }
+    }
+    if (!engine->settings.use_reprojection) {
+        reprojection_free(&engine->reprojection);
+    }
+
+    // Reflective objects make tile cost very uneven; the pool rebalances by stealing tiles
+    thread_pool_run(&engine->thread_pool, (tile_row_end - tile_row_begin) * job.tiles_x, engine_render_tile, &job);
 
-    return 0;
+    if (job.reprojection) {
+        reprojection_end(job.reprojection);
+    }
 }
 
 /**
- * @brief Renders the entire scene from the camera's perspective onto the canvas.
+ * @brief Presents the framebuffer through the engine's render target.
+ * SDL targets perform a single texture update per frame; offscreen targets do nothing.
  * @param engine Pointer to the Engine struct.
- * @param camera Pointer to the Camera struct.
- * @param scene Pointer to the Scene struct containing objects and lights.
- * @param canvas Pointer to the Canvas struct.
  */
-void engine_render(Engine* engine, const Camera* camera, const Scene* scene, const Canvas* canvas) {
-    if (!engine || !camera || !scene || !canvas) {
-        fprintf(stderr, "Error: NULL pointer passed to engine_render.\n");
+void engine_present(Engine* engine) {
+    if (!engine) {
         return;
     }
 
-    // Set background color for clearing
-    SDL_SetRenderDrawColor(engine->renderer, scene->background_color.r, scene->background_color.g, scene->background_color.b, 255);
-    SDL_RenderClear(engine->renderer);
-
-    // Calculate half dimensions for clearer loop bounds
-    const int canvas_half_width = canvas->width / 2;
-    const int canvas_half_height = canvas->height / 2;
-
-    // Iterate over each pixel in the canvas (viewport coordinates)
-    for (int pixel_x = -canvas_half_width; pixel_x < canvas_half_width; ++pixel_x) {
-        for (int pixel_y = -canvas_half_height; pixel_y < canvas_half_height; ++pixel_y) {
-
-            // Step 1: Calculate ray direction in the camera's LOCAL space
-            // This vector goes from (0,0,0) in camera local space to a point on the viewport plane.
-            Vector3 viewport_local_coords = canvas_to_viewport(camera, canvas, pixel_x, pixel_y);
-
-            // Step 2: Transform the local ray direction into WORLD space
-            // The ray's direction in world space is a linear combination of the
-            // camera's world-space right, up, and forward (direction) vectors,
-            // scaled by the x, y, and z components of the viewport_local_coords.
-            Vector3 ray_direction = vector3_add(
-                vector3_scale(camera->right, viewport_local_coords.x),
-                vector3_add(
-                    vector3_scale(camera->up, viewport_local_coords.y),
-                    vector3_scale(camera->forward, viewport_local_coords.z)
-                )
-            );
-            ray_direction = vector3_normalize(ray_direction); // Normalize the final world-space ray direction
-
-            // Trace the ray to find the color of the pixel
-            Color pixel_color = engine_trace_ray(camera->position, scene, ray_direction, 3, EPSILON, FLT_MAX);
-
-            // Draw the computed color at the pixel location
-            engine_draw_pixel(engine, canvas, &pixel_color, pixel_x, pixel_y);
-        }
-    }
-
-    // Display rendered frame
-    SDL_RenderPresent(engine->renderer);
+    render_target_present(&engine->target);
 }
 
 
@@ -93,156 +1134,811 @@ Vector3 engine_reflect_ray(Vector3 ray_direction, Vector3 normal) {
 
 /**
  * @brief Traces a ray into the scene to determine the color of the intersected object.
- * @param camera Pointer to the Camera from which the ray originates.
- * @param scene Pointer to the Scene containing objects and lights.
- * @param ray_direction Direction vector of the ray.
- * @param background_color The color to return if no object is hit.
- * @return The computed color of the pixel.
+ * @param origin Origin of the ray.
+ * @param scene Pointer to the prepared scene.
+ * @param ray_direction Unit direction vector of the ray.
+ * @param recursion_depth Remaining reflection bounces.
+ * @param t_min Hits at or before this distance are ignored (EPSILON avoids self-intersection).
+ * @param t_max Hits at or beyond this distance are ignored.
+ * @return The color of the nearest hit, or the scene's background color if nothing is hit in (t_min, t_max).
  */
-Color engine_trace_ray(Vector3 origin, const Scene* scene, Vector3 ray_direction, int recursion_depth, float t_min, float t_max) {
+Color engine_trace_ray(Vector3 origin, const PreparedScene* scene, Vector3 ray_direction, int recursion_depth, float t_min, float t_max) {
     if (!scene) {
         fprintf(stderr, "Error: NULL scene passed to engine_trace_ray.\n");
-        return scene->background_color; // Return background color on error
+        return color_new(0, 0, 0); // There is no background color to fall back to
     }
 
-    ClosestIntersection closest_intersection = engine_calculate_closest_intersection(scene->objects, origin, ray_direction, t_min, t_max);
+    ClosestIntersection closest_intersection = engine_calculate_closest_intersection(scene, origin, ray_direction, t_min, t_max);
+
+    return engine_shade_intersection(scene, origin, ray_direction, &closest_intersection, recursion_depth);
+}
+
+/**
+ * @brief Computes the color seen along a ray whose nearest hit is already known.
+ * Reflections are traced with engine_trace_ray.
+ * @param scene Pointer to the Scene containing objects and lights.
+ * @param origin Origin of the ray.
+ * @param ray_direction Direction vector of the ray.
+ * @param closest_intersection Nearest hit of the ray (closest_object == NULL for a miss).
+ * @param recursion_depth Remaining reflection bounces.
+ * @return The computed color.
+ */
+Color engine_shade_intersection(const PreparedScene* scene, Vector3 origin, Vector3 ray_direction, const ClosestIntersection* closest_intersection, int recursion_depth) {
+    const Object* closest_object = closest_intersection->closest_object;
+
+    ENGINE_STATS_DEPTH(engine_stats_level, 1);
 
-    if (closest_intersection.closest_object == NULL) {
+    if (closest_object == NULL) {
         return scene->background_color;
     }
 
+    ENGINE_STATS_ADD(closest_hits, 1);
+
     // Calculate the exact 3D point where the ray hit the object
-    Vector3 intersection_point = vector3_add(origin, vector3_scale(ray_direction, closest_intersection.closest_t));
+    Vector3 intersection_point = vector3_add(origin, vector3_scale(ray_direction, closest_intersection->closest_t));
 
-    // Calculate the surface normal at the intersection point.
-    // For a sphere, the normal is simply (intersection_point - sphere_center) normalized.
-    Vector3 surface_normal =  vector3_normalize(vector3_subtract(intersection_point, closest_intersection.closest_object->position));
+    // Calculate the surface normal at the intersection point
+    Vector3 surface_normal = engine_surface_normal(scene, closest_intersection, intersection_point, ray_direction);
 
-    // The view direction is the inverse of the ray direction from the camera
+    // The view direction is the inverse of the ray direction, so it is a unit vector as well
     Vector3 view_direction = vector3_scale(ray_direction, -1.0f);
 
+    const PreparedMaterial* material = engine_hit_material(scene, closest_intersection);
+
     // Compute the total light intensity at the intersection point
-    float light_intensity = engine_compute_light(scene, intersection_point, surface_normal, closest_intersection.closest_object->specularity, view_direction);
+    float light_intensity = engine_compute_light(scene, intersection_point, surface_normal, material->specular, view_direction);
 
-    // Return the object's color multiplied by the calculated light intensity
+    // Return the material's color multiplied by the calculated light intensity
     Color local_color = color_new(
-        (unsigned char)(closest_intersection.closest_object->color.r * light_intensity),
-        (unsigned char)(closest_intersection.closest_object->color.g * light_intensity),
-        (unsigned char)(closest_intersection.closest_object->color.b * light_intensity)
+        (unsigned char)(material->color.r * light_intensity),
+        (unsigned char)(material->color.g * light_intensity),
+        (unsigned char)(material->color.b * light_intensity)
     );
 
-    if (recursion_depth <= 0 || closest_intersection.closest_object->reflectivity <= 0) {
+    if (recursion_depth <= 0 || material->reflectivity <= 0) {
         return local_color;
     }
 
     Vector3 reflected_ray = engine_reflect_ray(view_direction, surface_normal);
 
+    engine_local_ray_counts.reflection++;
+#if ENGINE_STATS
+    engine_stats_level++;
+#endif
     Color reflected_color = engine_trace_ray(intersection_point, scene, reflected_ray, recursion_depth - 1, EPSILON, FLT_MAX);
+#if ENGINE_STATS
+    engine_stats_level--;
+#endif
 
     return color_new(
-        (local_color.r * (1 - closest_intersection.closest_object->reflectivity)) + (reflected_color.r * closest_intersection.closest_object->reflectivity),
-        (local_color.g * (1 - closest_intersection.closest_object->reflectivity)) + (reflected_color.g * closest_intersection.closest_object->reflectivity),
-        (local_color.b * (1 - closest_intersection.closest_object->reflectivity)) + (reflected_color.b * closest_intersection.closest_object->reflectivity)
+        (local_color.r * (1 - material->reflectivity)) + (reflected_color.r * material->reflectivity),
+        (local_color.g * (1 - material->reflectivity)) + (reflected_color.g * material->reflectivity),
+        (local_color.b * (1 - material->reflectivity)) + (reflected_color.b * material->reflectivity)
     );
 }
 
 /**
  * @brief Computes the total light intensity at a given surface point.
- * @param lights_list Pointer to the list of lights in the scene.
+ * @param scene Pointer to the prepared scene; its ambient lights are already folded into one term.
  * @param surface_point The 3D point on the object's surface.
  * @param surface_normal The normal vector at the surface_point.
- * @param specular_exponent The specular exponent of the material.
- * @param view_direction Direction vector from the surface point to the camera.
+ * @param specular Specular response of the material, or NULL for matte materials.
+ * @param view_direction Unit vector from the surface point to the camera.
  * @return The total light intensity.
  */
-float engine_compute_light(const Scene* scene, Vector3 surface_point, Vector3 surface_normal, int specular_exponent, Vector3 view_direction) {
-    if (!scene->lights) {
-        fprintf(stderr, "Error: NULL lights_list passed to engine_compute_light.\n");
-        return 0.0f;
+float engine_compute_light(const PreparedScene* scene, Vector3 surface_point, Vector3 surface_normal, const SpecularTable* specular, Vector3 view_direction) {
+    float total_intensity = scene->ambient_intensity;
+    KernelLightTerms terms;
+
+    // The unshadowed terms of a batch of lights come from one SIMD kernel call; shadow rays stay per light
+    for (int first = 0; first < scene->light_count; first += KERNELS_LIGHT_BATCH) {
+        const int count = (scene->light_count - first < KERNELS_LIGHT_BATCH) ? scene->light_count - first : KERNELS_LIGHT_BATCH;
+        ENGINE_STATS_ADD(lights_evaluated, count);
+        scene->kernels->light_terms(&scene->lights[first], count, surface_point, surface_normal, specular, view_direction, &terms);
+
+        for (int i = 0; i < count; ++i) {
+            // An unlit side cannot be darkened any further
+            if (terms.contribution[i] <= 0.0f) {
+                continue;
+            }
+
+            // Shadow test: any blocker between the point and the light will do
+            Vector3 light_direction = vector3_new(terms.direction_x[i], terms.direction_y[i], terms.direction_z[i]);
+            if (engine_is_occluded(scene, surface_point, light_direction, EPSILON, terms.t_max[i])) {
+                ENGINE_STATS_ADD(occluded_shadow_rays, 1);
+                continue;
+            }
+
+            total_intensity += terms.contribution[i];
+        }
+    }
+
+    return fmin(total_intensity, 1.0f); 
+}
+
+/**
+ * @brief Tests one ray against a contiguous range of spheres and returns the nearest hit.
+ * Works on the SoA mirror only, with the sphere kernel selected for the CPU. ray_direction must be a unit vector.
+ * @param kernels Kernels of the frame (PreparedScene.kernels).
+ * @param spheres SoA sphere data.
+ * @param first Index of the first sphere to test.
+ * @param count Number of spheres to test.
+ * @param closest_t In: current closest distance. Out: updated when a nearer hit is found.
+ * @return Index of the nearest sphere hit in (t_min, min(t_max, closest_t)), or -1.
+ */
+static int engine_intersect_spheres(const Kernels* kernels, const SphereSoA* spheres, int first, int count, Vector3 ray_origin, Vector3 ray_direction,
+                                    float t_min, float t_max, float* closest_t) {
+    ENGINE_STATS_ADD(sphere_tests, count);
+
+    float best_t = fminf(t_max, *closest_t);
+    const int best_index = kernels->intersect_spheres(spheres, first, count, ray_origin, ray_direction, t_min, &best_t);
+    if (best_index >= 0) {
+        *closest_t = best_t;
+    }
+    return best_index;
+}
+
+/**
+ * @brief Slab test of a ray against one cube or cuboid.
+ * With SSE2 the three slabs are tested together, one axis per lane.
+ * @param inverse_direction Component-wise reciprocal of the ray direction.
+ * @return Distance to the entry point, or to the exit point when the entry lies at or before t_min;
+ * FLT_MAX or a distance outside (t_min, FLT_MAX) when the ray misses.
+ */
+static inline float engine_box_hit(const Object* box, Vector3 ray_origin, Vector3 inverse_direction, float t_min) {
+    const Vector3 center = box->position;
+    const Vector3 half = box->data.boxData.half_extents;
+
+#if defined(__SSE2__)
+    const __m128 origin = _mm_setr_ps(ray_origin.x, ray_origin.y, ray_origin.z, 0.0f);
+    const __m128 inverse = _mm_setr_ps(inverse_direction.x, inverse_direction.y, inverse_direction.z, 0.0f);
+    const __m128 center_v = _mm_setr_ps(center.x, center.y, center.z, 0.0f);
+    const __m128 half_v = _mm_setr_ps(half.x, half.y, half.z, 0.0f);
+
+    const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(center_v, half_v), origin), inverse);
+    const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(center_v, half_v), origin), inverse);
+
+    // The unused fourth lane repeats the x slab so that it drops out of the reductions
+    __m128 near = _mm_min_ps(t1, t2);
+    __m128 far = _mm_max_ps(t1, t2);
+    near = _mm_shuffle_ps(near, near, _MM_SHUFFLE(0, 2, 1, 0));
+    far = _mm_shuffle_ps(far, far, _MM_SHUFFLE(0, 2, 1, 0));
+    near = _mm_max_ps(near, _mm_shuffle_ps(near, near, _MM_SHUFFLE(2, 3, 0, 1)));
+    far = _mm_min_ps(far, _mm_shuffle_ps(far, far, _MM_SHUFFLE(2, 3, 0, 1)));
+    near = _mm_max_ps(near, _mm_shuffle_ps(near, near, _MM_SHUFFLE(1, 0, 3, 2)));
+    far = _mm_min_ps(far, _mm_shuffle_ps(far, far, _MM_SHUFFLE(1, 0, 3, 2)));
+    const float t_near = _mm_cvtss_f32(near);
+    const float t_far = _mm_cvtss_f32(far);
+#else
+    const float tx1 = (center.x - half.x - ray_origin.x) * inverse_direction.x;
+    const float tx2 = (center.x + half.x - ray_origin.x) * inverse_direction.x;
+    const float ty1 = (center.y - half.y - ray_origin.y) * inverse_direction.y;
+    const float ty2 = (center.y + half.y - ray_origin.y) * inverse_direction.y;
+    const float tz1 = (center.z - half.z - ray_origin.z) * inverse_direction.z;
+    const float tz2 = (center.z + half.z - ray_origin.z) * inverse_direction.z;
+    const float t_near = engine_max(engine_max(engine_min(tx1, tx2), engine_min(ty1, ty2)), engine_min(tz1, tz2));
+    const float t_far = engine_min(engine_min(engine_max(tx1, tx2), engine_max(ty1, ty2)), engine_max(tz1, tz2));
+#endif
+
+    const float t = (t_near > t_min) ? t_near : t_far;
+    return (t_far >= t_near) ? t : FLT_MAX;
+}
+
+/**
+ * @brief Tests one ray against a contiguous range of cubes and cuboids.
+ * @param closest_t In: current closest distance. Out: updated when a nearer hit is found.
+ * @return Index of the nearest box hit in (t_min, min(t_max, closest_t)), or -1.
+ */
+static int engine_intersect_boxes(const Object* objects, int first, int count, Vector3 ray_origin, Vector3 inverse_direction,
+                                  float t_min, float t_max, float* closest_t) {
+    ENGINE_STATS_ADD(box_tests, count);
+
+    float best_t = fminf(t_max, *closest_t);
+    int best_index = -1;
+    for (int i = first; i < first + count; ++i) {
+        const float t = engine_box_hit(&objects[i], ray_origin, inverse_direction, t_min);
+        const int hit = (t > t_min) & (t < best_t);
+        best_t = hit ? t : best_t;
+        best_index = hit ? i : best_index;
+    }
+
+    if (best_index >= 0) {
+        *closest_t = best_t;
+    }
+    return best_index;
+}
+
+// Distance along the ray to a plane; infinite or NaN when the ray runs parallel to it
+static inline float engine_plane_hit(const Object* plane, Vector3 ray_origin, Vector3 ray_direction) {
+    const Vector3 normal = plane->data.planeData.normal;
+    return vector3_dot(normal, vector3_subtract(plane->position, ray_origin)) / vector3_dot(normal, ray_direction);
+}
+
+/**
+ * @brief Tests one ray against a contiguous range of planes.
+ * @param closest_t In: current closest distance. Out: updated when a nearer hit is found.
+ * @return Index of the nearest plane hit in (t_min, min(t_max, closest_t)), or -1.
+ */
+static int engine_intersect_planes(const Object* objects, int first, int count, Vector3 ray_origin, Vector3 ray_direction,
+                                   float t_min, float t_max, float* closest_t) {
+    ENGINE_STATS_ADD(plane_tests, count);
+
+    float best_t = fminf(t_max, *closest_t);
+    int best_index = -1;
+    for (int i = first; i < first + count; ++i) {
+        const float t = engine_plane_hit(&objects[i], ray_origin, ray_direction);
+        const int hit = (t > t_min) & (t < best_t);   // False for the NaN of a parallel ray
+        best_t = hit ? t : best_t;
+        best_index = hit ? i : best_index;
+    }
+
+    if (best_index >= 0) {
+        *closest_t = best_t;
+    }
+    return best_index;
+}
+
+/**
+ * @brief Slab test of a ray against a BVH node's bounds.
+ * @param inverse_direction Component-wise reciprocal of the ray direction.
+ * @return Distance at which the ray enters the box, or FLT_MAX if it misses [t_min, t_max].
+ */
+static float engine_ray_node_entry(const BvhNode* node, Vector3 ray_origin, Vector3 inverse_direction, float t_min, float t_max) {
+    ENGINE_STATS_ADD(node_tests, 1);
+
+    const float tx1 = (node->bounds_min.x - ray_origin.x) * inverse_direction.x;
+    const float tx2 = (node->bounds_max.x - ray_origin.x) * inverse_direction.x;
+    const float ty1 = (node->bounds_min.y - ray_origin.y) * inverse_direction.y;
+    const float ty2 = (node->bounds_max.y - ray_origin.y) * inverse_direction.y;
+    const float tz1 = (node->bounds_min.z - ray_origin.z) * inverse_direction.z;
+    const float tz2 = (node->bounds_max.z - ray_origin.z) * inverse_direction.z;
+
+    const float t_near = engine_max(engine_max(engine_min(tx1, tx2), engine_min(ty1, ty2)), engine_min(tz1, tz2));
+    // Widened by the rounding error of the slab distances (Ize, 2013), so rays through a corner
+    // of a node, such as a mesh vertex on its bounds, are never culled
+    const float t_far = engine_min(engine_min(engine_max(tx1, tx2), engine_max(ty1, ty2)), engine_max(tz1, tz2)) * ENGINE_NODE_EXIT_SCALE;
+
+    if (t_far >= t_near && t_far > t_min && t_near < t_max) {
+        return t_near;
+    }
+    return FLT_MAX;
+}
+
+/**
+ * @brief Per-ray terms of the watertight ray-triangle test (Woop, Benthin and Wald, 2013).
+ * The axes are permuted so that the dominant direction axis becomes z, and a shear maps the
+ * ray onto the +z axis; every triangle is then tested in 2D against the origin, where shared
+ * edges produce bit-identical edge functions on both sides and no ray slips through.
+ */
+typedef struct EngineTriangleRay {
+    int kx, ky, kz;        ///< Permuted axes; kz is the dominant axis of the direction.
+    float sx, sy, sz;      ///< Shear constants.
+    float origin[3];       ///< Ray origin, indexed by axis.
+} EngineTriangleRay;
+
+static EngineTriangleRay engine_triangle_ray(Vector3 ray_origin, Vector3 ray_direction) {
+    const float direction[3] = { ray_direction.x, ray_direction.y, ray_direction.z };
+    EngineTriangleRay ray;
+
+    ray.kz = (fabsf(direction[0]) > fabsf(direction[1]))
+        ? ((fabsf(direction[0]) > fabsf(direction[2])) ? 0 : 2)
+        : ((fabsf(direction[1]) > fabsf(direction[2])) ? 1 : 2);
+    ray.kx = (ray.kz + 1) % 3;
+    ray.ky = (ray.kx + 1) % 3;
+    // Keep the winding of the permuted triangle when the dominant component is negative
+    if (direction[ray.kz] < 0.0f) {
+        const int swap = ray.kx; ray.kx = ray.ky; ray.ky = swap;
+    }
+
+    ray.sx = direction[ray.kx] / direction[ray.kz];
+    ray.sy = direction[ray.ky] / direction[ray.kz];
+    ray.sz = 1.0f / direction[ray.kz];
+    ray.origin[0] = ray_origin.x;
+    ray.origin[1] = ray_origin.y;
+    ray.origin[2] = ray_origin.z;
+    return ray;
+}
+
+// Distance to one triangle in leaf order, or FLT_MAX when the ray misses it; the scalar twin of the SIMD path
+static float engine_triangle_hit(const float* const corners[9], int index, const EngineTriangleRay* ray) {
+    const int kx = ray->kx, ky = ray->ky, kz = ray->kz;
+
+    const float az = corners[kz][index] - ray->origin[kz];
+    const float bz = corners[3 + kz][index] - ray->origin[kz];
+    const float cz = corners[6 + kz][index] - ray->origin[kz];
+    const float ax = (corners[kx][index] - ray->origin[kx]) - ray->sx * az;
+    const float ay = (corners[ky][index] - ray->origin[ky]) - ray->sy * az;
+    const float bx = (corners[3 + kx][index] - ray->origin[kx]) - ray->sx * bz;
+    const float by = (corners[3 + ky][index] - ray->origin[ky]) - ray->sy * bz;
+    const float cx = (corners[6 + kx][index] - ray->origin[kx]) - ray->sx * cz;
+    const float cy = (corners[6 + ky][index] - ray->origin[ky]) - ray->sy * cz;
+
+    // Scaled barycentrics: all of one sign when the sheared ray passes through the triangle
+    const float u = cx * by - cy * bx;
+    const float v = ax * cy - ay * cx;
+    const float w = bx * ay - by * ax;
+    if (((u < 0.0f) | (v < 0.0f) | (w < 0.0f)) & ((u > 0.0f) | (v > 0.0f) | (w > 0.0f))) {
+        return FLT_MAX;
+    }
+
+    const float determinant = u + v + w;
+    if (determinant == 0.0f) {
+        return FLT_MAX;   // Seen edge-on
+    }
+    return (u * (ray->sz * az) + v * (ray->sz * bz) + w * (ray->sz * cz)) / determinant;
+}
+
+/**
+ * @brief Tests one ray against a contiguous range of mesh triangles.
+ * Four triangles per step with SSE2 (the leaves hold up to BVH_MAX_LEAF_SIZE of them), then a scalar tail.
+ * @param closest_t In: current closest distance. Out: updated when a nearer hit is found.
+ * @return Index of the nearest triangle hit in (t_min, closest_t), or -1.
+ */
+static int engine_intersect_triangles(const MeshTriangleSoA* triangles, int first, int count, const EngineTriangleRay* ray,
+                                      float t_min, float* closest_t) {
+    ENGINE_STATS_ADD(triangle_tests, count);
+
+    const int end = first + count;
+    const int kx = ray->kx, ky = ray->ky, kz = ray->kz;
+    // Corner arrays by axis, so the permutation is resolved once per range instead of per triangle
+    const float* const corners[9] = {
+        triangles->ax, triangles->ay, triangles->az,
+        triangles->bx, triangles->by, triangles->bz,
+        triangles->cx, triangles->cy, triangles->cz
+    };
+
+    float best_t = *closest_t;
+    int best_index = -1;
+    int i = first;
+
+#if defined(__SSE2__)
+    {
+        const __m128 ox = _mm_set1_ps(ray->origin[kx]), oy = _mm_set1_ps(ray->origin[ky]), oz = _mm_set1_ps(ray->origin[kz]);
+        const __m128 sx = _mm_set1_ps(ray->sx), sy = _mm_set1_ps(ray->sy), sz = _mm_set1_ps(ray->sz);
+        const __m128 tmin = _mm_set1_ps(t_min), zero = _mm_setzero_ps();
+        __m128 lane_t = _mm_set1_ps(best_t);
+        __m128i lane_index = _mm_set1_epi32(-1);
+        __m128i index = _mm_add_epi32(_mm_set1_epi32(i), _mm_setr_epi32(0, 1, 2, 3));
+
+        for (; i + 4 <= end; i += 4) {
+            const __m128 az = _mm_sub_ps(_mm_loadu_ps(corners[kz] + i), oz);
+            const __m128 bz = _mm_sub_ps(_mm_loadu_ps(corners[3 + kz] + i), oz);
+            const __m128 cz = _mm_sub_ps(_mm_loadu_ps(corners[6 + kz] + i), oz);
+            const __m128 ax = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(corners[kx] + i), ox), _mm_mul_ps(sx, az));
+            const __m128 ay = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(corners[ky] + i), oy), _mm_mul_ps(sy, az));
+            const __m128 bx = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(corners[3 + kx] + i), ox), _mm_mul_ps(sx, bz));
+            const __m128 by = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(corners[3 + ky] + i), oy), _mm_mul_ps(sy, bz));
+            const __m128 cx = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(corners[6 + kx] + i), ox), _mm_mul_ps(sx, cz));
+            const __m128 cy = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(corners[6 + ky] + i), oy), _mm_mul_ps(sy, cz));
+
+            const __m128 u = _mm_sub_ps(_mm_mul_ps(cx, by), _mm_mul_ps(cy, bx));
+            const __m128 v = _mm_sub_ps(_mm_mul_ps(ax, cy), _mm_mul_ps(ay, cx));
+            const __m128 w = _mm_sub_ps(_mm_mul_ps(bx, ay), _mm_mul_ps(by, ax));
+
+            const __m128 negative = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(u, zero), _mm_cmplt_ps(v, zero)), _mm_cmplt_ps(w, zero));
+            const __m128 positive = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(u, zero), _mm_cmpgt_ps(v, zero)), _mm_cmpgt_ps(w, zero));
+            const __m128 determinant = _mm_add_ps(_mm_add_ps(u, v), w);
+            const __m128 inside = _mm_andnot_ps(_mm_and_ps(negative, positive), _mm_cmpneq_ps(determinant, zero));
+
+            // Edge-on lanes divide by zero; their infinities and NaNs are masked out by inside
+            const __m128 scaled_t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(u, _mm_mul_ps(sz, az)), _mm_mul_ps(v, _mm_mul_ps(sz, bz))),
+                                               _mm_mul_ps(w, _mm_mul_ps(sz, cz)));
+            const __m128 t = _mm_div_ps(scaled_t, determinant);
+            const __m128 hit = _mm_and_ps(inside, _mm_and_ps(_mm_cmpgt_ps(t, tmin), _mm_cmplt_ps(t, lane_t)));
+            const __m128i hit_mask = _mm_castps_si128(hit);
+
+            lane_t = _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, lane_t));
+            lane_index = _mm_or_si128(_mm_and_si128(hit_mask, index), _mm_andnot_si128(hit_mask, lane_index));
+            index = _mm_add_epi32(index, _mm_set1_epi32(4));
+        }
+
+        float lane_t_values[4];
+        int lane_index_values[4];
+        _mm_storeu_ps(lane_t_values, lane_t);
+        _mm_storeu_si128((__m128i*)lane_index_values, lane_index);
+        for (int lane = 0; lane < 4; ++lane) {
+            if (lane_index_values[lane] >= 0 && lane_t_values[lane] < best_t) {
+                best_t = lane_t_values[lane];
+                best_index = lane_index_values[lane];
+            }
+        }
+    }
+#endif
+
+    // Scalar tail (and the whole range on targets without SSE2)
+    for (; i < end; ++i) {
+        const float t = engine_triangle_hit(corners, i, ray);
+        if (t > t_min && t < best_t) {
+            best_t = t;
+            best_index = i;
+        }
+    }
+
+    if (best_index >= 0) {
+        *closest_t = best_t;
+    }
+    return best_index;
+}
+
+/**
+ * @brief A ray moved into the space of an instance.
+ * Rotations and uniform scales keep the direction unit length, so the sphere kernel still applies
+ * and a distance along the instance space ray is the world distance divided by scale.
+ */
+typedef struct EngineInstanceRay {
+    Vector3 origin;
+    Vector3 direction;
+    Vector3 inverse_direction;
+    float scale;           ///< World units per instance unit.
+} EngineInstanceRay;
+
+/**
+ * @brief Moves a world space ray into the space of a mesh or sphere set instance.
+ * Translation-only instances keep the direction and its reciprocal; only the origin moves.
+ */
+static EngineInstanceRay engine_instance_ray(const PreparedScene* scene, const Object* instance, Vector3 ray_origin,
+                                             Vector3 ray_direction, Vector3 inverse_direction) {
+    EngineInstanceRay ray;
+    ray.origin = vector3_subtract(ray_origin, instance->position);
+
+    const int transform_index = instance->data.instanceData.transform;
+    if (transform_index < 0) {
+        ray.direction = ray_direction;
+        ray.inverse_direction = inverse_direction;
+        ray.scale = 1.0f;
+        return ray;
+    }
+
+    const Transform* transform = &scene->transforms->transforms[transform_index];
+    ray.origin = vector3_scale(transform_unrotate(transform, ray.origin), 1.0f / transform->scale);
+    ray.direction = transform_unrotate(transform, ray_direction);
+    ray.inverse_direction = vector3_new(
+        engine_safe_inverse(ray.direction.x),
+        engine_safe_inverse(ray.direction.y),
+        engine_safe_inverse(ray.direction.z)
+    );
+    ray.scale = transform->scale;
+    return ray;
+}
+
+/**
+ * @brief Nearest (or, for shadow rays, any) hit of a ray with the geometry of one instance,
+ * walking the mesh's or sphere set's own BVH front to back.
+ * @param ray The ray in instance space.
+ * @param t_min Instance space distance.
+ * @param closest_t In: current closest instance space distance. Out: updated when a nearer hit is found.
+ * @param any_hit Return on the first hit instead of searching for the nearest one.
+ * @return Triangle or sphere hit in leaf order, or -1.
+ */
+static int engine_intersect_geometry(const PreparedScene* scene, const Object* instance, const EngineInstanceRay* ray,
+                                     float t_min, float* closest_t, int any_hit) {
+    const Mesh* mesh = NULL;
+    const SphereSet* set = NULL;
+    const Bvh* bvh;
+    EngineTriangleRay triangle_ray = { 0 };
+    if (instance->type == OBJECT_TYPE_MESH) {
+        mesh = &scene->meshes->meshes[instance->data.instanceData.geometry];
+        bvh = &mesh->bvh;
+        triangle_ray = engine_triangle_ray(ray->origin, ray->direction);
+    } else {
+        set = &scene->sphere_sets->sets[instance->data.instanceData.geometry];
+        bvh = &set->bvh;
     }
+    int best_primitive = -1;
+
+    int stack_nodes[BVH_MAX_DEPTH];
+    float stack_entries[BVH_MAX_DEPTH];
+    int stack_size = 0;
 
-    float total_intensity = 0.0f;
-    float t_max = 0.0;
+    if (bvh->node_count == 0 || engine_ray_node_entry(&bvh->nodes[0], ray->origin, ray->inverse_direction, t_min, *closest_t) == FLT_MAX) {
+        return -1;
+    }
 
-    Vector3 normalized_view_direction = vector3_normalize(view_direction);
+    int node_index = 0;
+    for (;;) {
+        const BvhNode* node = &bvh->nodes[node_index];
 
-    for (size_t i = 0; i < scene->lights->count; ++i) {
-        const Light* current_light = &(scene->lights->lights[i]); 
+        if (node->primitive_count > 0) {
+            const int hit = (mesh != NULL)
+                ? engine_intersect_triangles(&mesh->triangles, node->left_first, node->primitive_count, &triangle_ray, t_min, closest_t)
+                : engine_intersect_spheres(scene->kernels, &set->spheres, node->left_first, node->primitive_count, ray->origin,
+                                           ray->direction, t_min, FLT_MAX, closest_t);
+            if (hit >= 0) {
+                best_primitive = hit;
+                if (any_hit) {
+                    return hit;
+                }
+            }
+        } else {
+            int near_child = node->left_first;
+            int far_child = node->left_first + 1;
+            float near_entry = engine_ray_node_entry(&bvh->nodes[near_child], ray->origin, ray->inverse_direction, t_min, *closest_t);
+            float far_entry = engine_ray_node_entry(&bvh->nodes[far_child], ray->origin, ray->inverse_direction, t_min, *closest_t);
 
-        Vector3 light_direction;
+            if (far_entry < near_entry) {
+                int swap_child = near_child; near_child = far_child; far_child = swap_child;
+                float swap_entry = near_entry; near_entry = far_entry; far_entry = swap_entry;
+            }
 
-        switch (current_light->type) {
-            case LIGHT_TYPE_AMBIENT:
-                total_intensity += current_light->intensity;
+            if (near_entry != FLT_MAX) {
+                if (far_entry != FLT_MAX) {
+                    stack_nodes[stack_size] = far_child;
+                    stack_entries[stack_size] = far_entry;
+                    stack_size++;
+                }
+                node_index = near_child;
                 continue;
-            case LIGHT_TYPE_POINT:
-                light_direction = vector3_subtract(current_light->data.pointData.position, surface_point);
-                t_max = vector3_magnitude(light_direction);
+            }
+        }
+
+        node_index = -1;
+        while (stack_size > 0) {
+            stack_size--;
+            if (stack_entries[stack_size] < *closest_t) {
+                node_index = stack_nodes[stack_size];
                 break;
-            case LIGHT_TYPE_DIRECTIONAL:
-                light_direction = vector3_scale(current_light->data.directionalData.direction, 1.0f);
-                t_max = FLT_MAX;
+            }
+        }
+        if (node_index < 0) {
+            return best_primitive;
+        }
+    }
+}
+
+/**
+ * @brief Tests one ray against a contiguous range of mesh or sphere set instances.
+ * The ray is moved into the space of each instance rather than the shared geometry into the world.
+ * @param closest_t In: current closest distance. Out: updated when a nearer hit is found.
+ * @param primitive Out: triangle or sphere of the nearest hit, written only when a nearer hit is found.
+ * @return Index of the nearest instance hit in (t_min, min(t_max, closest_t)), or -1.
+ */
+static int engine_intersect_instances(const PreparedScene* scene, int first, int count, Vector3 ray_origin, Vector3 ray_direction,
+                                      Vector3 inverse_direction, float t_min, float t_max, float* closest_t, int* primitive, int any_hit) {
+    const Object* objects = scene->objects->objects;
+    float best_t = fminf(t_max, *closest_t);
+    int best_index = -1;
+
+    for (int i = first; i < first + count; ++i) {
+        const EngineInstanceRay ray = engine_instance_ray(scene, &objects[i], ray_origin, ray_direction, inverse_direction);
+        float local_t = fminf(best_t / ray.scale, FLT_MAX);   // Shrinking instances would push FLT_MAX to infinity
+        const int hit = engine_intersect_geometry(scene, &objects[i], &ray, t_min / ray.scale, &local_t, any_hit);
+        if (hit >= 0) {
+            best_t = local_t * ray.scale;
+            best_index = i;
+            *primitive = hit;
+            if (any_hit) {
                 break;
-            default:
-                fprintf(stderr, "Warning: Unknown Light Type encountered in engine_compute_light.\n");
-                continue;;
+            }
         }
+    }
+
+    if (best_index >= 0) {
+        *closest_t = best_t;
+    }
+    return best_index;
+}
 
-        // Normalize light direction
-        Vector3 normalized_light_direction = vector3_normalize(light_direction);
+/**
+ * @brief Tests a range of objects of a single type with that type's kernel.
+ * BVH leaves and the plane range never mix types, so the type of the first object decides.
+ * @param closest_intersection Nearest hit so far; updated in place when a nearer hit is found.
+ * @param any_hit Stop at the first hit found (shadow rays); only instances have more than one candidate worth skipping.
+ * @return 1 if a nearer hit was found, 0 otherwise.
+ */
+static int engine_intersect_uniform_range(const PreparedScene* scene, int first, int count, Vector3 ray_origin, Vector3 ray_direction,
+                                          Vector3 inverse_direction, float t_min, float t_max, ClosestIntersection* closest_intersection,
+                                          int any_hit) {
+    const ObjectList* objects = scene->objects;
+    float* hit_t = &closest_intersection->closest_t;
+    int hit = -1;
+
+    switch (objects->objects[first].type) {
+        case OBJECT_TYPE_SPHERE:
+            hit = engine_intersect_spheres(scene->kernels, &objects->spheres, first, count, ray_origin, ray_direction, t_min, t_max, hit_t);
+            break;
+        case OBJECT_TYPE_CUBE:
+        case OBJECT_TYPE_CUBOID:
+            hit = engine_intersect_boxes(objects->objects, first, count, ray_origin, inverse_direction, t_min, t_max, hit_t);
+            break;
+        case OBJECT_TYPE_PLANE:
+            hit = engine_intersect_planes(objects->objects, first, count, ray_origin, ray_direction, t_min, t_max, hit_t);
+            break;
+        case OBJECT_TYPE_MESH:
+        case OBJECT_TYPE_SPHERE_SET:
+            hit = engine_intersect_instances(scene, first, count, ray_origin, ray_direction, inverse_direction, t_min, t_max, hit_t,
+                                             &closest_intersection->primitive, any_hit);
+            break;
+    }
 
-        ClosestIntersection closest_intersection = engine_calculate_closest_intersection(scene->objects, surface_point, normalized_light_direction, EPSILON, t_max);
+    if (hit < 0) {
+        return 0;
+    }
+    closest_intersection->closest_object = &objects->objects[hit];
+    return 1;
+}
+
+/**
+ * @brief Tests a contiguous range of objects of any types and keeps the nearest hit.
+ * Used without a BVH, where objects are in insertion order: each run of equal types goes to its kernel.
+ * @param closest_intersection Nearest hit so far; updated in place.
+ */
+static void engine_intersect_object_range(const PreparedScene* scene, int first, int count, Vector3 ray_origin, Vector3 ray_direction,
+                                          Vector3 inverse_direction, float t_min, float t_max, ClosestIntersection* closest_intersection,
+                                          int any_hit) {
+    const Object* objects = scene->objects->objects;
+    const int end = first + count;
+    while (first < end) {
+        int run_end = first + 1;
+        while (run_end < end && objects[run_end].type == objects[first].type) {
+            ++run_end;
+        }
 
-        if (closest_intersection.closest_object != NULL) {
-            continue;
+        if (engine_intersect_uniform_range(scene, first, run_end - first, ray_origin, ray_direction, inverse_direction,
+                                           t_min, t_max, closest_intersection, any_hit) && any_hit) {
+            return;
         }
+        first = run_end;
+    }
+}
+
+/**
+ * @brief Finds the nearest object hit by a ray in (t_min, t_max).
+ * Walks the scene BVH front to back, nearer child first, and skips every
+ * subtree that starts beyond the closest hit found so far; the unbounded
+ * planes are tested afterwards. Falls back to testing every object when the
+ * scene has no BVH.
+ */
+ClosestIntersection engine_calculate_closest_intersection(const PreparedScene* scene, Vector3 ray_origin, Vector3 ray_direction, float t_min, float t_max) {
+    ClosestIntersection closest_intersection = { NULL, FLT_MAX, -1 };
+    const ObjectList* objects = scene->objects;
+    const Bvh* bvh = scene->bvh;
+
+    const Vector3 inverse_direction = vector3_new(
+        engine_safe_inverse(ray_direction.x),
+        engine_safe_inverse(ray_direction.y),
+        engine_safe_inverse(ray_direction.z)
+    );
+
+    if (bvh->node_count == 0) {
+        engine_intersect_object_range(scene, 0, objects->count, ray_origin, ray_direction, inverse_direction, t_min, t_max, &closest_intersection, 0);
+        return closest_intersection;
+    }
+
+    // Planes first: a near ground hit lets the traversal below cull everything behind it
+    const int plane_hit = engine_intersect_planes(objects->objects, scene->plane_first, scene->plane_count, ray_origin, ray_direction,
+                                                  t_min, t_max, &closest_intersection.closest_t);
+    if (plane_hit >= 0) {
+        closest_intersection.closest_object = &objects->objects[plane_hit];
+    }
+
+    // Pending subtrees together with the distance at which the ray enters them
+    int stack_nodes[BVH_MAX_DEPTH];
+    float stack_entries[BVH_MAX_DEPTH];
+    int stack_size = 0;
+
+    if (engine_ray_node_entry(&bvh->nodes[0], ray_origin, inverse_direction, t_min, fminf(t_max, closest_intersection.closest_t)) == FLT_MAX) {
+        return closest_intersection;
+    }
 
-        // --- DIFFUSE LIGHT (Lambertian Reflection) ---
-        // N · L (Normal dot Light direction)
-        float diffuse_dot_product = vector3_dot(surface_normal, normalized_light_direction);
+    int node_index = 0;
+    for (;;) {
+        const BvhNode* node = &bvh->nodes[node_index];
+        const float limit = fminf(t_max, closest_intersection.closest_t);
 
-        if (diffuse_dot_product > 0) {
-            total_intensity += current_light->intensity * diffuse_dot_product;
+        if (node->primitive_count > 0) {
+            engine_intersect_uniform_range(scene, node->left_first, node->primitive_count, ray_origin, ray_direction,
+                                           inverse_direction, t_min, limit, &closest_intersection, 0);
+        } else {
+            int near_child = node->left_first;
+            int far_child = node->left_first + 1;
+            float near_entry = engine_ray_node_entry(&bvh->nodes[near_child], ray_origin, inverse_direction, t_min, limit);
+            float far_entry = engine_ray_node_entry(&bvh->nodes[far_child], ray_origin, inverse_direction, t_min, limit);
+
+            if (far_entry < near_entry) {
+                int swap_child = near_child; near_child = far_child; far_child = swap_child;
+                float swap_entry = near_entry; near_entry = far_entry; far_entry = swap_entry;
+            }
+
+            if (near_entry != FLT_MAX) {
+                if (far_entry != FLT_MAX) {
+                    stack_nodes[stack_size] = far_child;
+                    stack_entries[stack_size] = far_entry;
+                    stack_size++;
+                }
+                node_index = near_child;
+                continue;
+            }
         }
 
-        // --- SPECULAR LIGHT (Phong Reflection Model) ---
-        if (specular_exponent > 0) {
-            // Calculate reflection vector R = 2 * (N · L) * N - L
-            Vector3 reflection_vector = vector3_subtract(
-                vector3_scale(surface_normal, 2.0f * diffuse_dot_product), normalized_light_direction
-            );
-            reflection_vector = vector3_normalize(reflection_vector);
-            // Compute R · V (Reflection dot View)
-            float reflection_dot_view = vector3_dot(reflection_vector, normalized_view_direction);
-            if (reflection_dot_view > 0) {
-                total_intensity += current_light->intensity * powf(reflection_dot_view, specular_exponent);
+        // Resume with the nearest pending subtree that can still contain a closer hit
+        node_index = -1;
+        while (stack_size > 0) {
+            stack_size--;
+            if (stack_entries[stack_size] < closest_intersection.closest_t) {
+                node_index = stack_nodes[stack_size];
+                break;
             }
         }
+        if (node_index < 0) {
+            break;
+        }
     }
 
-    return fmin(total_intensity, 1.0f); 
+    return closest_intersection;
 }
 
-ClosestIntersection engine_calculate_closest_intersection(ObjectList* objects, Vector3 ray_origin, Vector3 ray_direction, float t_min, float t_max) {
-    ClosestIntersection closest_intersection = { NULL, FLT_MAX};
+/**
+ * @brief Any-hit query: reports whether anything blocks the ray in (t_min, t_max).
+ * Unlike engine_calculate_closest_intersection it returns on the first valid
+ * intersection instead of searching for the nearest one.
+ */
+bool engine_is_occluded(const PreparedScene* scene, Vector3 ray_origin, Vector3 ray_direction, float t_min, float t_max) {
+    const ObjectList* objects = scene->objects;
+    const Bvh* bvh = scene->bvh;
+    ClosestIntersection blocker = { NULL, t_max, -1 };
+
+    engine_local_ray_counts.shadow++;
 
-    for (int i = 0; i < objects->count; ++i) {
-        Object* current_object = &(objects->objects[i]);
-        IntersectionRoots roots = engine_ray_sphere_intersection(ray_origin, ray_direction, *current_object);
+    const Vector3 inverse_direction = vector3_new(
+        engine_safe_inverse(ray_direction.x),
+        engine_safe_inverse(ray_direction.y),
+        engine_safe_inverse(ray_direction.z)
+    );
 
-        // Check if root1 is a valid intersection and closer than previous
-        if (roots.root1 > t_min && roots.root1 < t_max && roots.root1 < closest_intersection.closest_t) {
-            closest_intersection.closest_t = roots.root1;
-            closest_intersection.closest_object = current_object;
-        }
-        // Check if root2 is a valid intersection and closer than previous
-        if (roots.root2 > t_min && roots.root2 < t_max && roots.root2 < closest_intersection.closest_t) {
-            closest_intersection.closest_t = roots.root2;
-            closest_intersection.closest_object = current_object;
+    if (bvh->node_count == 0) {
+        // Small batches keep the SIMD kernels busy while still stopping early
+        for (int first = 0; first < objects->count && blocker.closest_object == NULL; first += ENGINE_OCCLUSION_BATCH) {
+            const int remaining = objects->count - first;
+            const int count = (remaining < ENGINE_OCCLUSION_BATCH) ? remaining : ENGINE_OCCLUSION_BATCH;
+            engine_intersect_object_range(scene, first, count, ray_origin, ray_direction, inverse_direction, t_min, t_max, &blocker, 1);
         }
+        return blocker.closest_object != NULL;
     }
 
-    return closest_intersection;
+    if (engine_intersect_planes(objects->objects, scene->plane_first, scene->plane_count, ray_origin, ray_direction, t_min, t_max, &blocker.closest_t) >= 0) {
+        return true;
+    }
+
+    // Order does not matter for an any-hit query, so no entry distances are kept
+    int stack[BVH_MAX_DEPTH];
+    int stack_size = 0;
+
+    if (engine_ray_node_entry(&bvh->nodes[0], ray_origin, inverse_direction, t_min, t_max) == FLT_MAX) {
+        return false;
+    }
+
+    int node_index = 0;
+    for (;;) {
+        const BvhNode* node = &bvh->nodes[node_index];
+
+        if (node->primitive_count > 0) {
+            if (engine_intersect_uniform_range(scene, node->left_first, node->primitive_count, ray_origin, ray_direction,
+                                               inverse_direction, t_min, t_max, &blocker, 1)) {
+                return true;
+            }
+        } else {
+            const int left = node->left_first;
+            const int left_hit = engine_ray_node_entry(&bvh->nodes[left], ray_origin, inverse_direction, t_min, t_max) != FLT_MAX;
+            const int right_hit = engine_ray_node_entry(&bvh->nodes[left + 1], ray_origin, inverse_direction, t_min, t_max) != FLT_MAX;
+
+            if (left_hit) {
+                if (right_hit) {
+                    stack[stack_size++] = left + 1;
+                }
+                node_index = left;
+                continue;
+            }
+            if (right_hit) {
+                node_index = left + 1;
+                continue;
+            }
+        }
+
+        if (stack_size == 0) {
+            return false;
+        }
+        node_index = stack[--stack_size];
+    }
 }
 
 /**
@@ -253,11 +1949,11 @@ ClosestIntersection engine_calculate_closest_intersection(ObjectList* objects, V
  * @return An IntersectionRoots struct containing the two intersection 't' values.
  * If no intersection, roots will be FLT_MAX.
  */
-IntersectionRoots engine_ray_sphere_intersection(Vector3 ray_origin, Vector3 ray_direction, const Object sphere_object) {
+IntersectionRoots engine_ray_sphere_intersection(Vector3 ray_origin, Vector3 ray_direction, const Object* sphere_object) {
     IntersectionRoots intersection_t_values = {FLT_MAX, FLT_MAX};
 
     // Vector from sphere center to ray origin: L = O - C
-    Vector3 origin_to_sphere_center = vector3_subtract(ray_origin, sphere_object.position);
+    Vector3 origin_to_sphere_center = vector3_subtract(ray_origin, sphere_object->position);
 
     // Quadratic equation coefficients: At^2 + Bt + C = 0
     // A = D · D (ray_direction dot ray_direction). If ray_direction is normalized, A = 1.
@@ -265,7 +1961,7 @@ IntersectionRoots engine_ray_sphere_intersection(Vector3 ray_origin, Vector3 ray
     // C = (L · L) - R^2
     const float a_coeff = vector3_dot(ray_direction, ray_direction);
     const float b_coeff = 2.0f * vector3_dot(origin_to_sphere_center, ray_direction);
-    const float c_coeff = vector3_dot(origin_to_sphere_center, origin_to_sphere_center) - (sphere_object.data.sphereData.radius * sphere_object.data.sphereData.radius);
+    const float c_coeff = vector3_dot(origin_to_sphere_center, origin_to_sphere_center) - (sphere_object->data.sphereData.radius * sphere_object->data.sphereData.radius);
 
     const float discriminant = (b_coeff * b_coeff) - (4.0f * a_coeff * c_coeff);
 
@@ -293,7 +1989,143 @@ IntersectionRoots engine_ray_sphere_intersection(Vector3 ray_origin, Vector3 ray
 }
 
 /**
- * @brief Draws a single pixel on the canvas using the engine's renderer.
+ * @brief Nearest intersection of a ray with a single object of any type.
+ * @param scene Prepared scene holding the object's geometry and transform, if it is an instance.
+ * @param ray_direction The direction of the ray (must be normalized).
+ * @return The distance to the nearest hit in (t_min, t_max), or FLT_MAX if there is none.
+ */
+float engine_ray_object_intersection(const PreparedScene* scene, Vector3 ray_origin, Vector3 ray_direction, const Object* object,
+                                     float t_min, float t_max) {
+    float t = FLT_MAX;
+
+    switch (object->type) {
+        case OBJECT_TYPE_SPHERE: {
+            IntersectionRoots roots = engine_ray_sphere_intersection(ray_origin, ray_direction, object);
+            t = (roots.root1 > t_min) ? roots.root1 : roots.root2;
+            break;
+        }
+        case OBJECT_TYPE_CUBE:
+        case OBJECT_TYPE_CUBOID: {
+            const Vector3 inverse_direction = vector3_new(
+                engine_safe_inverse(ray_direction.x),
+                engine_safe_inverse(ray_direction.y),
+                engine_safe_inverse(ray_direction.z)
+            );
+            t = engine_box_hit(object, ray_origin, inverse_direction, t_min);
+            break;
+        }
+        case OBJECT_TYPE_PLANE:
+            t = engine_plane_hit(object, ray_origin, ray_direction);
+            break;
+        case OBJECT_TYPE_MESH:
+        case OBJECT_TYPE_SPHERE_SET: {
+            const Vector3 inverse_direction = vector3_new(
+                engine_safe_inverse(ray_direction.x),
+                engine_safe_inverse(ray_direction.y),
+                engine_safe_inverse(ray_direction.z)
+            );
+            const EngineInstanceRay ray = engine_instance_ray(scene, object, ray_origin, ray_direction, inverse_direction);
+            float local_t = fminf(t_max / ray.scale, FLT_MAX);
+            if (engine_intersect_geometry(scene, object, &ray, t_min / ray.scale, &local_t, 0) >= 0) {
+                t = local_t * ray.scale;
+            }
+            break;
+        }
+    }
+
+    return (t > t_min && t < t_max) ? t : FLT_MAX;
+}
+
+/**
+ * @brief Material of the surface at a hit.
+ * Sphere set instances with OBJECT_MATERIAL_INHERIT use the material of the sphere that was hit;
+ * every other object uses its own.
+ */
+const PreparedMaterial* engine_hit_material(const PreparedScene* scene, const ClosestIntersection* hit) {
+    const Object* object = hit->closest_object;
+    if (object->material == OBJECT_MATERIAL_INHERIT) {
+        return &scene->materials[scene->sphere_sets->sets[object->data.instanceData.geometry].materials[hit->primitive]];
+    }
+    return &scene->materials[object->material];
+}
+
+/**
+ * @brief Unit normal of a hit on a mesh or sphere set instance: found in instance space, then rotated into the world.
+ */
+static Vector3 engine_instance_normal(const PreparedScene* scene, const ClosestIntersection* hit, Vector3 point, Vector3 ray_direction) {
+    const Object* instance = hit->closest_object;
+    const InstanceObjectData* data = &instance->data.instanceData;
+    const Transform* transform = (data->transform >= 0) ? &scene->transforms->transforms[data->transform] : NULL;
+
+    Vector3 normal;
+    if (instance->type == OBJECT_TYPE_MESH) {
+        normal = mesh_triangle_normal(&scene->meshes->meshes[data->geometry], hit->primitive);
+    } else {
+        const SphereSoA* spheres = &scene->sphere_sets->sets[data->geometry].spheres;
+        Vector3 local = vector3_subtract(point, instance->position);
+        if (transform != NULL) {
+            local = vector3_scale(transform_unrotate(transform, local), 1.0f / transform->scale);
+        }
+        const Vector3 center = vector3_new(spheres->center_x[hit->primitive], spheres->center_y[hit->primitive],
+                                           spheres->center_z[hit->primitive]);
+        normal = vector3_normalize(vector3_subtract(local, center));
+    }
+
+    if (transform != NULL) {
+        normal = transform_rotate(transform, normal);
+    }
+    if (instance->type == OBJECT_TYPE_MESH && vector3_dot(normal, ray_direction) > 0.0f) {
+        normal = vector3_scale(normal, -1.0f);
+    }
+    return normal;
+}
+
+/**
+ * @brief Unit surface normal at the hit point of a ray.
+ * Sphere and box normals point outwards; plane and triangle normals face the side the ray came from,
+ * so both sides of planes and of open meshes are lit.
+ * @param scene Prepared scene the hit was found in.
+ * @param hit The hit (closest_object != NULL); for instances, primitive selects the triangle or sphere.
+ * @param point The hit point.
+ * @param ray_direction Direction of the ray that hit the object.
+ * @return The normal at point.
+ */
+Vector3 engine_surface_normal(const PreparedScene* scene, const ClosestIntersection* hit, Vector3 point, Vector3 ray_direction) {
+    const Object* object = hit->closest_object;
+
+    switch (object->type) {
+        case OBJECT_TYPE_CUBE:
+        case OBJECT_TYPE_CUBOID: {
+            // The face whose slab the point is closest to leaving, relative to the box size
+            const Vector3 local = vector3_subtract(point, object->position);
+            const Vector3 half = object->data.boxData.half_extents;
+            const float x = fabsf(local.x) / half.x;
+            const float y = fabsf(local.y) / half.y;
+            const float z = fabsf(local.z) / half.z;
+            if (x >= y && x >= z) {
+                return vector3_new(copysignf(1.0f, local.x), 0.0f, 0.0f);
+            }
+            if (y >= z) {
+                return vector3_new(0.0f, copysignf(1.0f, local.y), 0.0f);
+            }
+            return vector3_new(0.0f, 0.0f, copysignf(1.0f, local.z));
+        }
+        case OBJECT_TYPE_PLANE: {
+            const Vector3 normal = object->data.planeData.normal;
+            return (vector3_dot(normal, ray_direction) > 0.0f) ? vector3_scale(normal, -1.0f) : normal;
+        }
+        case OBJECT_TYPE_MESH:
+        case OBJECT_TYPE_SPHERE_SET:
+            return engine_instance_normal(scene, hit, point, ray_direction);
+        case OBJECT_TYPE_SPHERE:
+        default:
+            // For a sphere, the normal is simply (point - center) normalized
+            return vector3_normalize(vector3_subtract(point, object->position));
+    }
+}
+
+/**
+ * @brief Writes a single pixel into the engine's framebuffer.
  * Handles coordinate system conversion from viewport to SDL.
  * @param engine Pointer to the Engine struct.
  * @param canvas Pointer to the Canvas struct.
@@ -307,18 +2139,15 @@ void engine_draw_pixel(Engine* engine, const Canvas* canvas, const Color* color,
         return;
     }
 
-    // Set the drawing color
-    SDL_SetRenderDrawColor(engine->renderer, color->r, color->g, color->b, 255);
-
     // Convert viewport coordinates (centered) to SDL screen coordinates (top-left origin)
     int sdl_x = (canvas->width / 2) + x;
     // SDL y-coordinates increase downwards, so we invert the viewport y and adjust for 0-indexing
-    int sdl_y = (canvas->height / 2) - y - 1;
+    int sdl_y = (canvas->height - canvas->height / 2 - 1) - y;
 
     // Perform boundary checks before drawing to prevent out-of-bounds access
     if (sdl_x >= 0 && sdl_x < canvas->width &&
         sdl_y >= 0 && sdl_y < canvas->height) {
-        SDL_RenderDrawPoint(engine->renderer, sdl_x, sdl_y);
+        engine->target.pixel_buffer[sdl_y * engine->target.width + sdl_x] = color_to_argb8888(color);
     } else {
         // This might indicate an issue with coordinate calculation or an oversized viewport
         // For debugging, you might want to print this, but for release, it might be too noisy.
@@ -331,9 +2160,13 @@ void engine_draw_pixel(Engine* engine, const Canvas* canvas, const Color* color,
  * @param engine Pointer to the Engine struct.
  */
 void engine_clean_up(Engine* engine) {
-    if (engine && engine->renderer) {
-        SDL_DestroyRenderer(engine->renderer);
-        engine->renderer = NULL; // Prevent double-free
+    if (engine) {
+        // Join the workers first; they never touch the target outside engine_render
+        thread_pool_clean_up(&engine->thread_pool);
+        engine_release_wavefronts(engine);
+        scene_prepared_free(&engine->prepared_scene);
+        reprojection_free(&engine->reprojection);
+        render_target_clean_up(&engine->target);
     }
     // SDL_Quit() and SDL_DestroyWindow() should be handled outside,
     // where SDL was initialized and the window created.
@@ -13,16 +13,94 @@
 #include "../color/color.h"
 #include "../object/object.h"
 #include "../vector/vector.h"
+#include "../render_target/render_target.h"
+#include "../thread_pool/thread_pool.h"
+#include "../wavefront/wavefront.h"
+#include "../reprojection/reprojection.h"
+#include "../kernels/kernels.h"
 
 #ifndef ENGINE_H
 #define ENGINE_H
 
+#define ENGINE_TILE_SIZE 32 ///< Edge length in pixels of the square tiles a frame is split into (must be even).
+#define ENGINE_PACKET_SIZE 4 ///< Rays per primary packet (a 2x2 pixel block).
+#define ENGINE_DEFAULT_RECURSION_DEPTH 3 ///< Reflection bounces traced per primary ray by default.
+#define ENGINE_MAX_RECURSIVE_DEPTH 256 ///< Most bounces the recursive paths follow (one C stack frame chain each); only wavefront tiles go deeper.
+#define ENGINE_OCCLUSION_BATCH 8 ///< Spheres tested between early-out checks when an occlusion query has no BVH.
+#define ENGINE_ADAPTIVE_CELL_SIZE 8 ///< Edge length of the coarsest adaptive sampling cell (must divide ENGINE_TILE_SIZE).
+#define ENGINE_DEFAULT_ADAPTIVE_TOLERANCE 8 ///< Largest per-channel difference (0-255) still considered smooth.
+#define ENGINE_STATS_DEPTH_BUCKETS 16 ///< Recursion-depth histogram buckets; deeper rays land in the last one.
+
+// Hot-path statistics are compiled in with -DENGINE_STATS=1 (make STATS=1) and cost nothing otherwise
+#ifndef ENGINE_STATS
+#define ENGINE_STATS 0
+#endif
+
+/**
+ * @brief Tunable rendering options.
+ */
+typedef struct EngineSettings {
+    int recursion_depth;           ///< Reflection bounces traced per primary ray; recursive paths stop at ENGINE_MAX_RECURSIVE_DEPTH.
+    int use_packets;               ///< Trace primary rays as 2x2 SIMD packets (1) or one by one (0).
+    int use_wavefront;             ///< Trace each tile breadth first through ray queues (1) or pixel by pixel (0).
+    int use_adaptive;              ///< Interpolate smooth regions from sparse primary rays (1) or trace every pixel (0).
+    int adaptive_tolerance;        ///< Per-channel color difference up to which adaptive cells are interpolated.
+    int use_reprojection;          ///< Reuse the previous frame's pixels where they reproject into the new view (1) or trace every pixel (0).
+} EngineSettings;
+
+/**
+ * @brief Rays traced since the counters were last reset, by kind.
+ */
+typedef struct EngineRayCounts {
+    SDL_atomic_t primary;          ///< Camera rays (one per traced pixel or sample).
+    SDL_atomic_t shadow;           ///< Occlusion rays towards lights.
+    SDL_atomic_t reflection;       ///< Secondary rays off reflective surfaces.
+} EngineRayCounts;
+
+/**
+ * @brief Detailed hot-path counters of a frame, collected only when ENGINE_STATS is enabled.
+ * Rays are counted per ray: a 4-wide packet test counts as four tests.
+ */
+typedef struct EngineStats {
+    long long sphere_tests;        ///< Ray-sphere intersection tests.
+    long long box_tests;           ///< Ray-box intersection tests against cubes and cuboids.
+    long long plane_tests;         ///< Ray-plane intersection tests.
+    long long triangle_tests;      ///< Ray-triangle intersection tests inside meshes.
+    long long node_tests;          ///< Ray-box tests against BVH nodes (scene and instance hierarchies).
+    long long closest_hits;        ///< Nearest-hit queries (primary and reflection rays) that hit an object.
+    long long occluded_shadow_rays;///< Shadow rays blocked before reaching their light.
+    long long lights_evaluated;    ///< Light contributions computed at surface points.
+    long long depth_histogram[ENGINE_STATS_DEPTH_BUCKETS]; ///< Rays traced per recursion level (0 = primary).
+} EngineStats;
+
+#if ENGINE_STATS
+// Counters of the calling thread; engine_render folds them into Engine.stats after every tile
+extern _Thread_local EngineStats engine_thread_stats;
+#define ENGINE_STATS_ADD(field, amount) (engine_thread_stats.field += (amount))
+#define ENGINE_STATS_DEPTH(level, amount) \
+    (engine_thread_stats.depth_histogram[((level) < ENGINE_STATS_DEPTH_BUCKETS) ? (level) : ENGINE_STATS_DEPTH_BUCKETS - 1] += (amount))
+#else
+#define ENGINE_STATS_ADD(field, amount) ((void)0)
+#define ENGINE_STATS_DEPTH(level, amount) ((void)0)
+#endif
+
 /**
  * @brief Represents the core rendering engine.
  */
 typedef struct Engine {
-    SDL_Renderer* renderer;        ///< SDL Renderer for drawing operations.
+    RenderTarget target;           ///< Framebuffer the engine renders into and the backend that displays it.
+    ThreadPool thread_pool;        ///< Persistent workers that trace the frame's tiles.
+    EngineSettings settings;       ///< Rendering options, read by all workers during a frame.
+    Wavefront* wavefronts;         ///< One set of wavefront queues per worker (NULL until wavefront mode is used).
+    int wavefront_count;
+    EngineRayCounts ray_counts;    ///< Rays traced since the last engine_render (or engine_reset_ray_counts).
+    EngineStats stats;             ///< Detailed counters over the same period (all zero unless ENGINE_STATS).
+    SDL_SpinLock stats_lock;       ///< Guards stats while workers fold in their thread-local counters.
     Color background_color;        ///< Background color of the scene.
+    PreparedScene prepared_scene;  ///< Invariants of the last rendered scene, rebuilt when its generation changes.
+    Reprojection reprojection;     ///< History of the last full frame (empty unless reprojection is used).
+    CpuLevel cpu_level;            ///< Instruction set level of the SIMD kernels in use.
+    const Kernels* kernels;        ///< Kernels of cpu_level; engine_render hands them to the workers through prepared_scene.
 } Engine;
 
 /**
@@ -35,10 +113,26 @@ typedef struct IntersectionRoots {
 } IntersectionRoots;
 
 typedef struct ClosestIntersection {
-    Object* closest_object;
+    const Object* closest_object;
     float closest_t;
+    int primitive;                 ///< Triangle or sphere hit when closest_object is an instance (in its geometry's leaf order); unused otherwise.
 } ClosestIntersection;
 
+/**
+ * @brief Primary rays of a 2x2 pixel block. All rays share the camera origin.
+ */
+typedef struct RayPacket {
+    Vector3 origin;
+    float direction_x[ENGINE_PACKET_SIZE];
+    float direction_y[ENGINE_PACKET_SIZE];
+    float direction_z[ENGINE_PACKET_SIZE];
+} RayPacket;
+
+/**
+ * @brief Returns the settings a freshly initialized engine renders with.
+ */
+EngineSettings engine_default_settings(void);
+
 /**
  * @brief Initializes the rendering engine.
  * @param engine Pointer to the Engine struct to initialize.
@@ -48,8 +142,37 @@ typedef struct ClosestIntersection {
  */
 int engine_init(Engine* engine, SDL_Window* window, Canvas* canvas);
 
+/**
+ * @brief Initializes the rendering engine with an in-memory framebuffer only.
+ * Does not require the SDL video subsystem, so it works on display-less machines.
+ * @param engine Pointer to the Engine struct to initialize.
+ * @param canvas Pointer to the Canvas struct.
+ * @return 0 on success, 1 on failure.
+ */
+int engine_init_offscreen(Engine* engine, Canvas* canvas);
+
+/**
+ * @brief Sets how many threads trace each frame.
+ * @param engine Pointer to the Engine struct.
+ * @param thread_count Number of worker threads including the caller; 0 selects one per logical CPU.
+ * @return 0 on success, 1 on failure (the engine then falls back to a single thread).
+ */
+int engine_set_thread_count(Engine* engine, int thread_count);
+
+/**
+ * @brief Forces the SIMD kernels of an instruction set level instead of the one detected by engine_init.
+ * Takes effect from the next frame this engine renders.
+ * @param engine Pointer to the Engine struct.
+ * @param level Level to use; must not exceed what cpu_detect_level reports.
+ * @return 0 on success, 1 if the CPU does not support the level (the kernels are left unchanged).
+ */
+int engine_set_cpu_level(Engine* engine, CpuLevel level);
+
 /**
  * @brief Renders the entire scene from the camera's perspective onto the canvas.
+ * The frame is split into ENGINE_TILE_SIZE tiles that are traced by the engine's thread pool.
+ * With settings.use_reprojection, pixels of the previous frame that still show the same surface
+ * are reused and only the rest, plus a rotating refresh subset, are traced.
  * @param engine Pointer to the Engine struct.
  * @param camera Pointer to the Camera struct.
  * @param scene Pointer to the Scene struct containing objects and lights.
@@ -58,7 +181,49 @@ int engine_init(Engine* engine, SDL_Window* window, Canvas* canvas);
 void engine_render(Engine* engine, const Camera* camera, const Scene* scene, const Canvas* canvas);
 
 /**
- * @brief Draws a single pixel on the canvas using the engine's renderer.
+ * @brief Clears the engine's ray counters and statistics. engine_render does this at the start of every frame.
+ * @param engine Pointer to the Engine struct.
+ */
+void engine_reset_ray_counts(Engine* engine);
+
+/**
+ * @brief Prints the ray counters and, when compiled with ENGINE_STATS, the detailed statistics.
+ * @param engine Pointer to the Engine struct.
+ * @param stream Destination stream.
+ */
+void engine_print_stats(const Engine* engine, FILE* stream);
+
+/**
+ * @brief Returns the number of ENGINE_TILE_SIZE tile rows covering the canvas.
+ */
+int engine_tile_row_count(const Canvas* canvas);
+
+/**
+ * @brief Renders a band of tile rows into the framebuffer without presenting it.
+ * Strides above 1 trace one primary ray per stride x stride block and fill the block with it,
+ * which is how the interactive viewer previews and progressively refines frames.
+ * @param engine Pointer to the Engine struct.
+ * @param camera Pointer to the Camera struct.
+ * @param scene Pointer to the Scene struct containing objects and lights.
+ * @param canvas Pointer to the Canvas struct.
+ * @param stride Pixel block edge length: a power of two no larger than ENGINE_TILE_SIZE.
+ * @param refine Non-zero when the band was last rendered at twice the stride with the same view;
+ * the samples of that pass are kept and only the new ones are traced.
+ * @param tile_row_begin First tile row to render.
+ * @param tile_row_end One past the last tile row to render.
+ */
+void engine_render_pass(Engine* engine, const Camera* camera, const Scene* scene, const Canvas* canvas,
+                        int stride, int refine, int tile_row_begin, int tile_row_end);
+
+/**
+ * @brief Presents the framebuffer through the engine's render target.
+ * SDL targets perform a single texture update per frame; offscreen targets do nothing.
+ * @param engine Pointer to the Engine struct.
+ */
+void engine_present(Engine* engine);
+
+/**
+ * @brief Writes a single pixel into the engine's framebuffer.
  * Handles coordinate system conversion from viewport to SDL.
  * @param engine Pointer to the Engine struct.
  * @param canvas Pointer to the Canvas struct.
@@ -74,26 +239,45 @@ void engine_draw_pixel(Engine* engine, const Canvas* canvas, const Color* color,
  */
 void engine_clean_up(Engine* engine);
 
+/*
+ * The trace kernels below read scenes only through the PreparedScene built by scene_prepare
+ * and expect every ray direction to be a unit vector; the sphere tests rely on D.D = 1.
+ */
+
 /**
  * @brief Traces a ray into the scene to determine the color of the intersected object.
- * @param camera Pointer to the Camera from which the ray originates.
- * @param scene Pointer to the Scene containing objects and lights.
+ * @param origin Origin of the ray.
+ * @param scene Pointer to the prepared scene.
+ * @param ray_direction Unit direction vector of the ray.
+ * @param recursion_depth Remaining reflection bounces.
+ * @param t_min Hits at or before this distance are ignored (EPSILON avoids self-intersection).
+ * @param t_max Hits at or beyond this distance are ignored.
+ * @return The color of the nearest hit, or the scene's background color if nothing is hit in (t_min, t_max).
+ */
+Color engine_trace_ray(Vector3 origin, const PreparedScene* scene, Vector3 ray_direction, int recursion_depth, float t_min, float t_max);
+
+/**
+ * @brief Computes the color seen along a ray whose nearest hit is already known.
+ * Reflections are traced with engine_trace_ray.
+ * @param scene Pointer to the prepared scene.
+ * @param origin Origin of the ray.
  * @param ray_direction Direction vector of the ray.
- * @param background_color The color to return if no object is hit.
- * @return The computed color of the pixel.
+ * @param closest_intersection Nearest hit of the ray (closest_object == NULL for a miss).
+ * @param recursion_depth Remaining reflection bounces.
+ * @return The computed color.
  */
-Color engine_trace_ray(Vector3 origin, const Scene* scene, Vector3 ray_direction, int recursion_depth, float t_min, float t_max);
+Color engine_shade_intersection(const PreparedScene* scene, Vector3 origin, Vector3 ray_direction, const ClosestIntersection* closest_intersection, int recursion_depth);
 
 /**
  * @brief Computes the total light intensity at a given surface point.
- * @param lights_list Pointer to the list of lights in the scene.
+ * @param scene Pointer to the prepared scene; its ambient lights are already folded into one term.
  * @param surface_point The 3D point on the object's surface.
  * @param surface_normal The normal vector at the surface_point.
- * @param specular_exponent The specular exponent of the material.
- * @param view_direction Direction vector from the surface point to the camera.
+ * @param specular Specular response of the material, or NULL for matte materials.
+ * @param view_direction Unit vector from the surface point to the camera.
  * @return The total light intensity.
  */
-float engine_compute_light(const Scene* scene, Vector3 surface_point, Vector3 surface_normal, int specular_exponent, Vector3 view_direction);
+float engine_compute_light(const PreparedScene* scene, Vector3 surface_point, Vector3 surface_normal, const SpecularTable* specular, Vector3 view_direction);
 
 /**
  * @brief Calculates the intersection points of a ray with a sphere.
@@ -103,9 +287,62 @@ float engine_compute_light(const Scene* scene, Vector3 surface_point, Vector3 su
  * @return An IntersectionRoots struct containing the two intersection 't' values.
  * If no intersection, roots will be FLT_MAX.
  */
-IntersectionRoots engine_ray_sphere_intersection(Vector3 ray_origin, Vector3 ray_direction, const Object sphere_object);
+IntersectionRoots engine_ray_sphere_intersection(Vector3 ray_origin, Vector3 ray_direction, const Object* sphere_object);
+
+/**
+ * @brief Nearest intersection of a ray with a single object of any type.
+ * @param scene Prepared scene holding the object's geometry and transform, if it is an instance.
+ * @param ray_origin The origin of the ray.
+ * @param ray_direction The direction of the ray (must be normalized).
+ * @param object The object to intersect with.
+ * @param t_min Hits at or before this distance are ignored.
+ * @param t_max Hits at or beyond this distance are ignored.
+ * @return The distance to the nearest hit, or FLT_MAX if there is none.
+ */
+float engine_ray_object_intersection(const PreparedScene* scene, Vector3 ray_origin, Vector3 ray_direction, const Object* object,
+                                     float t_min, float t_max);
 
-ClosestIntersection engine_calculate_closest_intersection(ObjectList* objects, Vector3 ray_origin, Vector3 ray_direction, float t_min, float t_max);
+/**
+ * @brief Unit surface normal at the hit point of a ray.
+ * Plane and triangle normals are flipped to face the incoming ray.
+ * @param scene Prepared scene the hit was found in.
+ * @param hit The hit (closest_object != NULL); for instances, primitive selects the triangle or sphere.
+ * @param point The hit point.
+ * @param ray_direction Direction of the ray that hit the object.
+ * @return The normal at point.
+ */
+Vector3 engine_surface_normal(const PreparedScene* scene, const ClosestIntersection* hit, Vector3 point, Vector3 ray_direction);
+
+/**
+ * @brief Material of the surface at a hit (closest_object != NULL).
+ * Sphere set instances without a material override use the material of the sphere that was hit.
+ */
+const PreparedMaterial* engine_hit_material(const PreparedScene* scene, const ClosestIntersection* hit);
+
+/**
+ * @brief Finds the nearest object hit by a ray in (t_min, t_max).
+ * Tests the planes, then traverses the scene BVH in front-to-back order when one has been built;
+ * instances continue the walk in the BVH of their geometry, in instance space.
+ * @param scene Pointer to the prepared scene to intersect.
+ * @param ray_origin The origin of the ray.
+ * @param ray_direction The direction of the ray (must be normalized).
+ * @param t_min Hits at or before this distance are ignored.
+ * @param t_max Hits at or beyond this distance are ignored.
+ * @return The nearest hit, or closest_object == NULL if nothing was hit.
+ */
+ClosestIntersection engine_calculate_closest_intersection(const PreparedScene* scene, Vector3 ray_origin, Vector3 ray_direction, float t_min, float t_max);
+
+/**
+ * @brief Any-hit query: reports whether anything blocks the ray in (t_min, t_max).
+ * Returns on the first valid intersection; used for every shadow test.
+ * @param scene Pointer to the prepared scene to intersect.
+ * @param ray_origin The origin of the ray.
+ * @param ray_direction The direction of the ray (must be normalized).
+ * @param t_min Hits at or before this distance are ignored.
+ * @param t_max Hits at or beyond this distance are ignored (e.g. the distance to a point light).
+ * @return true if the ray is blocked.
+ */
+bool engine_is_occluded(const PreparedScene* scene, Vector3 ray_origin, Vector3 ray_direction, float t_min, float t_max);
 
 Vector3 engine_reflect_ray(Vector3 ray_direction, Vector3 surface_normal);
 
@@ -0,0 +1,594 @@
+#include "./kernels.h"
+
+#include <float.h>
+#include <stddef.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define KERNELS_X86 1
+// Each variant is compiled for its own instruction set, so the rest of the build stays baseline
+#define KERNELS_SSE __attribute__((target("sse4.2")))
+#define KERNELS_AVX2 __attribute__((target("avx2")))
+#define KERNELS_AVX512 __attribute__((target("avx512f")))
+#else
+#define KERNELS_X86 0
+#endif
+
+// PreparedLight viewed as an array of 32-bit words, for the gathers of the wide light kernels
+#define KERNELS_LIGHT_STRIDE ((int)(sizeof(PreparedLight) / sizeof(float)))
+#define KERNELS_LIGHT_TYPE ((int)(offsetof(PreparedLight, type) / sizeof(float)))
+#define KERNELS_LIGHT_INTENSITY ((int)(offsetof(PreparedLight, intensity) / sizeof(float)))
+#define KERNELS_LIGHT_VECTOR ((int)(offsetof(PreparedLight, vector) / sizeof(float)))
+
+_Static_assert(sizeof(LightType) == sizeof(float) && sizeof(PreparedLight) % sizeof(float) == 0,
+               "PreparedLight must be made of 32-bit words");
+
+// --- Scalar reference ---
+
+// Nearest valid root of one ray-sphere quadratic, or FLT_MAX if there is none in (t_min, t_max).
+// Uses the half-b form with a = D.D = 1 for unit directions: t = -b' -+ sqrt(b'^2 - c) with b' = L.D.
+static float kernels_sphere_nearest_root(const SphereSoA* spheres, int index, Vector3 origin, Vector3 direction,
+                                         float t_min, float t_max) {
+    const float lx = origin.x - spheres->center_x[index];
+    const float ly = origin.y - spheres->center_y[index];
+    const float lz = origin.z - spheres->center_z[index];
+
+    const float half_b = lx * direction.x + ly * direction.y + lz * direction.z;
+    const float c_coeff = lx * lx + ly * ly + lz * lz - spheres->radius_sq[index];
+    const float discriminant = half_b * half_b - c_coeff;
+
+    if (discriminant < 0.0f) {
+        return FLT_MAX;
+    }
+
+    const float sqrt_discriminant = sqrtf(discriminant);
+    const float near_root = -half_b - sqrt_discriminant;
+    const float far_root = -half_b + sqrt_discriminant;
+
+    if (near_root > t_min && near_root < t_max) return near_root;
+    if (far_root > t_min && far_root < t_max) return far_root;
+    return FLT_MAX;
+}
+
+// Tests spheres [i, end) one at a time against *best_t: the scalar kernel, and the tail of the SSE one
+static void kernels_spheres_tail(const SphereSoA* spheres, int i, int end, Vector3 origin, Vector3 direction,
+                                 float t_min, float* best_t, int* best_index) {
+    for (; i < end; ++i) {
+        const float t = kernels_sphere_nearest_root(spheres, i, origin, direction, t_min, *best_t);
+        if (t < *best_t) {
+            *best_t = t;
+            *best_index = i;
+        }
+    }
+}
+
+static int kernels_intersect_spheres_scalar(const SphereSoA* spheres, int first, int count, Vector3 origin, Vector3 direction,
+                                            float t_min, float* closest_t) {
+    float best_t = *closest_t;
+    int best_index = -1;
+    kernels_spheres_tail(spheres, first, first + count, origin, direction, t_min, &best_t, &best_index);
+    if (best_index >= 0) {
+        *closest_t = best_t;
+    }
+    return best_index;
+}
+
+float kernels_light_contribution(const PreparedLight* light, Vector3 point, Vector3 normal, const SpecularTable* specular,
+                                 Vector3 view_direction, Vector3* light_direction, float* t_max) {
+    Vector3 direction;
+
+    if (light->type == LIGHT_TYPE_POINT) {
+        Vector3 unnormalized_direction = vector3_subtract(light->vector, point);
+        *t_max = vector3_magnitude(unnormalized_direction);
+        direction = vector3_scale(unnormalized_direction, 1.0f / *t_max);
+    } else {
+        // Directional lights were normalized once by scene_prepare
+        direction = light->vector;
+        *t_max = FLT_MAX;
+    }
+    *light_direction = direction;
+
+    float contribution = 0.0f;
+
+    // Diffuse (Lambertian) term N.L
+    float diffuse_dot_product = vector3_dot(normal, direction);
+    if (diffuse_dot_product > 0) {
+        contribution += light->intensity * diffuse_dot_product;
+    }
+
+    // Specular (Phong) term (R.V)^exponent with R = 2 (N.L) N - L, a unit vector since N and L are
+    if (specular != NULL) {
+        Vector3 reflection = vector3_subtract(vector3_scale(normal, 2.0f * diffuse_dot_product), direction);
+        float reflection_dot_view = vector3_dot(reflection, view_direction);
+        if (reflection_dot_view > 0) {
+            contribution += light->intensity * specular_table_lookup(specular, reflection_dot_view);
+        }
+    }
+
+    return contribution;
+}
+
+static void kernels_light_terms_scalar(const PreparedLight* lights, int count, Vector3 point, Vector3 normal,
+                                       const SpecularTable* specular, Vector3 view_direction, KernelLightTerms* terms) {
+    for (int i = 0; i < count; ++i) {
+        Vector3 direction;
+        terms->contribution[i] = kernels_light_contribution(&lights[i], point, normal, specular, view_direction,
+                                                            &direction, &terms->t_max[i]);
+        terms->direction_x[i] = direction.x;
+        terms->direction_y[i] = direction.y;
+        terms->direction_z[i] = direction.z;
+    }
+}
+
+// Channel in [0, 255] truncated to 8 bits; NaN becomes 255 like the SIMD min/max sequence
+static inline unsigned int kernels_channel(float value) {
+    value = value < 255.0f ? value : 255.0f;
+    value = value > 0.0f ? value : 0.0f;
+    return (unsigned int)(int)value;
+}
+
+static void kernels_pack_pixels_scalar(const float* rgb, unsigned int* pixels, int count) {
+    for (int i = 0; i < count; ++i) {
+        pixels[i] = 0xFF000000u | (kernels_channel(rgb[3 * i]) << 16) | (kernels_channel(rgb[3 * i + 1]) << 8)
+                  | kernels_channel(rgb[3 * i + 2]);
+    }
+}
+
+const Kernels kernels_scalar = {
+    CPU_LEVEL_SCALAR,
+    kernels_intersect_spheres_scalar,
+    kernels_light_terms_scalar,
+    kernels_pack_pixels_scalar
+};
+
+#if KERNELS_X86
+
+// Keeps the nearest of the per-lane results
+static void kernels_keep_nearest(const float* lane_t, const int* lane_index, int lanes, float* best_t, int* best_index) {
+    for (int lane = 0; lane < lanes; ++lane) {
+        if (lane_index[lane] >= 0 && lane_t[lane] < *best_t) {
+            *best_t = lane_t[lane];
+            *best_index = lane_index[lane];
+        }
+    }
+}
+
+// --- SSE4.2: 4 lanes ---
+
+KERNELS_SSE static int kernels_intersect_spheres_sse(const SphereSoA* spheres, int first, int count, Vector3 origin, Vector3 direction,
+                                                     float t_min, float* closest_t) {
+    const int end = first + count;
+    float best_t = *closest_t;
+    int best_index = -1;
+    int i = first;
+
+    const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+    const __m128 dx = _mm_set1_ps(direction.x), dy = _mm_set1_ps(direction.y), dz = _mm_set1_ps(direction.z);
+    const __m128 tmin = _mm_set1_ps(t_min), zero = _mm_setzero_ps();
+    __m128 lane_t = _mm_set1_ps(best_t);
+    __m128i lane_index = _mm_set1_epi32(-1);
+    __m128i index = _mm_add_epi32(_mm_set1_epi32(i), _mm_setr_epi32(0, 1, 2, 3));
+
+    for (; i + 4 <= end; i += 4) {
+        const __m128 lx = _mm_sub_ps(ox, _mm_loadu_ps(spheres->center_x + i));
+        const __m128 ly = _mm_sub_ps(oy, _mm_loadu_ps(spheres->center_y + i));
+        const __m128 lz = _mm_sub_ps(oz, _mm_loadu_ps(spheres->center_z + i));
+
+        const __m128 half_b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, dx), _mm_mul_ps(ly, dy)), _mm_mul_ps(lz, dz));
+        const __m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz)), _mm_loadu_ps(spheres->radius_sq + i));
+        const __m128 discriminant = _mm_sub_ps(_mm_mul_ps(half_b, half_b), c);
+        const __m128 real = _mm_cmpge_ps(discriminant, zero);
+
+        const __m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+        const __m128 near_root = _mm_sub_ps(_mm_sub_ps(zero, half_b), root);
+        const __m128 far_root = _mm_add_ps(_mm_sub_ps(zero, half_b), root);
+
+        // Prefer the near root; fall back to the far root when the origin is inside the sphere
+        const __m128 near_ok = _mm_and_ps(_mm_cmpgt_ps(near_root, tmin), _mm_cmplt_ps(near_root, lane_t));
+        const __m128 t = _mm_blendv_ps(far_root, near_root, near_ok);
+        const __m128 hit = _mm_and_ps(real, _mm_and_ps(_mm_cmpgt_ps(t, tmin), _mm_cmplt_ps(t, lane_t)));
+
+        lane_t = _mm_blendv_ps(lane_t, t, hit);
+        lane_index = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(lane_index), _mm_castsi128_ps(index), hit));
+        index = _mm_add_epi32(index, _mm_set1_epi32(4));
+    }
+
+    float lane_t_values[4];
+    int lane_index_values[4];
+    _mm_storeu_ps(lane_t_values, lane_t);
+    _mm_storeu_si128((__m128i*)lane_index_values, lane_index);
+    kernels_keep_nearest(lane_t_values, lane_index_values, 4, &best_t, &best_index);
+
+    kernels_spheres_tail(spheres, i, end, origin, direction, t_min, &best_t, &best_index);
+
+    if (best_index >= 0) {
+        *closest_t = best_t;
+    }
+    return best_index;
+}
+
+// Lights are stored as an array of structures; each lane reads its own, and lanes past count repeat the last one
+KERNELS_SSE static void kernels_light_terms_sse(const PreparedLight* lights, int count, Vector3 point, Vector3 normal,
+                                                const SpecularTable* specular, Vector3 view_direction, KernelLightTerms* terms) {
+    const __m128 px = _mm_set1_ps(point.x), py = _mm_set1_ps(point.y), pz = _mm_set1_ps(point.z);
+    const __m128 nx = _mm_set1_ps(normal.x), ny = _mm_set1_ps(normal.y), nz = _mm_set1_ps(normal.z);
+    const __m128 vx = _mm_set1_ps(view_direction.x), vy = _mm_set1_ps(view_direction.y), vz = _mm_set1_ps(view_direction.z);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), far = _mm_set1_ps(FLT_MAX);
+
+    for (int i = 0; i < count; i += 4) {
+        const PreparedLight* l[4];
+        for (int lane = 0; lane < 4; ++lane) {
+            l[lane] = &lights[i + lane < count ? i + lane : count - 1];
+        }
+
+        const __m128 is_point = _mm_castsi128_ps(_mm_cmpeq_epi32(
+            _mm_setr_epi32((int)l[0]->type, (int)l[1]->type, (int)l[2]->type, (int)l[3]->type), _mm_set1_epi32(LIGHT_TYPE_POINT)));
+        const __m128 intensity = _mm_setr_ps(l[0]->intensity, l[1]->intensity, l[2]->intensity, l[3]->intensity);
+        const __m128 lx = _mm_setr_ps(l[0]->vector.x, l[1]->vector.x, l[2]->vector.x, l[3]->vector.x);
+        const __m128 ly = _mm_setr_ps(l[0]->vector.y, l[1]->vector.y, l[2]->vector.y, l[3]->vector.y);
+        const __m128 lz = _mm_setr_ps(l[0]->vector.z, l[1]->vector.z, l[2]->vector.z, l[3]->vector.z);
+
+        // Point lights: direction to the light scaled by the reciprocal of its length; directional lights as stored
+        const __m128 ux = _mm_sub_ps(lx, px), uy = _mm_sub_ps(ly, py), uz = _mm_sub_ps(lz, pz);
+        const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ux, ux), _mm_mul_ps(uy, uy)), _mm_mul_ps(uz, uz)));
+        const __m128 inverse = _mm_div_ps(one, length);
+        const __m128 dx = _mm_blendv_ps(lx, _mm_mul_ps(ux, inverse), is_point);
+        const __m128 dy = _mm_blendv_ps(ly, _mm_mul_ps(uy, inverse), is_point);
+        const __m128 dz = _mm_blendv_ps(lz, _mm_mul_ps(uz, inverse), is_point);
+
+        const __m128 diffuse = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, dx), _mm_mul_ps(ny, dy)), _mm_mul_ps(nz, dz));
+        __m128 contribution = _mm_and_ps(_mm_mul_ps(intensity, diffuse), _mm_cmpgt_ps(diffuse, zero));
+
+        if (specular != NULL) {
+            const __m128 two_diffuse = _mm_mul_ps(two, diffuse);
+            const __m128 rx = _mm_sub_ps(_mm_mul_ps(nx, two_diffuse), dx);
+            const __m128 ry = _mm_sub_ps(_mm_mul_ps(ny, two_diffuse), dy);
+            const __m128 rz = _mm_sub_ps(_mm_mul_ps(nz, two_diffuse), dz);
+            float reflection_dot_view[4], response[4];
+            _mm_storeu_ps(reflection_dot_view, _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, vx), _mm_mul_ps(ry, vy)), _mm_mul_ps(rz, vz)));
+            for (int lane = 0; lane < 4; ++lane) {
+                response[lane] = specular_table_lookup(specular, reflection_dot_view[lane]);
+            }
+            // The table is 0 at and below its start, which is positive, so adding it for R.V <= 0 adds nothing
+            contribution = _mm_add_ps(contribution, _mm_mul_ps(intensity, _mm_loadu_ps(response)));
+        }
+
+        _mm_storeu_ps(terms->contribution + i, contribution);
+        _mm_storeu_ps(terms->direction_x + i, dx);
+        _mm_storeu_ps(terms->direction_y + i, dy);
+        _mm_storeu_ps(terms->direction_z + i, dz);
+        _mm_storeu_ps(terms->t_max + i, _mm_blendv_ps(far, length, is_point));
+    }
+}
+
+// Clamps to [0, 255] and truncates; NaN becomes 255
+KERNELS_SSE static inline __m128i kernels_channels_sse(__m128 values) {
+    return _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(values, _mm_set1_ps(255.0f)), _mm_setzero_ps()));
+}
+
+KERNELS_SSE static void kernels_pack_pixels_sse(const float* rgb, unsigned int* pixels, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float* p = rgb + 3 * i;
+        const __m128i r = kernels_channels_sse(_mm_setr_ps(p[0], p[3], p[6], p[9]));
+        const __m128i g = kernels_channels_sse(_mm_setr_ps(p[1], p[4], p[7], p[10]));
+        const __m128i b = kernels_channels_sse(_mm_setr_ps(p[2], p[5], p[8], p[11]));
+        const __m128i argb = _mm_or_si128(_mm_or_si128(_mm_set1_epi32((int)0xFF000000u), _mm_slli_epi32(r, 16)),
+                                          _mm_or_si128(_mm_slli_epi32(g, 8), b));
+        _mm_storeu_si128((__m128i*)(pixels + i), argb);
+    }
+    kernels_pack_pixels_scalar(rgb + 3 * i, pixels + i, count - i);
+}
+
+static const Kernels kernels_sse = {
+    CPU_LEVEL_SSE,
+    kernels_intersect_spheres_sse,
+    kernels_light_terms_sse,
+    kernels_pack_pixels_sse
+};
+
+// --- AVX2: 8 lanes, masked tails ---
+
+KERNELS_AVX2 static int kernels_intersect_spheres_avx2(const SphereSoA* spheres, int first, int count, Vector3 origin, Vector3 direction,
+                                                       float t_min, float* closest_t) {
+    const int end = first + count;
+    float best_t = *closest_t;
+    int best_index = -1;
+
+    const __m256 ox = _mm256_set1_ps(origin.x), oy = _mm256_set1_ps(origin.y), oz = _mm256_set1_ps(origin.z);
+    const __m256 dx = _mm256_set1_ps(direction.x), dy = _mm256_set1_ps(direction.y), dz = _mm256_set1_ps(direction.z);
+    const __m256 tmin = _mm256_set1_ps(t_min), zero = _mm256_setzero_ps();
+    __m256 lane_t = _mm256_set1_ps(best_t);
+    __m256i lane_index = _mm256_set1_epi32(-1);
+    __m256i index = _mm256_add_epi32(_mm256_set1_epi32(first), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+    for (int i = first; i < end; i += 8) {
+        // Lanes past the end load nothing and never hit
+        const __m256i valid = _mm256_cmpgt_epi32(_mm256_set1_epi32(end), index);
+        const __m256 lx = _mm256_sub_ps(ox, _mm256_maskload_ps(spheres->center_x + i, valid));
+        const __m256 ly = _mm256_sub_ps(oy, _mm256_maskload_ps(spheres->center_y + i, valid));
+        const __m256 lz = _mm256_sub_ps(oz, _mm256_maskload_ps(spheres->center_z + i, valid));
+
+        // Separate multiplies and adds, not FMA, so that the results match the scalar kernel exactly
+        const __m256 half_b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, dx), _mm256_mul_ps(ly, dy)), _mm256_mul_ps(lz, dz));
+        const __m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly)), _mm256_mul_ps(lz, lz)),
+                                       _mm256_maskload_ps(spheres->radius_sq + i, valid));
+        const __m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(half_b, half_b), c);
+        const __m256 real = _mm256_and_ps(_mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ), _mm256_castsi256_ps(valid));
+
+        const __m256 root = _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero));
+        const __m256 near_root = _mm256_sub_ps(_mm256_sub_ps(zero, half_b), root);
+        const __m256 far_root = _mm256_add_ps(_mm256_sub_ps(zero, half_b), root);
+
+        // Prefer the near root; fall back to the far root when the origin is inside the sphere
+        const __m256 near_ok = _mm256_and_ps(_mm256_cmp_ps(near_root, tmin, _CMP_GT_OQ), _mm256_cmp_ps(near_root, lane_t, _CMP_LT_OQ));
+        const __m256 t = _mm256_blendv_ps(far_root, near_root, near_ok);
+        const __m256 hit = _mm256_and_ps(real, _mm256_and_ps(_mm256_cmp_ps(t, tmin, _CMP_GT_OQ), _mm256_cmp_ps(t, lane_t, _CMP_LT_OQ)));
+
+        lane_t = _mm256_blendv_ps(lane_t, t, hit);
+        lane_index = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(lane_index), _mm256_castsi256_ps(index), hit));
+        index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+    }
+
+    float lane_t_values[8];
+    int lane_index_values[8];
+    _mm256_storeu_ps(lane_t_values, lane_t);
+    _mm256_storeu_si256((__m256i*)lane_index_values, lane_index);
+    kernels_keep_nearest(lane_t_values, lane_index_values, 8, &best_t, &best_index);
+
+    if (best_index >= 0) {
+        *closest_t = best_t;
+    }
+    return best_index;
+}
+
+// (R.V)^exponent from the table, matching specular_table_lookup lane by lane
+KERNELS_AVX2 static __m256 kernels_specular_avx2(const SpecularTable* table, __m256 x) {
+    const __m256 start = _mm256_set1_ps(table->start);
+    const __m256 position = _mm256_mul_ps(_mm256_sub_ps(x, start), _mm256_set1_ps(table->scale));
+    const __m256i index = _mm256_max_epi32(_mm256_cvttps_epi32(position), _mm256_setzero_si256());
+    const __m256 at_end = _mm256_castsi256_ps(_mm256_cmpgt_epi32(index, _mm256_set1_epi32(SPECULAR_TABLE_SIZE - 1)));
+    const __m256i clamped = _mm256_min_epi32(index, _mm256_set1_epi32(SPECULAR_TABLE_SIZE - 1));
+
+    const __m256 low = _mm256_i32gather_ps(table->values, clamped, 4);
+    const __m256 high = _mm256_i32gather_ps(table->values + 1, clamped, 4);
+    const __m256 fraction = _mm256_sub_ps(position, _mm256_cvtepi32_ps(clamped));
+    const __m256 value = _mm256_blendv_ps(_mm256_add_ps(low, _mm256_mul_ps(fraction, _mm256_sub_ps(high, low))),
+                                          _mm256_set1_ps(table->values[SPECULAR_TABLE_SIZE]), at_end);
+    return _mm256_and_ps(value, _mm256_cmp_ps(x, start, _CMP_GT_OQ));
+}
+
+// Lights are gathered straight from the array of structures; lanes past count read nothing
+KERNELS_AVX2 static void kernels_light_terms_avx2(const PreparedLight* lights, int count, Vector3 point, Vector3 normal,
+                                                  const SpecularTable* specular, Vector3 view_direction, KernelLightTerms* terms) {
+    const __m256 px = _mm256_set1_ps(point.x), py = _mm256_set1_ps(point.y), pz = _mm256_set1_ps(point.z);
+    const __m256 nx = _mm256_set1_ps(normal.x), ny = _mm256_set1_ps(normal.y), nz = _mm256_set1_ps(normal.z);
+    const __m256 vx = _mm256_set1_ps(view_direction.x), vy = _mm256_set1_ps(view_direction.y), vz = _mm256_set1_ps(view_direction.z);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f), far = _mm256_set1_ps(FLT_MAX);
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i offsets = _mm256_mullo_epi32(lane, _mm256_set1_epi32(KERNELS_LIGHT_STRIDE));
+
+    for (int i = 0; i < count; i += 8) {
+        const __m256i valid = _mm256_cmpgt_epi32(_mm256_set1_epi32(count - i), lane);
+        const __m256 valid_ps = _mm256_castsi256_ps(valid);
+        const float* words = (const float*)(lights + i);
+
+        const __m256i type = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*)words + KERNELS_LIGHT_TYPE, offsets, valid, 4);
+        const __m256 is_point = _mm256_castsi256_ps(_mm256_cmpeq_epi32(type, _mm256_set1_epi32(LIGHT_TYPE_POINT)));
+        const __m256 intensity = _mm256_mask_i32gather_ps(zero, words + KERNELS_LIGHT_INTENSITY, offsets, valid_ps, 4);
+        const __m256 lx = _mm256_mask_i32gather_ps(zero, words + KERNELS_LIGHT_VECTOR, offsets, valid_ps, 4);
+        const __m256 ly = _mm256_mask_i32gather_ps(zero, words + KERNELS_LIGHT_VECTOR + 1, offsets, valid_ps, 4);
+        const __m256 lz = _mm256_mask_i32gather_ps(zero, words + KERNELS_LIGHT_VECTOR + 2, offsets, valid_ps, 4);
+
+        const __m256 ux = _mm256_sub_ps(lx, px), uy = _mm256_sub_ps(ly, py), uz = _mm256_sub_ps(lz, pz);
+        const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ux, ux), _mm256_mul_ps(uy, uy)), _mm256_mul_ps(uz, uz)));
+        const __m256 inverse = _mm256_div_ps(one, length);
+        const __m256 dx = _mm256_blendv_ps(lx, _mm256_mul_ps(ux, inverse), is_point);
+        const __m256 dy = _mm256_blendv_ps(ly, _mm256_mul_ps(uy, inverse), is_point);
+        const __m256 dz = _mm256_blendv_ps(lz, _mm256_mul_ps(uz, inverse), is_point);
+
+        // Separate multiplies and adds, not FMA, so that the results match the scalar kernel exactly
+        const __m256 diffuse = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, dx), _mm256_mul_ps(ny, dy)), _mm256_mul_ps(nz, dz));
+        __m256 contribution = _mm256_and_ps(_mm256_mul_ps(intensity, diffuse), _mm256_cmp_ps(diffuse, zero, _CMP_GT_OQ));
+
+        if (specular != NULL) {
+            const __m256 two_diffuse = _mm256_mul_ps(two, diffuse);
+            const __m256 rx = _mm256_sub_ps(_mm256_mul_ps(nx, two_diffuse), dx);
+            const __m256 ry = _mm256_sub_ps(_mm256_mul_ps(ny, two_diffuse), dy);
+            const __m256 rz = _mm256_sub_ps(_mm256_mul_ps(nz, two_diffuse), dz);
+            const __m256 reflection_dot_view = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(rx, vx), _mm256_mul_ps(ry, vy)), _mm256_mul_ps(rz, vz));
+            contribution = _mm256_add_ps(contribution, _mm256_mul_ps(intensity, kernels_specular_avx2(specular, reflection_dot_view)));
+        }
+
+        _mm256_storeu_ps(terms->contribution + i, contribution);
+        _mm256_storeu_ps(terms->direction_x + i, dx);
+        _mm256_storeu_ps(terms->direction_y + i, dy);
+        _mm256_storeu_ps(terms->direction_z + i, dz);
+        _mm256_storeu_ps(terms->t_max + i, _mm256_blendv_ps(far, length, is_point));
+    }
+}
+
+KERNELS_AVX2 static inline __m256i kernels_channels_avx2(__m256 values) {
+    return _mm256_cvttps_epi32(_mm256_max_ps(_mm256_min_ps(values, _mm256_set1_ps(255.0f)), _mm256_setzero_ps()));
+}
+
+KERNELS_AVX2 static void kernels_pack_pixels_avx2(const float* rgb, unsigned int* pixels, int count) {
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i offsets = _mm256_mullo_epi32(lane, _mm256_set1_epi32(3));
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+
+    for (int i = 0; i < count; i += 8) {
+        const __m256i valid = _mm256_cmpgt_epi32(_mm256_set1_epi32(count - i), lane);
+        const __m256 valid_ps = _mm256_castsi256_ps(valid);
+        const float* p = rgb + 3 * i;
+        const __m256i r = kernels_channels_avx2(_mm256_mask_i32gather_ps(_mm256_setzero_ps(), p, offsets, valid_ps, 4));
+        const __m256i g = kernels_channels_avx2(_mm256_mask_i32gather_ps(_mm256_setzero_ps(), p + 1, offsets, valid_ps, 4));
+        const __m256i b = kernels_channels_avx2(_mm256_mask_i32gather_ps(_mm256_setzero_ps(), p + 2, offsets, valid_ps, 4));
+        const __m256i argb = _mm256_or_si256(_mm256_or_si256(alpha, _mm256_slli_epi32(r, 16)), _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+        _mm256_maskstore_epi32((int*)(pixels + i), valid, argb);
+    }
+}
+
+static const Kernels kernels_avx2 = {
+    CPU_LEVEL_AVX2,
+    kernels_intersect_spheres_avx2,
+    kernels_light_terms_avx2,
+    kernels_pack_pixels_avx2
+};
+
+// --- AVX-512F: 16 lanes, masked tails ---
+
+KERNELS_AVX512 static int kernels_intersect_spheres_avx512(const SphereSoA* spheres, int first, int count, Vector3 origin, Vector3 direction,
+                                                           float t_min, float* closest_t) {
+    const int end = first + count;
+    float best_t = *closest_t;
+    int best_index = -1;
+
+    const __m512 ox = _mm512_set1_ps(origin.x), oy = _mm512_set1_ps(origin.y), oz = _mm512_set1_ps(origin.z);
+    const __m512 dx = _mm512_set1_ps(direction.x), dy = _mm512_set1_ps(direction.y), dz = _mm512_set1_ps(direction.z);
+    const __m512 tmin = _mm512_set1_ps(t_min), zero = _mm512_setzero_ps();
+    __m512 lane_t = _mm512_set1_ps(best_t);
+    __m512i lane_index = _mm512_set1_epi32(-1);
+    __m512i index = _mm512_add_epi32(_mm512_set1_epi32(first), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+    for (int i = first; i < end; i += 16) {
+        // Lanes past the end load nothing and never hit
+        const __mmask16 valid = end - i >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (end - i)) - 1);
+        const __m512 lx = _mm512_sub_ps(ox, _mm512_maskz_loadu_ps(valid, spheres->center_x + i));
+        const __m512 ly = _mm512_sub_ps(oy, _mm512_maskz_loadu_ps(valid, spheres->center_y + i));
+        const __m512 lz = _mm512_sub_ps(oz, _mm512_maskz_loadu_ps(valid, spheres->center_z + i));
+
+        // Separate multiplies and adds, not FMA, so that the results match the scalar kernel exactly
+        const __m512 half_b = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(lx, dx), _mm512_mul_ps(ly, dy)), _mm512_mul_ps(lz, dz));
+        const __m512 c = _mm512_sub_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(lx, lx), _mm512_mul_ps(ly, ly)), _mm512_mul_ps(lz, lz)),
+                                       _mm512_maskz_loadu_ps(valid, spheres->radius_sq + i));
+        const __m512 discriminant = _mm512_sub_ps(_mm512_mul_ps(half_b, half_b), c);
+        const __mmask16 real = _mm512_mask_cmp_ps_mask(valid, discriminant, zero, _CMP_GE_OQ);
+
+        const __m512 root = _mm512_sqrt_ps(_mm512_max_ps(discriminant, zero));
+        const __m512 near_root = _mm512_sub_ps(_mm512_sub_ps(zero, half_b), root);
+        const __m512 far_root = _mm512_add_ps(_mm512_sub_ps(zero, half_b), root);
+
+        // Prefer the near root; fall back to the far root when the origin is inside the sphere
+        const __mmask16 near_ok = _mm512_mask_cmp_ps_mask(_mm512_cmp_ps_mask(near_root, tmin, _CMP_GT_OQ), near_root, lane_t, _CMP_LT_OQ);
+        const __m512 t = _mm512_mask_blend_ps(near_ok, far_root, near_root);
+        const __mmask16 hit = _mm512_mask_cmp_ps_mask(_mm512_mask_cmp_ps_mask(real, t, tmin, _CMP_GT_OQ), t, lane_t, _CMP_LT_OQ);
+
+        lane_t = _mm512_mask_blend_ps(hit, lane_t, t);
+        lane_index = _mm512_mask_blend_epi32(hit, lane_index, index);
+        index = _mm512_add_epi32(index, _mm512_set1_epi32(16));
+    }
+
+    float lane_t_values[16];
+    int lane_index_values[16];
+    _mm512_storeu_ps(lane_t_values, lane_t);
+    _mm512_storeu_si512(lane_index_values, lane_index);
+    kernels_keep_nearest(lane_t_values, lane_index_values, 16, &best_t, &best_index);
+
+    if (best_index >= 0) {
+        *closest_t = best_t;
+    }
+    return best_index;
+}
+
+// (R.V)^exponent from the table, matching specular_table_lookup lane by lane
+KERNELS_AVX512 static __m512 kernels_specular_avx512(const SpecularTable* table, __m512 x) {
+    const __m512 start = _mm512_set1_ps(table->start);
+    const __m512 position = _mm512_mul_ps(_mm512_sub_ps(x, start), _mm512_set1_ps(table->scale));
+    const __m512i index = _mm512_max_epi32(_mm512_cvttps_epi32(position), _mm512_setzero_si512());
+    const __mmask16 at_end = _mm512_cmpgt_epi32_mask(index, _mm512_set1_epi32(SPECULAR_TABLE_SIZE - 1));
+    const __m512i clamped = _mm512_min_epi32(index, _mm512_set1_epi32(SPECULAR_TABLE_SIZE - 1));
+
+    const __m512 low = _mm512_i32gather_ps(clamped, table->values, 4);
+    const __m512 high = _mm512_i32gather_ps(clamped, table->values + 1, 4);
+    const __m512 fraction = _mm512_sub_ps(position, _mm512_cvtepi32_ps(clamped));
+    const __m512 value = _mm512_mask_blend_ps(at_end, _mm512_add_ps(low, _mm512_mul_ps(fraction, _mm512_sub_ps(high, low))),
+                                              _mm512_set1_ps(table->values[SPECULAR_TABLE_SIZE]));
+    return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, start, _CMP_GT_OQ), value);
+}
+
+KERNELS_AVX512 static void kernels_light_terms_avx512(const PreparedLight* lights, int count, Vector3 point, Vector3 normal,
+                                                      const SpecularTable* specular, Vector3 view_direction, KernelLightTerms* terms) {
+    const __m512 px = _mm512_set1_ps(point.x), py = _mm512_set1_ps(point.y), pz = _mm512_set1_ps(point.z);
+    const __m512 nx = _mm512_set1_ps(normal.x), ny = _mm512_set1_ps(normal.y), nz = _mm512_set1_ps(normal.z);
+    const __m512 vx = _mm512_set1_ps(view_direction.x), vy = _mm512_set1_ps(view_direction.y), vz = _mm512_set1_ps(view_direction.z);
+    const __m512 zero = _mm512_setzero_ps(), one = _mm512_set1_ps(1.0f), two = _mm512_set1_ps(2.0f), far = _mm512_set1_ps(FLT_MAX);
+    const __m512i offsets = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+                                               _mm512_set1_epi32(KERNELS_LIGHT_STRIDE));
+
+    for (int i = 0; i < count; i += 16) {
+        const __mmask16 valid = count - i >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (count - i)) - 1);
+        const float* words = (const float*)(lights + i);
+
+        const __m512i type = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), valid, offsets, (const int*)words + KERNELS_LIGHT_TYPE, 4);
+        const __mmask16 is_point = _mm512_cmpeq_epi32_mask(type, _mm512_set1_epi32(LIGHT_TYPE_POINT));
+        const __m512 intensity = _mm512_mask_i32gather_ps(zero, valid, offsets, words + KERNELS_LIGHT_INTENSITY, 4);
+        const __m512 lx = _mm512_mask_i32gather_ps(zero, valid, offsets, words + KERNELS_LIGHT_VECTOR, 4);
+        const __m512 ly = _mm512_mask_i32gather_ps(zero, valid, offsets, words + KERNELS_LIGHT_VECTOR + 1, 4);
+        const __m512 lz = _mm512_mask_i32gather_ps(zero, valid, offsets, words + KERNELS_LIGHT_VECTOR + 2, 4);
+
+        const __m512 ux = _mm512_sub_ps(lx, px), uy = _mm512_sub_ps(ly, py), uz = _mm512_sub_ps(lz, pz);
+        const __m512 length = _mm512_sqrt_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(ux, ux), _mm512_mul_ps(uy, uy)), _mm512_mul_ps(uz, uz)));
+        const __m512 inverse = _mm512_div_ps(one, length);
+        const __m512 dx = _mm512_mask_blend_ps(is_point, lx, _mm512_mul_ps(ux, inverse));
+        const __m512 dy = _mm512_mask_blend_ps(is_point, ly, _mm512_mul_ps(uy, inverse));
+        const __m512 dz = _mm512_mask_blend_ps(is_point, lz, _mm512_mul_ps(uz, inverse));
+
+        // Separate multiplies and adds, not FMA, so that the results match the scalar kernel exactly
+        const __m512 diffuse = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(nx, dx), _mm512_mul_ps(ny, dy)), _mm512_mul_ps(nz, dz));
+        __m512 contribution = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(diffuse, zero, _CMP_GT_OQ), _mm512_mul_ps(intensity, diffuse));
+
+        if (specular != NULL) {
+            const __m512 two_diffuse = _mm512_mul_ps(two, diffuse);
+            const __m512 rx = _mm512_sub_ps(_mm512_mul_ps(nx, two_diffuse), dx);
+            const __m512 ry = _mm512_sub_ps(_mm512_mul_ps(ny, two_diffuse), dy);
+            const __m512 rz = _mm512_sub_ps(_mm512_mul_ps(nz, two_diffuse), dz);
+            const __m512 reflection_dot_view = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(rx, vx), _mm512_mul_ps(ry, vy)), _mm512_mul_ps(rz, vz));
+            contribution = _mm512_add_ps(contribution, _mm512_mul_ps(intensity, kernels_specular_avx512(specular, reflection_dot_view)));
+        }
+
+        _mm512_storeu_ps(terms->contribution + i, contribution);
+        _mm512_storeu_ps(terms->direction_x + i, dx);
+        _mm512_storeu_ps(terms->direction_y + i, dy);
+        _mm512_storeu_ps(terms->direction_z + i, dz);
+        _mm512_storeu_ps(terms->t_max + i, _mm512_mask_blend_ps(is_point, far, length));
+    }
+}
+
+KERNELS_AVX512 static inline __m512i kernels_channels_avx512(__m512 values) {
+    return _mm512_cvttps_epi32(_mm512_max_ps(_mm512_min_ps(values, _mm512_set1_ps(255.0f)), _mm512_setzero_ps()));
+}
+
+KERNELS_AVX512 static void kernels_pack_pixels_avx512(const float* rgb, unsigned int* pixels, int count) {
+    const __m512i offsets = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(3));
+    const __m512i alpha = _mm512_set1_epi32((int)0xFF000000u);
+
+    for (int i = 0; i < count; i += 16) {
+        const __mmask16 valid = count - i >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (count - i)) - 1);
+        const float* p = rgb + 3 * i;
+        const __m512i r = kernels_channels_avx512(_mm512_mask_i32gather_ps(_mm512_setzero_ps(), valid, offsets, p, 4));
+        const __m512i g = kernels_channels_avx512(_mm512_mask_i32gather_ps(_mm512_setzero_ps(), valid, offsets, p + 1, 4));
+        const __m512i b = kernels_channels_avx512(_mm512_mask_i32gather_ps(_mm512_setzero_ps(), valid, offsets, p + 2, 4));
+        const __m512i argb = _mm512_or_si512(_mm512_or_si512(alpha, _mm512_slli_epi32(r, 16)), _mm512_or_si512(_mm512_slli_epi32(g, 8), b));
+        _mm512_mask_storeu_epi32(pixels + i, valid, argb);
+    }
+}
+
+static const Kernels kernels_avx512 = {
+    CPU_LEVEL_AVX512,
+    kernels_intersect_spheres_avx512,
+    kernels_light_terms_avx512,
+    kernels_pack_pixels_avx512
+};
+
+#endif // KERNELS_X86
+
+const Kernels* kernels_for_level(CpuLevel level) {
+#if KERNELS_X86
+    static const Kernels* const levels[CPU_LEVEL_COUNT] = { &kernels_scalar, &kernels_sse, &kernels_avx2, &kernels_avx512 };
+    return levels[level];
+#else
+    (void)level;
+    return &kernels_scalar;
+#endif
+}
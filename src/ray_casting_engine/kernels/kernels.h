@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../cpu/cpu.h"
+#include "../scene/scene.h"
+#include "../vector/vector.h"
+
+#ifndef _KERNELS_H_
+#define _KERNELS_H_
+
+#define KERNELS_LIGHT_BATCH 64   // Lights evaluated per light_terms call; a multiple of every SIMD width
+
+// Unshadowed light terms of up to KERNELS_LIGHT_BATCH lights at one surface point, one entry per light
+typedef struct KernelLightTerms {
+    float contribution[KERNELS_LIGHT_BATCH];   // Diffuse plus specular intensity
+    float direction_x[KERNELS_LIGHT_BATCH];    // Unit vector from the point towards the light
+    float direction_y[KERNELS_LIGHT_BATCH];
+    float direction_z[KERNELS_LIGHT_BATCH];
+    float t_max[KERNELS_LIGHT_BATCH];          // Length of the shadow ray to test
+} KernelLightTerms;
+
+// Hot kernels of one instruction set level. Every level returns the same results as the scalar one.
+typedef struct Kernels {
+    CpuLevel level;
+
+    // Nearest sphere of a contiguous SoA range hit in (t_min, *closest_t); direction must be a unit vector.
+    // Returns its index and updates *closest_t, or returns -1 and leaves *closest_t alone.
+    int (*intersect_spheres)(const SphereSoA* spheres, int first, int count, Vector3 origin, Vector3 direction,
+                             float t_min, float* closest_t);
+
+    // Fills the first count (at most KERNELS_LIGHT_BATCH) entries of terms for point and directional lights.
+    // specular is NULL for matte materials.
+    void (*light_terms)(const PreparedLight* lights, int count, Vector3 point, Vector3 normal,
+                        const SpecularTable* specular, Vector3 view_direction, KernelLightTerms* terms);
+
+    // Converts count RGB float triples in [0, 255] to opaque ARGB8888, truncating like color_to_argb8888
+    void (*pack_pixels)(const float* rgb, unsigned int* pixels, int count);
+} Kernels;
+
+extern const Kernels kernels_scalar;
+
+// Kernels of a level; levels this build has no kernels for fall back to the highest one below.
+// The caller checks that the CPU supports the level (see cpu_detect_level).
+const Kernels* kernels_for_level(CpuLevel level);
+
+// Scalar light term of one light, the reference for the light_terms kernels.
+// Writes the unit direction towards the light and the shadow ray length.
+float kernels_light_contribution(const PreparedLight* light, Vector3 point, Vector3 normal, const SpecularTable* specular,
+                                 Vector3 view_direction, Vector3* light_direction, float* t_max);
+
+#endif
@@ -11,6 +11,46 @@ int lightList_init(LightList* lightList) {
     lightList->lights = NULL;
     lightList->capacity = 0;
     lightList->count = 0;
+    lightList->generation = 0;
+    lightList->external = 0;
+
+    return 0;
+}
+
+int lightList_attach(LightList* list, Light* lights, size_t count) {
+    if (list == NULL || list->lights != NULL || (count > 0 && lights == NULL)) {
+        fprintf(stderr, "Error: lightList_attach needs an empty list and a valid array.\n");
+        return -1;
+    }
+
+    list->lights = lights;
+    list->capacity = count;
+    list->count = count;
+    list->external = 1;
+    list->generation++;
+    return 0;
+}
+
+int lightList_reserve(LightList* list, size_t capacity) {
+    if (list == NULL) {
+        return -1;
+    }
+    if (capacity <= list->capacity) {
+        return 0;
+    }
+
+    // Attached lights are copied into a block the list owns
+    Light* new_lights = list->external ? (Light*)malloc(capacity * sizeof(Light))
+                                       : (Light*)realloc(list->lights, capacity * sizeof(Light));
+    if (new_lights == NULL) {
+        return -1;
+    }
+    if (list->external) {
+        memcpy(new_lights, list->lights, list->count * sizeof(Light));
+        list->external = 0;
+    }
+    list->lights = new_lights;
+    list->capacity = capacity;
 
     return 0;
 }
@@ -23,29 +63,29 @@ int lightList_add(LightList* list, Light light) {
     // If capacity is full, reallocate
     if (list->count == list->capacity) {
         size_t new_capacity = (list->capacity == 0) ? INITIAL_LIGHT_CAPACITY : list->capacity * 2;
-        Light* new_lights = (Light*)realloc(list->lights, new_capacity * sizeof(Light));
-
-        if (new_lights == NULL) {
+        if (lightList_reserve(list, new_capacity) != 0) {
             // Reallocation failed
             return -1;
         }
-        list->lights = new_lights;
-        list->capacity = new_capacity;
     }
 
     // Add the new light
     list->lights[list->count] = light;
     list->count++;
+    list->generation++;
 
     return 0; // Success
 }
 
 void lightList_free(LightList* list) {
     if (list != NULL && list->lights != NULL) {
-        free(list->lights);
+        if (!list->external) {
+            free(list->lights);
+        }
         list->lights = NULL;
         list->capacity = 0;
         list->count = 0;
+        list->external = 0;
     }
 }
 
@@ -56,6 +96,12 @@ Light* lightList_get(LightList* list, size_t index) {
     return NULL; // Index out of bounds or invalid list
 }
 
+void lightList_mark_changed(LightList* list) {
+    if (list != NULL) {
+        list->generation++;
+    }
+}
+
 Light light_new_ambient(float intensity) {
     Light light;
     light.type = LIGHT_TYPE_AMBIENT;
@@ -43,11 +43,19 @@ typedef struct LightList {
     Light* lights;
     size_t capacity; // Total allocated space
     size_t count;    // Number of active lights
+    unsigned int generation; // Incremented whenever a light is added or modified
+    int external;    // Array is owned elsewhere (e.g. a mapped scene file); copied before the list first grows
 } LightList;
 
 int lightList_init(LightList* lightLits);
 int lightList_add(LightList* lightLits, Light light);
+// Grows the list to hold at least capacity lights so that the following adds do not reallocate
+int lightList_reserve(LightList* list, size_t capacity);
+// Points an empty list at count lights owned by the caller, without copying; copied only if the list has to grow
+int lightList_attach(LightList* list, Light* lights, size_t count);
 void lightList_free(LightList* lightLits);
 Light* lightList_get(LightList* lightLits, size_t index);
+// Records that a light was modified through lightList_get
+void lightList_mark_changed(LightList* list);
 
 #endif
@@ -1,13 +1,39 @@
 #include "./app/app.h"
 #include "./canvas/canvas.h"
+#include "./options/options.h"
 
 int main(int argc, char* argv[]) {
-    Canvas canvas = canvas_new(800, 600);
+    Options options;
+    options_init(&options);
+
+    if (options_parse(&options, argc, argv) != 0) {
+        options_print_usage(stderr, argv[0]);
+        return 1;
+    }
+    if (options.show_help) {
+        options_print_usage(stdout, argv[0]);
+        return 0;
+    }
+
+    Canvas canvas = canvas_new(options.width, options.height);
     // Declare an Application struct instance
     Application my_app;
 
+    if (options.headless) {
+        // Render offscreen without ever starting the SDL video subsystem
+        if (application_init_headless(&my_app, &canvas, &options) != 0) {
+            fprintf(stderr, "Failed to initialize headless application.\n");
+            return 1;
+        }
+
+        int status = application_run_headless(&my_app);
+
+        application_clean_up(&my_app);
+        return status;
+    }
+
     // Initialize the application
-    if (application_init(&my_app, &canvas) != 0) {
+    if (application_init(&my_app, &canvas, &options) != 0) {
         fprintf(stderr, "Failed to initialize application.\n");
         return 1; // Exit with error code if initialization fails
     }
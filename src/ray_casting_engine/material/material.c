@@ -0,0 +1,125 @@
+#include "./material.h"
+
+#include <math.h>
+
+#define INITIAL_MATERIAL_CAPACITY 8 // Starting capacity for material list
+
+Material material_new(Color color, int specularity, float reflectivity) {
+    Material material;
+    material.color = color;
+    material.specularity = specularity;
+    material.reflectivity = reflectivity;
+    return material;
+}
+
+int materialList_init(MaterialList* list) {
+    if (list == NULL) {
+        fprintf(stderr, "Error: materialList_init received a NULL list pointer.\n");
+        return -1;
+    }
+
+    list->materials = NULL;
+    list->capacity = 0;
+    list->count = 0;
+    list->generation = 0;
+    list->external = 0;
+
+    return 0;
+}
+
+int materialList_attach(MaterialList* list, Material* materials, size_t count) {
+    if (list == NULL || list->materials != NULL || (count > 0 && materials == NULL)) {
+        fprintf(stderr, "Error: materialList_attach needs an empty list and a valid array.\n");
+        return -1;
+    }
+
+    list->materials = materials;
+    list->capacity = count;
+    list->count = count;
+    list->external = 1;
+    list->generation++;
+    return 0;
+}
+
+int materialList_reserve(MaterialList* list, size_t capacity) {
+    if (list == NULL) {
+        return -1;
+    }
+    if (capacity <= list->capacity) {
+        return 0;
+    }
+
+    // Attached materials are copied into a block the list owns
+    Material* new_materials = list->external ? (Material*)malloc(capacity * sizeof(Material))
+                                             : (Material*)realloc(list->materials, capacity * sizeof(Material));
+    if (new_materials == NULL) {
+        return -1;
+    }
+    if (list->external) {
+        memcpy(new_materials, list->materials, list->count * sizeof(Material));
+        list->external = 0;
+    }
+    list->materials = new_materials;
+    list->capacity = capacity;
+
+    return 0;
+}
+
+int materialList_add(MaterialList* list, Material material) {
+    if (list == NULL) {
+        return -1;
+    }
+
+    if (list->count == list->capacity) {
+        size_t new_capacity = (list->capacity == 0) ? INITIAL_MATERIAL_CAPACITY : list->capacity * 2;
+        if (materialList_reserve(list, new_capacity) != 0) {
+            return -1;
+        }
+    }
+
+    list->materials[list->count] = material;
+    list->count++;
+    list->generation++;
+
+    return (int)(list->count - 1);
+}
+
+void materialList_free(MaterialList* list) {
+    if (list != NULL && list->materials != NULL) {
+        if (!list->external) {
+            free(list->materials);
+        }
+        list->materials = NULL;
+        list->capacity = 0;
+        list->count = 0;
+        list->external = 0;
+    }
+}
+
+Material* materialList_get(MaterialList* list, size_t index) {
+    if (list != NULL && index < list->count) {
+        return &list->materials[index];
+    }
+    return NULL;
+}
+
+void materialList_mark_changed(MaterialList* list) {
+    if (list != NULL) {
+        list->generation++;
+    }
+}
+
+void specular_table_init(SpecularTable* table, int exponent) {
+    table->exponent = exponent;
+
+    // x^n = 2^-cutoff at x = 2^(-cutoff / n); the table spans from there to 1
+    table->start = powf(2.0f, -SPECULAR_TABLE_CUTOFF / (float)exponent);
+    table->scale = (float)SPECULAR_TABLE_SIZE / (1.0f - table->start);
+
+    // Samples in double precision: near 1, float spacing is too coarse for very large exponents
+    const double step = (1.0 - (double)table->start) / SPECULAR_TABLE_SIZE;
+    for (int i = 0; i <= SPECULAR_TABLE_SIZE; ++i) {
+        table->values[i] = (float)pow((double)table->start + step * i, (double)exponent);
+    }
+    table->values[SPECULAR_TABLE_SIZE] = 1.0f;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../color/color.h"
+
+#ifndef _MATERIAL_H_
+#define _MATERIAL_H_
+
+#define SPECULAR_TABLE_SIZE 256       // Interpolation intervals per table
+#define SPECULAR_TABLE_CUTOFF 12.0f   // x^n below 2^-SPECULAR_TABLE_CUTOFF is treated as 0
+
+// Surface properties shared by every object that references the material
+typedef struct Material {
+    Color color;
+    int specularity;       // Phong exponent; 0 or less for matte surfaces
+    float reflectivity;    // Share of the color taken from the mirror reflection, [0, 1]
+} Material;
+
+Material material_new(Color color, int specularity, float reflectivity);
+
+typedef struct MaterialList {
+    Material* materials;
+    size_t capacity;
+    size_t count;
+    unsigned int generation; // Incremented whenever a material is added or modified
+    int external;    // Array is owned elsewhere (e.g. a mapped scene file); copied before the list first grows
+} MaterialList;
+
+int materialList_init(MaterialList* list);
+// Appends a material and returns its index, or -1 on failure
+int materialList_add(MaterialList* list, Material material);
+// Grows the list to hold at least capacity materials so that the following adds do not reallocate
+int materialList_reserve(MaterialList* list, size_t capacity);
+// Points an empty list at count materials owned by the caller, without copying; copied only if the list has to grow
+int materialList_attach(MaterialList* list, Material* materials, size_t count);
+void materialList_free(MaterialList* list);
+Material* materialList_get(MaterialList* list, size_t index);
+// Records that a material was modified through materialList_get
+void materialList_mark_changed(MaterialList* list);
+
+// Precomputed specular response x^exponent for x in [0, 1].
+// Samples are spaced evenly over [start, 1], where start is the point below which x^exponent
+// drops under 2^-SPECULAR_TABLE_CUTOFF. Linear interpolation between them stays within 2.5e-4
+// of powf for every exponent, well below one 8-bit color step.
+typedef struct SpecularTable {
+    int exponent;
+    float start;
+    float scale;           // SPECULAR_TABLE_SIZE / (1 - start)
+    float values[SPECULAR_TABLE_SIZE + 1];
+} SpecularTable;
+
+// Fills the table for a positive exponent
+void specular_table_init(SpecularTable* table, int exponent);
+
+// x^exponent for x = R.V, a cosine of at most 1
+static inline float specular_table_lookup(const SpecularTable* table, float x) {
+    if (x <= table->start) {
+        return 0.0f;
+    }
+
+    const float position = (x - table->start) * table->scale;
+    const int index = (int)position;
+    if (index >= SPECULAR_TABLE_SIZE) {
+        return table->values[SPECULAR_TABLE_SIZE];
+    }
+
+    const float fraction = position - (float)index;
+    return table->values[index] + fraction * (table->values[index + 1] - table->values[index]);
+}
+
+#endif
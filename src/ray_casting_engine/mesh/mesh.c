@@ -0,0 +1,432 @@
+#include "./mesh.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define INITIAL_MESH_CAPACITY 4 // Starting capacity for mesh list
+
+static void mesh_clear(Mesh* mesh) {
+    memset(mesh, 0, sizeof(*mesh));
+    bvh_init(&mesh->bvh);
+}
+
+int mesh_init(Mesh* mesh, const Vector3* vertices, int vertex_count, const int* indices, int triangle_count) {
+    if (mesh == NULL) {
+        fprintf(stderr, "Error: mesh_init received a NULL mesh pointer.\n");
+        return -1;
+    }
+    mesh_clear(mesh);
+
+    if (vertices == NULL || indices == NULL || vertex_count <= 0 || triangle_count <= 0) {
+        fprintf(stderr, "Error: mesh_init needs at least one vertex and one triangle.\n");
+        return -1;
+    }
+    for (int i = 0; i < 3 * triangle_count; ++i) {
+        if (indices[i] < 0 || indices[i] >= vertex_count) {
+            fprintf(stderr, "Error: mesh triangle %d references vertex %d, but the mesh has %d vertices.\n",
+                    i / 3, indices[i], vertex_count);
+            return -1;
+        }
+    }
+
+    const size_t triangles = (size_t)triangle_count;
+    float* corners = (float*)malloc(9 * triangles * sizeof(float));   // One block for all nine SoA arrays
+    Aabb* bounds = (Aabb*)malloc(triangles * sizeof(Aabb));
+    int* order = (int*)malloc(triangles * sizeof(int));
+    if (corners == NULL || bounds == NULL || order == NULL) {
+        fprintf(stderr, "Error: Failed to allocate a mesh of %d triangles.\n", triangle_count);
+        free(corners);
+        free(bounds);
+        free(order);
+        mesh_free(mesh);
+        return -1;
+    }
+
+    mesh->vertex_count = vertex_count;
+    mesh->triangle_count = triangle_count;
+
+    for (int i = 0; i < triangle_count; ++i) {
+        const Vector3 a = vertices[indices[3 * i]];
+        const Vector3 b = vertices[indices[3 * i + 1]];
+        const Vector3 c = vertices[indices[3 * i + 2]];
+        bounds[i].min = vector3_new(fminf(a.x, fminf(b.x, c.x)), fminf(a.y, fminf(b.y, c.y)), fminf(a.z, fminf(b.z, c.z)));
+        bounds[i].max = vector3_new(fmaxf(a.x, fmaxf(b.x, c.x)), fmaxf(a.y, fmaxf(b.y, c.y)), fmaxf(a.z, fmaxf(b.z, c.z)));
+    }
+
+    if (bvh_build(&mesh->bvh, bounds, NULL, NULL, triangle_count, order) != 0) {
+        fprintf(stderr, "Error: Failed to build the BVH of a mesh of %d triangles.\n", triangle_count);
+        free(corners);
+        free(bounds);
+        free(order);
+        mesh_free(mesh);
+        return -1;
+    }
+
+    MeshTriangleSoA* soa = &mesh->triangles;
+    soa->ax = corners;
+    soa->ay = corners + triangles;
+    soa->az = corners + 2 * triangles;
+    soa->bx = corners + 3 * triangles;
+    soa->by = corners + 4 * triangles;
+    soa->bz = corners + 5 * triangles;
+    soa->cx = corners + 6 * triangles;
+    soa->cy = corners + 7 * triangles;
+    soa->cz = corners + 8 * triangles;
+
+    // Store the triangles in leaf order so that every leaf reads a contiguous slice of each array
+    mesh->bounds = bounds[order[0]];
+    for (int i = 0; i < triangle_count; ++i) {
+        const int source = order[i];
+        const Vector3 a = vertices[indices[3 * source]];
+        const Vector3 b = vertices[indices[3 * source + 1]];
+        const Vector3 c = vertices[indices[3 * source + 2]];
+        soa->ax[i] = a.x; soa->ay[i] = a.y; soa->az[i] = a.z;
+        soa->bx[i] = b.x; soa->by[i] = b.y; soa->bz[i] = b.z;
+        soa->cx[i] = c.x; soa->cy[i] = c.y; soa->cz[i] = c.z;
+        mesh->bounds = aabb_union(mesh->bounds, bounds[source]);
+    }
+
+    free(bounds);
+    free(order);
+    return 0;
+}
+
+// Growable arrays filled while an OBJ file is read
+typedef struct MeshObjReader {
+    const char* path;
+    int line_number;
+    Vector3* vertices;
+    int vertex_count;
+    int vertex_capacity;
+    int* indices;
+    int index_count;
+    int index_capacity;
+} MeshObjReader;
+
+static int mesh_obj_error(const MeshObjReader* reader, const char* message, const char* detail) {
+    if (detail != NULL) {
+        fprintf(stderr, "%s:%d: error: %s '%s'.\n", reader->path, reader->line_number, message, detail);
+    } else {
+        fprintf(stderr, "%s:%d: error: %s.\n", reader->path, reader->line_number, message);
+    }
+    return -1;
+}
+
+// Makes room for `more` elements after `count`; keeps the old block on failure
+static int mesh_obj_reserve(void** array, int* capacity, int count, int more, size_t element_size) {
+    if (count + more <= *capacity) {
+        return 0;
+    }
+    int new_capacity = (*capacity == 0) ? 1024 : *capacity;
+    while (new_capacity < count + more) {
+        if (new_capacity > (1 << 29)) {
+            return -1;
+        }
+        new_capacity *= 2;
+    }
+
+    void* grown = realloc(*array, (size_t)new_capacity * element_size);
+    if (grown == NULL) {
+        return -1;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return 0;
+}
+
+// "v x y z [w]"
+static int mesh_obj_parse_vertex(MeshObjReader* reader, char* fields) {
+    Vector3 vertex;
+    float* components[3] = { &vertex.x, &vertex.y, &vertex.z };
+    char* cursor = fields;
+
+    for (int i = 0; i < 3; ++i) {
+        char* end = NULL;
+        *components[i] = strtof(cursor, &end);
+        if (end == cursor || !isfinite(*components[i])) {
+            return mesh_obj_error(reader, "expected three vertex coordinates", NULL);
+        }
+        cursor = end;
+    }
+
+    if (mesh_obj_reserve((void**)&reader->vertices, &reader->vertex_capacity, reader->vertex_count, 1, sizeof(Vector3)) != 0) {
+        return mesh_obj_error(reader, "out of memory", NULL);
+    }
+    reader->vertices[reader->vertex_count++] = vertex;
+    return 0;
+}
+
+// "f a b c ...", where every corner is "v", "v/vt", "v//vn" or "v/vt/vn" and negative indices count back from the last vertex
+static int mesh_obj_parse_face(MeshObjReader* reader, char* fields) {
+    int corners[MESH_MAX_FACE];
+    int corner_count = 0;
+    char* cursor = fields;
+
+    for (;;) {
+        while (*cursor == ' ' || *cursor == '\t') {
+            cursor++;
+        }
+        if (*cursor == '\0') {
+            break;
+        }
+
+        char* end = NULL;
+        const long value = strtol(cursor, &end, 10);
+        if (end == cursor || (*end != '\0' && *end != '/' && *end != ' ' && *end != '\t')) {
+            return mesh_obj_error(reader, "malformed face corner", cursor);
+        }
+        const long index = (value < 0) ? reader->vertex_count + value : value - 1;
+        if (value == 0 || index < 0 || index >= reader->vertex_count) {
+            *end = '\0';
+            return mesh_obj_error(reader, "face references an undefined vertex", cursor);
+        }
+        if (corner_count == MESH_MAX_FACE) {
+            return mesh_obj_error(reader, "face has too many corners", NULL);
+        }
+        corners[corner_count++] = (int)index;
+
+        // Skip the texture coordinate and normal references
+        cursor = end;
+        while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t') {
+            cursor++;
+        }
+    }
+
+    if (corner_count < 3) {
+        return mesh_obj_error(reader, "face has fewer than three corners", NULL);
+    }
+
+    const int triangles = corner_count - 2;
+    if (mesh_obj_reserve((void**)&reader->indices, &reader->index_capacity, reader->index_count, 3 * triangles, sizeof(int)) != 0) {
+        return mesh_obj_error(reader, "out of memory", NULL);
+    }
+    // Fan around the first corner, which is exact for the convex polygons exporters write
+    for (int i = 1; i + 1 < corner_count; ++i) {
+        reader->indices[reader->index_count++] = corners[0];
+        reader->indices[reader->index_count++] = corners[i];
+        reader->indices[reader->index_count++] = corners[i + 1];
+    }
+    return 0;
+}
+
+int mesh_load_obj(Mesh* mesh, const char* path) {
+    if (mesh == NULL || path == NULL) {
+        fprintf(stderr, "Error: mesh_load_obj received a NULL pointer.\n");
+        return -1;
+    }
+    mesh_clear(mesh);
+
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    MeshObjReader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.path = path;
+
+    char line[MESH_MAX_LINE];
+    int status = 0;
+    while (status == 0 && fgets(line, sizeof(line), file) != NULL) {
+        reader.line_number++;
+
+        const size_t length = strlen(line);
+        if (length == sizeof(line) - 1 && line[length - 1] != '\n' && !feof(file)) {
+            status = mesh_obj_error(&reader, "line is too long", NULL);
+            break;
+        }
+        line[strcspn(line, "#\r\n")] = '\0';
+
+        char* cursor = line;
+        while (*cursor == ' ' || *cursor == '\t') {
+            cursor++;
+        }
+        if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            status = mesh_obj_parse_vertex(&reader, cursor + 2);
+        } else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            status = mesh_obj_parse_face(&reader, cursor + 2);
+        }
+        // Everything else (vt, vn, g, o, s, usemtl, mtllib, ...) does not affect the geometry
+    }
+
+    if (status == 0 && ferror(file)) {
+        fprintf(stderr, "%s: error: failed to read the file.\n", path);
+        status = -1;
+    }
+    fclose(file);
+
+    if (status == 0 && reader.index_count == 0) {
+        fprintf(stderr, "%s: error: the file contains no faces.\n", path);
+        status = -1;
+    }
+    if (status == 0) {
+        status = mesh_init(mesh, reader.vertices, reader.vertex_count, reader.indices, reader.index_count / 3);
+    }
+    if (status == 0) {
+        const size_t path_length = strlen(path) + 1;
+        mesh->source = (char*)malloc(path_length);
+        if (mesh->source == NULL) {
+            mesh_free(mesh);
+            status = -1;
+        } else {
+            memcpy(mesh->source, path, path_length);
+        }
+    }
+
+    free(reader.vertices);
+    free(reader.indices);
+    return status;
+}
+
+int mesh_init_sphere(Mesh* mesh, float radius, int rings, int segments) {
+    if (mesh == NULL || rings < 2 || segments < 3 || !(radius > 0.0f)) {
+        fprintf(stderr, "Error: mesh_init_sphere needs a positive radius, at least 2 rings and 3 segments.\n");
+        return -1;
+    }
+    if ((long long)rings * segments > (1 << 26)) {
+        fprintf(stderr, "Error: mesh_init_sphere cannot tessellate %d x %d.\n", rings, segments);
+        return -1;
+    }
+
+    // Two poles plus one vertex per segment on each of the rings - 1 latitude circles
+    const int vertex_count = 2 + (rings - 1) * segments;
+    const int triangle_count = 2 * segments * (rings - 1);
+    Vector3* vertices = (Vector3*)malloc((size_t)vertex_count * sizeof(Vector3));
+    int* indices = (int*)malloc((size_t)triangle_count * 3 * sizeof(int));
+    if (vertices == NULL || indices == NULL) {
+        free(vertices);
+        free(indices);
+        fprintf(stderr, "Error: Failed to allocate a sphere mesh of %d triangles.\n", triangle_count);
+        return -1;
+    }
+
+    const int top = 0;
+    const int bottom = vertex_count - 1;
+    vertices[top] = vector3_new(0.0f, radius, 0.0f);
+    vertices[bottom] = vector3_new(0.0f, -radius, 0.0f);
+    for (int ring = 1; ring < rings; ++ring) {
+        const double theta = M_PI * ring / rings;
+        for (int segment = 0; segment < segments; ++segment) {
+            const double phi = 2.0 * M_PI * segment / segments;
+            vertices[1 + (ring - 1) * segments + segment] = vector3_new((float)(radius * sin(theta) * cos(phi)),
+                                                                        (float)(radius * cos(theta)),
+                                                                        (float)(radius * sin(theta) * sin(phi)));
+        }
+    }
+
+    // Counter-clockwise seen from outside, so the winding normals point outwards
+    int* index = indices;
+    for (int segment = 0; segment < segments; ++segment) {
+        const int next = (segment + 1) % segments;
+        *index++ = top;
+        *index++ = 1 + next;
+        *index++ = 1 + segment;
+
+        const int last_ring = 1 + (rings - 2) * segments;
+        *index++ = bottom;
+        *index++ = last_ring + segment;
+        *index++ = last_ring + next;
+    }
+    for (int ring = 1; ring + 1 < rings; ++ring) {
+        const int upper = 1 + (ring - 1) * segments;
+        const int lower = upper + segments;
+        for (int segment = 0; segment < segments; ++segment) {
+            const int next = (segment + 1) % segments;
+            *index++ = upper + segment;
+            *index++ = upper + next;
+            *index++ = lower + segment;
+
+            *index++ = upper + next;
+            *index++ = lower + next;
+            *index++ = lower + segment;
+        }
+    }
+
+    const int status = mesh_init(mesh, vertices, vertex_count, indices, triangle_count);
+    free(vertices);
+    free(indices);
+    return status;
+}
+
+Vector3 mesh_triangle_normal(const Mesh* mesh, int triangle) {
+    const MeshTriangleSoA* soa = &mesh->triangles;
+    const Vector3 a = vector3_new(soa->ax[triangle], soa->ay[triangle], soa->az[triangle]);
+    const Vector3 b = vector3_new(soa->bx[triangle], soa->by[triangle], soa->bz[triangle]);
+    const Vector3 c = vector3_new(soa->cx[triangle], soa->cy[triangle], soa->cz[triangle]);
+    return vector3_normalize(vector3_cross(vector3_subtract(b, a), vector3_subtract(c, a)));
+}
+
+void mesh_free(Mesh* mesh) {
+    if (mesh == NULL) {
+        return;
+    }
+    free(mesh->triangles.ax);   // Start of the block holding all nine arrays
+    bvh_free(&mesh->bvh);
+    free(mesh->source);
+    mesh_clear(mesh);
+}
+
+int meshList_init(MeshList* list) {
+    if (list == NULL) {
+        fprintf(stderr, "Error: meshList_init received a NULL list pointer.\n");
+        return -1;
+    }
+
+    list->meshes = NULL;
+    list->count = 0;
+    list->capacity = 0;
+    list->generation = 0;
+    return 0;
+}
+
+int meshList_add(MeshList* list, Mesh* mesh) {
+    if (list == NULL || mesh == NULL) {
+        return -1;
+    }
+
+    if (list->count == list->capacity) {
+        int new_capacity = (list->capacity == 0) ? INITIAL_MESH_CAPACITY : list->capacity * 2;
+        Mesh* grown = (Mesh*)realloc(list->meshes, (size_t)new_capacity * sizeof(Mesh));
+        if (grown == NULL) {
+            return -1;
+        }
+        list->meshes = grown;
+        list->capacity = new_capacity;
+    }
+
+    list->meshes[list->count] = *mesh;
+    mesh_clear(mesh);
+    list->generation++;
+    return list->count++;
+}
+
+int meshList_find_source(const MeshList* list, const char* path) {
+    if (list == NULL || path == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < list->count; ++i) {
+        if (list->meshes[i].source != NULL && strcmp(list->meshes[i].source, path) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void meshList_free(MeshList* list) {
+    if (list == NULL) {
+        return;
+    }
+    for (int i = 0; i < list->count; ++i) {
+        mesh_free(&list->meshes[i]);
+    }
+    free(list->meshes);
+    list->meshes = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "../bvh/bvh.h"
+#include "../vector/vector.h"
+
+#ifndef _MESH_H_
+#define _MESH_H_
+
+#define MESH_MAX_LINE 1024     // Longest accepted line of an OBJ file, including the newline
+#define MESH_MAX_FACE 64       // Most corners of one OBJ face; larger polygons are rejected
+
+// Corner positions of every triangle in BVH leaf order, stored as separate arrays
+// so the intersection kernel can test several triangles per instruction.
+typedef struct MeshTriangleSoA {
+    float* ax;
+    float* ay;
+    float* az;
+    float* bx;
+    float* by;
+    float* bz;
+    float* cx;
+    float* cy;
+    float* cz;
+} MeshTriangleSoA;
+
+// Triangle mesh in its own space, with a BVH over its triangles. Only the corner positions the
+// intersection kernel reads are kept; the source file is the record of the indexed vertices.
+// Objects of type OBJECT_TYPE_MESH reference a mesh by index, so any number of them share one copy.
+typedef struct Mesh {
+    int vertex_count;           // Of the indexed mesh the triangles were built from
+    int triangle_count;
+    MeshTriangleSoA triangles;  // Corner positions in BVH leaf order
+    Bvh bvh;                    // Leaves index triangles directly
+    Aabb bounds;                // Of all triangles
+    char* source;               // OBJ file the mesh was loaded from, NULL for generated meshes
+} Mesh;
+
+typedef struct MeshList {
+    Mesh* meshes;
+    int count;
+    int capacity;
+    unsigned int generation;    // Incremented whenever a mesh is added
+} MeshList;
+
+// Builds the BVH and stores the corners of the indexed triangles in leaf order; the buffers are not kept.
+// Every index must be below vertex_count. Returns 0 on success, -1 on failure (the mesh is left empty).
+int mesh_init(Mesh* mesh, const Vector3* vertices, int vertex_count, const int* indices, int triangle_count);
+
+// Loads the vertices and faces of a Wavefront OBJ file; polygons are split into triangle fans and
+// everything else (normals, texture coordinates, groups, materials) is ignored.
+// Errors are reported as "path:line: error: ...". Returns 0 on success, -1 on failure.
+int mesh_load_obj(Mesh* mesh, const char* path);
+
+// Closed UV sphere around the origin with 2 * (rings - 1) * segments triangles (rings >= 2, segments >= 3)
+int mesh_init_sphere(Mesh* mesh, float radius, int rings, int segments);
+
+// Unit normal of a triangle in leaf order, following its winding
+Vector3 mesh_triangle_normal(const Mesh* mesh, int triangle);
+
+void mesh_free(Mesh* mesh);
+
+int meshList_init(MeshList* list);
+// Moves a mesh into the list, which then owns its buffers (*mesh is left empty). Returns its index, or -1 on failure.
+int meshList_add(MeshList* list, Mesh* mesh);
+// Returns the index of the mesh loaded from path, or -1 if there is none
+int meshList_find_source(const MeshList* list, const char* path);
+void meshList_free(MeshList* list);
+
+#endif
@@ -1,13 +1,59 @@
 #include "./object.h"
 
-Object object_new_sphere(Vector3 center, Color color, float radius, int specularity, float reflectivity) {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+Object object_new_sphere(Vector3 center, float radius, int material) {
     Object obj;
+    memset(&obj, 0, sizeof(obj)); // The unused part of the union is written to binary scene files as well
     obj.type = OBJECT_TYPE_SPHERE;
     obj.position = center;
-    obj.color = color;
-    obj.specularity = specularity;
+    obj.material = material;
     obj.data.sphereData.radius = radius;
-    obj.reflectivity = reflectivity;
+    return obj;
+}
+
+Object object_new_cube(Vector3 center, float size, int material) {
+    Object obj = object_new_cuboid(center, vector3_new(size, size, size), material);
+    obj.type = OBJECT_TYPE_CUBE;
+    return obj;
+}
+
+Object object_new_cuboid(Vector3 center, Vector3 size, int material) {
+    Object obj;
+    memset(&obj, 0, sizeof(obj));
+    obj.type = OBJECT_TYPE_CUBOID;
+    obj.position = center;
+    obj.material = material;
+    obj.data.boxData.half_extents = vector3_scale(size, 0.5f);
+    return obj;
+}
+
+Object object_new_plane(Vector3 point, Vector3 normal, int material) {
+    Object obj;
+    memset(&obj, 0, sizeof(obj));
+    obj.type = OBJECT_TYPE_PLANE;
+    obj.position = point;
+    obj.material = material;
+    obj.data.planeData.normal = vector3_normalize(normal);
+    return obj;
+}
+
+Object object_new_mesh(Vector3 position, int mesh, int transform, int material) {
+    Object obj;
+    memset(&obj, 0, sizeof(obj));
+    obj.type = OBJECT_TYPE_MESH;
+    obj.position = position;
+    obj.material = material;
+    obj.data.instanceData.geometry = mesh;
+    obj.data.instanceData.transform = transform;
+    return obj;
+}
+
+Object object_new_sphere_set(Vector3 position, int sphere_set, int transform, int material) {
+    Object obj = object_new_mesh(position, sphere_set, transform, material);
+    obj.type = OBJECT_TYPE_SPHERE_SET;
     return obj;
 }
 
@@ -20,12 +66,150 @@ int objectList_init(ObjectList* objectList) {
     }
 
     objectList->objects = NULL;
+    objectList->spheres.center_x = NULL;
+    objectList->spheres.center_y = NULL;
+    objectList->spheres.center_z = NULL;
+    objectList->spheres.radius_sq = NULL;
     objectList->capacity = 0;
     objectList->count = 0;
+    objectList->generation = 0;
+    objectList->move_generation = 0;
+    objectList->external = 0;
 
     return 0;
 }
 
+// Grows one SoA array; the pointer is only replaced when realloc succeeds
+static int objectList_grow_floats(float** array, int new_capacity) {
+    float* grown = (float*)realloc(*array, (size_t)new_capacity * sizeof(float));
+    if (grown == NULL) {
+        return -1;
+    }
+    *array = grown;
+    return 0;
+}
+
+// Rewrites the SoA entry of one object from its position and extent
+static void objectList_refresh_mirror(ObjectList* list, int index) {
+    const Object* obj = &list->objects[index];
+    float radius_sq = 0.0f;
+    switch (obj->type) {
+        case OBJECT_TYPE_SPHERE:
+            radius_sq = obj->data.sphereData.radius * obj->data.sphereData.radius;
+            break;
+        case OBJECT_TYPE_CUBE:
+        case OBJECT_TYPE_CUBOID:
+            radius_sq = vector3_dot(obj->data.boxData.half_extents, obj->data.boxData.half_extents);
+            break;
+        case OBJECT_TYPE_PLANE:
+        case OBJECT_TYPE_MESH:     // Their extent is only known to the scene's geometry lists
+        case OBJECT_TYPE_SPHERE_SET:
+            break;
+    }
+
+    list->spheres.center_x[index] = obj->position.x;
+    list->spheres.center_y[index] = obj->position.y;
+    list->spheres.center_z[index] = obj->position.z;
+    list->spheres.radius_sq[index] = radius_sq;
+}
+
+void objectList_sync(ObjectList* list, int index) {
+    if (list == NULL || index < 0 || index >= list->count) {
+        return;
+    }
+
+    objectList_refresh_mirror(list, index);
+    list->generation++;
+}
+
+// Copies attached arrays into memory owned by the list so they can be reallocated and freed
+static int objectList_own(ObjectList* list) {
+    if (!list->external) {
+        return 0;
+    }
+
+    const size_t count = (size_t)(list->count > 0 ? list->count : 1);
+    Object* objects = (Object*)malloc(count * sizeof(Object));
+    float* center_x = (float*)malloc(count * sizeof(float));
+    float* center_y = (float*)malloc(count * sizeof(float));
+    float* center_z = (float*)malloc(count * sizeof(float));
+    float* radius_sq = (float*)malloc(count * sizeof(float));
+    if (objects == NULL || center_x == NULL || center_y == NULL || center_z == NULL || radius_sq == NULL) {
+        free(objects);
+        free(center_x);
+        free(center_y);
+        free(center_z);
+        free(radius_sq);
+        return -1;
+    }
+
+    const size_t used = (size_t)list->count;
+    memcpy(objects, list->objects, used * sizeof(Object));
+    memcpy(center_x, list->spheres.center_x, used * sizeof(float));
+    memcpy(center_y, list->spheres.center_y, used * sizeof(float));
+    memcpy(center_z, list->spheres.center_z, used * sizeof(float));
+    memcpy(radius_sq, list->spheres.radius_sq, used * sizeof(float));
+
+    list->objects = objects;
+    list->spheres.center_x = center_x;
+    list->spheres.center_y = center_y;
+    list->spheres.center_z = center_z;
+    list->spheres.radius_sq = radius_sq;
+    list->capacity = (int)count;
+    list->external = 0;
+    return 0;
+}
+
+int objectList_attach(ObjectList* list, Object* objects, SphereSoA spheres, int count) {
+    if (list == NULL || list->objects != NULL || count < 0 || (count > 0 && objects == NULL)) {
+        fprintf(stderr, "Error: objectList_attach needs an empty list and valid arrays.\n");
+        return -1;
+    }
+
+    list->objects = objects;
+    list->spheres = spheres;
+    list->capacity = count;
+    list->count = count;
+    list->external = 1;
+    list->generation++;
+    return 0;
+}
+
+// Resizes the object array and its SoA mirror to new_capacity elements
+static int objectList_grow(ObjectList* list, int new_capacity) {
+    if (objectList_own(list) != 0) {
+        return -1;
+    }
+
+    Object* new_objects = (Object*)realloc(list->objects, (size_t)new_capacity * sizeof(Object));
+
+    if (new_objects == NULL) {
+        // Reallocation failed
+        return -1;
+    }
+    list->objects = new_objects;
+
+    // Arrays that did grow keep their data, so a partial failure leaves the list consistent
+    if (objectList_grow_floats(&list->spheres.center_x, new_capacity) != 0 ||
+        objectList_grow_floats(&list->spheres.center_y, new_capacity) != 0 ||
+        objectList_grow_floats(&list->spheres.center_z, new_capacity) != 0 ||
+        objectList_grow_floats(&list->spheres.radius_sq, new_capacity) != 0) {
+        return -1;
+    }
+    list->capacity = new_capacity;
+    return 0;
+}
+
+int objectList_reserve(ObjectList* list, int capacity) {
+    if (list == NULL || capacity < 0) {
+        return -1;
+    }
+    if (capacity <= list->capacity) {
+        return 0;
+    }
+    return objectList_grow(list, capacity);
+}
+
 int objectList_add(ObjectList* list, Object obj) {
     if (list == NULL) {
         return -1; // Invalid list
@@ -34,29 +218,36 @@ int objectList_add(ObjectList* list, Object obj) {
     // If capacity is full, reallocate
     if (list->count == list->capacity) {
         int new_capacity = (list->capacity == 0) ? INITIAL_OBJECT_CAPACITY : list->capacity * 2;
-        Object* new_objects = (Object*)realloc(list->objects, new_capacity * sizeof(Object));
-
-        if (new_objects == NULL) {
-            // Reallocation failed
+        if (objectList_grow(list, new_capacity) != 0) {
             return -1;
         }
-        list->objects = new_objects;
-        list->capacity = new_capacity;
     }
 
     // Add the new object
     list->objects[list->count] = obj;
     list->count++;
+    objectList_sync(list, list->count - 1);
 
     return 0; // Success
 }
 
 void objectList_free(ObjectList* list) {
     if (list != NULL && list->objects != NULL) {
-        free(list->objects);
+        if (!list->external) {
+            free(list->objects);
+            free(list->spheres.center_x);
+            free(list->spheres.center_y);
+            free(list->spheres.center_z);
+            free(list->spheres.radius_sq);
+        }
         list->objects = NULL;
+        list->spheres.center_x = NULL;
+        list->spheres.center_y = NULL;
+        list->spheres.center_z = NULL;
+        list->spheres.radius_sq = NULL;
         list->capacity = 0;
         list->count = 0;
+        list->external = 0;
     }
 }
 
@@ -66,3 +257,42 @@ Object* objectList_get(ObjectList* list, int index) {
     }
     return NULL;
 }
+
+int objectList_move(ObjectList* list, int index, Vector3 position) {
+    if (list == NULL || index < 0 || index >= list->count) {
+        return -1;
+    }
+
+    list->objects[index].position = position;
+    objectList_refresh_mirror(list, index);
+    list->move_generation++;
+    return 0;
+}
+
+int objectList_reorder(ObjectList* list, const int* order) {
+    if (list == NULL || (list->count > 0 && order == NULL)) {
+        return -1;
+    }
+    if (objectList_own(list) != 0) {
+        return -1;
+    }
+
+    Object* reordered = (Object*)malloc((size_t)list->capacity * sizeof(Object));
+    if (reordered == NULL && list->capacity > 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < list->count; ++i) {
+        reordered[i] = list->objects[order[i]];
+    }
+
+    free(list->objects);
+    list->objects = reordered;
+
+    // The mirror follows the same permutation
+    for (int i = 0; i < list->count; ++i) {
+        objectList_sync(list, i);
+    }
+
+    return 0;
+}
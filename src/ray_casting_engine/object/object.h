@@ -1,7 +1,6 @@
 #pragma once
 
 #include "../vector/vector.h"
-#include "../color/color.h"
 
 #ifndef _OBJECT_H_
 #define _OBJECT_H_
@@ -9,36 +8,100 @@
 typedef enum ObjectType {
     OBJECT_TYPE_SPHERE,
     OBJECT_TYPE_CUBE,
-    OBJECT_TYPE_CUBOID
+    OBJECT_TYPE_CUBOID,
+    OBJECT_TYPE_PLANE,     // Infinite, so it is kept out of the BVH
+    OBJECT_TYPE_MESH,
+    OBJECT_TYPE_SPHERE_SET
 } ObjectType;
 
+#define OBJECT_MATERIAL_INHERIT -1  // Sphere set instances: keep the material of every sphere
+
 typedef struct SphereObjectData {
     float radius;
 } SphereObjectData;
 
+// Shared by cubes and cuboids: an axis-aligned box around Object.position
+typedef struct BoxObjectData {
+    Vector3 half_extents;
+} BoxObjectData;
+
+// The plane passes through Object.position
+typedef struct PlaneObjectData {
+    Vector3 normal;        // Unit vector
+} PlaneObjectData;
+
+// Instance of shared geometry: a triangle mesh of the scene's mesh list (OBJECT_TYPE_MESH) or a sphere set
+// of its sphere set list (OBJECT_TYPE_SPHERE_SET), rotated and scaled by a transform and moved to Object.position
+typedef struct InstanceObjectData {
+    int geometry;          // Index into the mesh or sphere set list
+    int transform;         // Index into the scene's transform list, or -1 for a translation only
+} InstanceObjectData;
+
 typedef struct Object {
     ObjectType type;
     Vector3 position;
-    Color color;
-    int specularity;
-    float reflectivity;
+    int material;          // Index into the scene's material table, or OBJECT_MATERIAL_INHERIT
 
     union {
         SphereObjectData sphereData;
+        BoxObjectData boxData;
+        PlaneObjectData planeData;
+        InstanceObjectData instanceData;
     } data;
 } Object;
 
+// Hot intersection data of every sphere, stored as separate arrays so a
+// SIMD kernel can test several spheres per instruction. Other objects keep
+// their center and the squared radius of their bounding sphere here (0 for planes and instances).
+typedef struct SphereSoA {
+    float* center_x;
+    float* center_y;
+    float* center_z;
+    float* radius_sq;   // Squared radius
+} SphereSoA;
+
 typedef struct ObjectList {
     Object* objects;
+    SphereSoA spheres;  // Mirror of objects[i].position and radius, same indices as objects
     int capacity;
     int count;
+    unsigned int generation;  // Incremented whenever an object is added or modified in the list
+    unsigned int move_generation; // Incremented whenever objectList_move changes only a position
+    int external;       // Arrays are owned elsewhere (e.g. a mapped scene file); copied before the list first grows
 } ObjectList;
 
-Object object_new_sphere(Vector3 center, Color color, float radius, int specularity, float reflectivity);
+Object object_new_sphere(Vector3 center, float radius, int material);
+// Axis-aligned cube with edges of length size
+Object object_new_cube(Vector3 center, float size, int material);
+// Axis-aligned box with edges of length size.x, size.y and size.z
+Object object_new_cuboid(Vector3 center, Vector3 size, int material);
+// Plane through point facing normal; the normal is normalized here
+Object object_new_plane(Vector3 point, Vector3 normal, int material);
+// Instance of mesh (an index into the scene's mesh list) with its origin moved to position,
+// after the rotation and scale of transform (an index into the scene's transform list, or -1 for none)
+Object object_new_mesh(Vector3 position, int mesh, int transform, int material);
+// Instance of a sphere set, placed like a mesh; material may be OBJECT_MATERIAL_INHERIT
+Object object_new_sphere_set(Vector3 position, int sphere_set, int transform, int material);
+// Whether an object has finite bounds and therefore belongs in a BVH
+static inline int object_is_bounded(const Object* object) {
+    return object->type != OBJECT_TYPE_PLANE;
+}
 
 int objectList_init(ObjectList* objectList);
 int objectList_add(ObjectList* list, Object obj);
+// Grows the list to hold at least capacity objects so that the following adds do not reallocate
+int objectList_reserve(ObjectList* list, int capacity);
+// Points an empty list at count objects and their SoA mirror owned by the caller, without copying.
+// The arrays must stay valid until the list is freed; they are copied only if the list has to grow.
+int objectList_attach(ObjectList* list, Object* objects, SphereSoA spheres, int count);
 void objectList_free(ObjectList* list);
 Object* objectList_get(ObjectList* list, int index);
+// Permutes the list so that new index i holds the object previously at order[i]
+int objectList_reorder(ObjectList* list, const int* order);
+// Refreshes the SoA mirror of one object after it was modified through objectList_get
+void objectList_sync(ObjectList* list, int index);
+// Moves one object in place and refreshes its mirror, counting it in move_generation only.
+// Returns 0 on success, -1 for an invalid index.
+int objectList_move(ObjectList* list, int index, Vector3 position);
 
 #endif
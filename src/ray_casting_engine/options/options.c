@@ -0,0 +1,184 @@
+#include "./options.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../cpu/cpu.h"
+
+void options_init(Options* options) {
+    options->headless = 0;
+    options->width = OPTIONS_DEFAULT_WIDTH;
+    options->height = OPTIONS_DEFAULT_HEIGHT;
+    options->frames = OPTIONS_DEFAULT_FRAMES;
+    options->output_path = NULL;
+    options->threads = 0;
+    options->cpu_level = -1;
+    options->speedup = 0;
+    options->packets = 1;
+    options->wavefront = 0;
+    options->recursion_depth = OPTIONS_DEFAULT_DEPTH;
+    options->adaptive = 0;
+    options->adaptive_tolerance = OPTIONS_DEFAULT_ADAPTIVE_TOLERANCE;
+    options->progressive = 1;
+    options->reproject = 0;
+    options->pan = 0.0f;
+    options->scene_path = NULL;
+    options->show_help = 0;
+}
+
+int options_parse_positive_int(const char* name, const char* value, int* out) {
+    char* end = NULL;
+    long parsed = strtol(value, &end, 10);
+
+    if (end == value || *end != '\0' || parsed <= 0 || parsed > 1 << 16) {
+        fprintf(stderr, "Error: %s expects a positive integer, got '%s'.\n", name, value);
+        return 1;
+    }
+
+    *out = (int)parsed;
+    return 0;
+}
+
+int options_parse_degrees(const char* name, const char* value, float* out) {
+    char* end = NULL;
+    float parsed = strtof(value, &end);
+
+    if (end == value || *end != '\0' || !(parsed >= -180.0f && parsed <= 180.0f)) {
+        fprintf(stderr, "Error: %s expects an angle in degrees between -180 and 180, got '%s'.\n", name, value);
+        return 1;
+    }
+
+    *out = parsed;
+    return 0;
+}
+
+int options_parse_non_negative_int(const char* name, const char* value, int* out) {
+    char* end = NULL;
+    long parsed = strtol(value, &end, 10);
+
+    if (end == value || *end != '\0' || parsed < 0 || parsed > 1 << 16) {
+        fprintf(stderr, "Error: %s expects a non-negative integer, got '%s'.\n", name, value);
+        return 1;
+    }
+
+    *out = (int)parsed;
+    return 0;
+}
+
+int options_parse(Options* options, int argc, char* argv[]) {
+    if (options == NULL) {
+        fprintf(stderr, "Error: options_parse received a NULL options pointer.\n");
+        return 1;
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        // Every option except the flags below takes exactly one value
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--headless") == 0) {
+            options->headless = 1;
+            continue;
+        }
+        if (strcmp(arg, "--speedup") == 0) {
+            options->speedup = 1;
+            continue;
+        }
+        if (strcmp(arg, "--no-packets") == 0) {
+            options->packets = 0;
+            continue;
+        }
+        if (strcmp(arg, "--no-progressive") == 0) {
+            options->progressive = 0;
+            continue;
+        }
+        if (strcmp(arg, "--adaptive") == 0) {
+            options->adaptive = 1;
+            continue;
+        }
+        if (strcmp(arg, "--reproject") == 0) {
+            // Refinement passes never reach full resolution while moving, so reprojection renders whole frames
+            options->reproject = 1;
+            options->progressive = 0;
+            continue;
+        }
+        if (strcmp(arg, "--wavefront") == 0) {
+            options->wavefront = 1;
+            continue;
+        }
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            options->show_help = 1;
+            continue;
+        }
+
+        if (value == NULL) {
+            fprintf(stderr, "Error: unknown option or missing value for '%s'.\n", arg);
+            return 1;
+        }
+
+        if (strcmp(arg, "--width") == 0) {
+            if (options_parse_positive_int(arg, value, &options->width) != 0) return 1;
+        } else if (strcmp(arg, "--height") == 0) {
+            if (options_parse_positive_int(arg, value, &options->height) != 0) return 1;
+        } else if (strcmp(arg, "--frames") == 0) {
+            if (options_parse_positive_int(arg, value, &options->frames) != 0) return 1;
+        } else if (strcmp(arg, "--threads") == 0) {
+            if (options_parse_positive_int(arg, value, &options->threads) != 0) return 1;
+        } else if (strcmp(arg, "--cpu") == 0) {
+            CpuLevel level;
+            if (cpu_parse_level(value, &level) != 0) {
+                fprintf(stderr, "Error: --cpu expects scalar, sse, avx2 or avx512, got '%s'.\n", value);
+                return 1;
+            }
+            options->cpu_level = (int)level;
+        } else if (strcmp(arg, "--depth") == 0) {
+            if (options_parse_non_negative_int(arg, value, &options->recursion_depth) != 0) return 1;
+        } else if (strcmp(arg, "--tolerance") == 0) {
+            if (options_parse_non_negative_int(arg, value, &options->adaptive_tolerance) != 0) return 1;
+            options->adaptive = 1;
+        } else if (strcmp(arg, "--pan") == 0) {
+            if (options_parse_degrees(arg, value, &options->pan) != 0) return 1;
+        } else if (strcmp(arg, "--out") == 0) {
+            options->output_path = value;
+        } else if (strcmp(arg, "--scene") == 0) {
+            options->scene_path = value;
+        } else {
+            fprintf(stderr, "Error: unknown option '%s'.\n", arg);
+            return 1;
+        }
+        ++i; // Skip the consumed value
+    }
+
+    // The recursive paths use one chain of C stack frames per bounce; only wavefront queues go deeper
+    if (options->recursion_depth > OPTIONS_MAX_RECURSIVE_DEPTH && !options->wavefront) {
+        fprintf(stderr, "Error: --depth above %d needs --wavefront, got %d.\n", OPTIONS_MAX_RECURSIVE_DEPTH, options->recursion_depth);
+        return 1;
+    }
+
+    return 0;
+}
+
+void options_print_usage(FILE* stream, const char* program_name) {
+    fprintf(stream,
+        "Usage: %s [options]\n"
+        "  --headless          Render without opening a window and exit\n"
+        "  --width <pixels>    Canvas width (default %d)\n"
+        "  --height <pixels>   Canvas height (default %d)\n"
+        "  --frames <count>    Frames to render in headless mode (default %d)\n"
+        "  --out <file.ppm>    Write the last headless frame as a PPM image\n"
+        "  --scene <file>      Load a text or binary scene file instead of the built-in scene\n"
+        "  --threads <count>   Render threads (default: one per logical CPU)\n"
+        "  --speedup           Headless: report the speedup from 1 to --threads threads\n"
+        "  --cpu <level>       SIMD kernels: scalar, sse, avx2 or avx512 (default: the best the CPU supports)\n"
+        "  --no-packets        Trace primary rays one by one instead of 2x2 SIMD packets\n"
+        "  --wavefront         Trace tiles breadth first through ray queues instead of recursively\n"
+        "  --depth <bounces>   Reflection bounces per primary ray (default %d, at most %d without --wavefront)\n"
+        "  --adaptive          Trace a sparse grid and interpolate cells whose corners agree\n"
+        "  --tolerance <0-255> Adaptive: largest color difference still interpolated (default %d, implies --adaptive)\n"
+        "  --no-progressive    Viewer: render every frame at full resolution instead of refining in passes\n"
+        "  --reproject         Reuse the previous frame where it reprojects into the new view (implies --no-progressive)\n"
+        "  --pan <degrees>     Headless: turn the camera left by this angle between frames\n"
+        "  --help              Show this message\n",
+        program_name, OPTIONS_DEFAULT_WIDTH, OPTIONS_DEFAULT_HEIGHT, OPTIONS_DEFAULT_FRAMES,
+        OPTIONS_DEFAULT_DEPTH, OPTIONS_MAX_RECURSIVE_DEPTH, OPTIONS_DEFAULT_ADAPTIVE_TOLERANCE);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdio.h>
+
+#ifndef _OPTIONS_H_
+#define _OPTIONS_H_
+
+#define OPTIONS_DEFAULT_WIDTH 800
+#define OPTIONS_DEFAULT_HEIGHT 600
+#define OPTIONS_DEFAULT_FRAMES 1
+#define OPTIONS_DEFAULT_DEPTH 3 ///< Matches ENGINE_DEFAULT_RECURSION_DEPTH.
+#define OPTIONS_MAX_RECURSIVE_DEPTH 256 ///< Matches ENGINE_MAX_RECURSIVE_DEPTH; deeper --depth values need --wavefront.
+#define OPTIONS_DEFAULT_ADAPTIVE_TOLERANCE 8 ///< Matches ENGINE_DEFAULT_ADAPTIVE_TOLERANCE.
+
+/**
+ * @brief Command line configuration of the ray caster.
+ */
+typedef struct Options {
+    int headless;              ///< Render without SDL video and exit (1) or open the interactive viewer (0).
+    int width;                 ///< Canvas width in pixels.
+    int height;                ///< Canvas height in pixels.
+    int frames;                ///< Number of frames rendered in headless mode.
+    const char* output_path;   ///< PPM file the last headless frame is written to (NULL to skip).
+    int threads;               ///< Render threads including the main thread; 0 means one per logical CPU.
+    int cpu_level;             ///< SIMD kernel level to force (a CpuLevel), or -1 to use the best one the CPU supports.
+    int speedup;               ///< Headless only: time 1..threads workers and report the speedup.
+    int packets;               ///< Trace primary rays as 2x2 SIMD packets.
+    int wavefront;             ///< Trace tiles breadth first through ray queues instead of recursively.
+    int recursion_depth;       ///< Reflection bounces per primary ray.
+    int adaptive;              ///< Interpolate smooth regions from sparse primary rays.
+    int adaptive_tolerance;    ///< Per-channel color difference (0-255) still interpolated in adaptive mode.
+    int progressive;           ///< Interactive only: coarse preview while moving, refined passes at rest.
+    int reproject;             ///< Reuse pixels of the previous frame that reproject into the new view.
+    float pan;                 ///< Headless only: degrees the camera turns left between frames.
+    const char* scene_path;    ///< Text or binary scene file to load instead of the built-in scene (NULL for built-in).
+    int show_help;             ///< Set when --help was requested.
+} Options;
+
+// Fills the options with their defaults
+void options_init(Options* options);
+
+// Parses argv into the options. Returns 0 on success, 1 on invalid arguments.
+int options_parse(Options* options, int argc, char* argv[]);
+
+// Parse the value of option name into *out, printing an error and returning 1 when it is not a
+// positive (or non-negative) integer up to 65536. Return 0 on success. Shared with the other command line tools.
+int options_parse_positive_int(const char* name, const char* value, int* out);
+int options_parse_non_negative_int(const char* name, const char* value, int* out);
+// Same for an angle in degrees between -180 and 180
+int options_parse_degrees(const char* name, const char* value, float* out);
+
+// Prints the command line usage
+void options_print_usage(FILE* stream, const char* program_name);
+
+#endif
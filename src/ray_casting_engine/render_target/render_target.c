@@ -0,0 +1,144 @@
+#include "./render_target.h"
+
+// Resets every resource pointer so that render_target_clean_up is always safe to call.
+static void render_target_reset(RenderTarget* target, RenderTargetType type, const Canvas* canvas) {
+    target->type = type;
+    target->width = canvas->width;
+    target->height = canvas->height;
+    target->pixel_buffer = NULL;
+    target->renderer = NULL;
+    target->canvas_texture = NULL;
+}
+
+static int render_target_allocate_pixels(RenderTarget* target) {
+    // One packed ARGB8888 value per canvas pixel
+    target->pixel_buffer = (unsigned int*)calloc((size_t)target->width * target->height, sizeof(unsigned int));
+    if (!target->pixel_buffer) {
+        fprintf(stderr, "Framebuffer allocation failed.\n");
+        return 1;
+    }
+    return 0;
+}
+
+int render_target_init_sdl(RenderTarget* target, SDL_Window* window, const Canvas* canvas) {
+    if (!target || !window || !canvas) {
+        fprintf(stderr, "Error: NULL pointer passed to render_target_init_sdl.\n");
+        return 1;
+    }
+
+    render_target_reset(target, RENDER_TARGET_SDL, canvas);
+
+    target->renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    if (!target->renderer) {
+        fprintf(stderr, "Renderer creation failed: %s\n", SDL_GetError());
+        // No need to destroy window/quit SDL here, it should be handled by the caller
+        return 1;
+    }
+
+    // Streaming texture that receives the whole framebuffer once per frame
+    target->canvas_texture = SDL_CreateTexture(
+        target->renderer,
+        SDL_PIXELFORMAT_ARGB8888, // Matches our pixel_buffer format
+        SDL_TEXTUREACCESS_STREAMING,
+        target->width,
+        target->height
+    );
+    if (!target->canvas_texture) {
+        fprintf(stderr, "Texture creation failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    return render_target_allocate_pixels(target);
+}
+
+int render_target_init_offscreen(RenderTarget* target, const Canvas* canvas) {
+    if (!target || !canvas) {
+        fprintf(stderr, "Error: NULL pointer passed to render_target_init_offscreen.\n");
+        return 1;
+    }
+
+    render_target_reset(target, RENDER_TARGET_OFFSCREEN, canvas);
+    return render_target_allocate_pixels(target);
+}
+
+void render_target_present(RenderTarget* target) {
+    if (!target || target->type != RENDER_TARGET_SDL ||
+        !target->renderer || !target->canvas_texture || !target->pixel_buffer) {
+        return;
+    }
+
+    // Update the texture with the pixel data from our buffer
+    SDL_UpdateTexture(
+        target->canvas_texture,
+        NULL, // Null rect means update the entire texture
+        target->pixel_buffer,
+        target->width * sizeof(unsigned int) // Pitch: bytes per row
+    );
+
+    // The texture covers the whole target, so no clear is needed before copying it
+    SDL_RenderCopy(target->renderer, target->canvas_texture, NULL, NULL);
+    SDL_RenderPresent(target->renderer);
+}
+
+int render_target_write_ppm(const RenderTarget* target, const char* path) {
+    if (!target || !target->pixel_buffer || !path) {
+        fprintf(stderr, "Error: NULL pointer passed to render_target_write_ppm.\n");
+        return 1;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        perror("Failed to open PPM output file");
+        return 1;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", target->width, target->height);
+
+    // Convert one row at a time from ARGB8888 to packed RGB
+    unsigned char* row = (unsigned char*)malloc((size_t)target->width * 3);
+    if (!row) {
+        fprintf(stderr, "Failed to allocate PPM row buffer.\n");
+        fclose(file);
+        return 1;
+    }
+
+    int status = 0;
+    for (int y = 0; y < target->height && status == 0; ++y) {
+        const unsigned int* pixels = target->pixel_buffer + (size_t)y * target->width;
+        for (int x = 0; x < target->width; ++x) {
+            row[x * 3 + 0] = (pixels[x] >> 16) & 0xFF;
+            row[x * 3 + 1] = (pixels[x] >> 8) & 0xFF;
+            row[x * 3 + 2] = pixels[x] & 0xFF;
+        }
+        if (fwrite(row, 3, (size_t)target->width, file) != (size_t)target->width) {
+            perror("Failed to write PPM row");
+            status = 1;
+        }
+    }
+
+    free(row);
+    if (fclose(file) != 0) {
+        perror("Failed to close PPM output file");
+        status = 1;
+    }
+    return status;
+}
+
+void render_target_clean_up(RenderTarget* target) {
+    if (target == NULL) {
+        return;
+    }
+
+    if (target->pixel_buffer) {
+        free(target->pixel_buffer);
+        target->pixel_buffer = NULL;
+    }
+    if (target->canvas_texture) {
+        SDL_DestroyTexture(target->canvas_texture);
+        target->canvas_texture = NULL;
+    }
+    if (target->renderer) {
+        SDL_DestroyRenderer(target->renderer);
+        target->renderer = NULL; // Prevent double-free
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+#include "../canvas/canvas.h"
+
+#ifndef _RENDER_TARGET_H_
+#define _RENDER_TARGET_H_
+
+/**
+ * @brief Where a finished framebuffer ends up.
+ */
+typedef enum RenderTargetType {
+    RENDER_TARGET_SDL,       ///< Uploaded to a streaming texture and presented in an SDL window.
+    RENDER_TARGET_OFFSCREEN  ///< Kept in memory only; no SDL video subsystem is required.
+} RenderTargetType;
+
+/**
+ * @brief A CPU framebuffer plus the backend that displays it.
+ */
+typedef struct RenderTarget {
+    RenderTargetType type;
+    int width;                     ///< Framebuffer width in pixels.
+    int height;                    ///< Framebuffer height in pixels.
+    unsigned int* pixel_buffer;    ///< One packed ARGB8888 value per pixel (row-major, top-left origin).
+
+    SDL_Renderer* renderer;        ///< SDL Renderer (RENDER_TARGET_SDL only).
+    SDL_Texture* canvas_texture;   ///< Streaming texture the framebuffer is uploaded into (RENDER_TARGET_SDL only).
+} RenderTarget;
+
+/**
+ * @brief Creates a target that presents into the given SDL window.
+ * @param target Pointer to the RenderTarget to initialize.
+ * @param window Pointer to the SDL_Window.
+ * @param canvas Pointer to the Canvas struct describing the framebuffer size.
+ * @return 0 on success, 1 on failure.
+ */
+int render_target_init_sdl(RenderTarget* target, SDL_Window* window, const Canvas* canvas);
+
+/**
+ * @brief Creates an in-memory target that never touches SDL video.
+ * @param target Pointer to the RenderTarget to initialize.
+ * @param canvas Pointer to the Canvas struct describing the framebuffer size.
+ * @return 0 on success, 1 on failure.
+ */
+int render_target_init_offscreen(RenderTarget* target, const Canvas* canvas);
+
+/**
+ * @brief Makes the current framebuffer visible.
+ * SDL targets upload it with a single texture update; offscreen targets do nothing.
+ * @param target Pointer to the RenderTarget.
+ */
+void render_target_present(RenderTarget* target);
+
+/**
+ * @brief Writes the framebuffer to disk as a binary PPM (P6) image.
+ * @param target Pointer to the RenderTarget.
+ * @param path Output file path.
+ * @return 0 on success, 1 on failure.
+ */
+int render_target_write_ppm(const RenderTarget* target, const char* path);
+
+/**
+ * @brief Releases the framebuffer and any SDL resources owned by the target.
+ * Safe to call on a partially initialized target.
+ * @param target Pointer to the RenderTarget.
+ */
+void render_target_clean_up(RenderTarget* target);
+
+#endif
@@ -0,0 +1,175 @@
+#include "./reprojection.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#include "../array/array.h"
+
+void reprojection_init(Reprojection* reprojection) {
+    memset(reprojection, 0, sizeof(*reprojection));
+}
+
+static int reprojection_reserve_buffer(ReprojectionBuffer* buffer, int count) {
+    if (array_reserve((void**)&buffer->positions, sizeof(Vector3), count) != 0 ||
+        array_reserve((void**)&buffer->objects, sizeof(int), count) != 0 ||
+        array_reserve((void**)&buffer->colors, sizeof(unsigned int), count) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Moves every history pixel to the new pixel its point projects onto.
+ * Where several land on the same pixel the nearest wins; background pixels are points at
+ * infinity along their stored direction and lose against any surface.
+ */
+static void reprojection_scatter(Reprojection* reprojection, const CameraFrame* camera, int object_count) {
+    const int width = reprojection->width;
+    const int height = reprojection->height;
+    const int half_width = width / 2;
+    const int top_pixel_y = height - height / 2 - 1;
+    const Vector3 origin = camera->origin;
+
+    // Primary directions are plane_center + x * pixel_right + y * pixel_up with all three orthogonal,
+    // so a direction d splits into s * (plane_center + x * pixel_right + y * pixel_up) by three dot products
+    const float inverse_center = 1.0f / vector3_dot(camera->plane_center, camera->plane_center);
+    const float inverse_right = 1.0f / vector3_dot(camera->pixel_right, camera->pixel_right);
+    const float inverse_up = 1.0f / vector3_dot(camera->pixel_up, camera->pixel_up);
+
+    const ReprojectionBuffer* history = &reprojection->history;
+    for (int i = 0; i < width * height; ++i) {
+        const int object = history->objects[i];
+        if (object >= object_count) {
+            continue;
+        }
+
+        const Vector3 offset = (object >= 0) ? vector3_subtract(history->positions[i], origin) : history->positions[i];
+        const float s = vector3_dot(offset, camera->plane_center) * inverse_center;
+        if (s <= 0.0f) {
+            continue; // Behind the camera
+        }
+
+        const float x = vector3_dot(offset, camera->pixel_right) * inverse_right / s;
+        const float y = vector3_dot(offset, camera->pixel_up) * inverse_up / s;
+        const int sdl_x = half_width + (int)floorf(x + 0.5f);
+        const int sdl_y = top_pixel_y - (int)floorf(y + 0.5f);
+        if (sdl_x < 0 || sdl_x >= width || sdl_y < 0 || sdl_y >= height) {
+            continue;
+        }
+
+        const int pixel = sdl_y * width + sdl_x;
+        const float depth = (object >= 0) ? s : FLT_MAX;
+        if (reprojection->sources[pixel] < 0 || depth < reprojection->depths[pixel]) {
+            reprojection->sources[pixel] = i;
+            reprojection->depths[pixel] = depth;
+        }
+    }
+}
+
+/**
+ * @brief Drops sources that sit clearly behind a neighbouring source.
+ * Surfaces that grow on screen leave gaps in their scattered pixels through which farther
+ * surfaces (or the background) would show; such pixels are traced instead. This also retraces
+ * the pixels along silhouettes, where the reused colors would be least reliable anyway.
+ */
+static void reprojection_reject_occluded(Reprojection* reprojection) {
+    const int width = reprojection->width;
+    const int height = reprojection->height;
+    const float* depths = reprojection->depths;
+
+    for (int y = 0; y < height; ++y) {
+        const int y0 = (y > 0) ? y - 1 : y;
+        const int y1 = (y + 1 < height) ? y + 1 : y;
+        for (int x = 0; x < width; ++x) {
+            const int pixel = y * width + x;
+            if (reprojection->sources[pixel] < 0) {
+                continue;
+            }
+
+            const int x0 = (x > 0) ? x - 1 : x;
+            const int x1 = (x + 1 < width) ? x + 1 : x;
+            float nearest = FLT_MAX;
+            for (int ny = y0; ny <= y1; ++ny) {
+                for (int nx = x0; nx <= x1; ++nx) {
+                    if (depths[ny * width + nx] < nearest) {
+                        nearest = depths[ny * width + nx];
+                    }
+                }
+            }
+
+            if (nearest < FLT_MAX && depths[pixel] > nearest * (1.0f + REPROJECTION_DEPTH_TOLERANCE)) {
+                reprojection->sources[pixel] = -1;
+            }
+        }
+    }
+}
+
+int reprojection_begin(Reprojection* reprojection, const CameraFrame* camera, int width, int height,
+                       const PreparedScene* scene, int recursion_depth) {
+    if (!reprojection || !camera || !scene || width <= 0 || height <= 0) {
+        fprintf(stderr, "Error: Invalid arguments passed to reprojection_begin.\n");
+        return -1;
+    }
+
+    const int pixel_count = width * height;
+    if (pixel_count > reprojection->capacity) {
+        if (reprojection_reserve_buffer(&reprojection->history, pixel_count) != 0 ||
+            reprojection_reserve_buffer(&reprojection->current, pixel_count) != 0 ||
+            array_reserve((void**)&reprojection->sources, sizeof(int), pixel_count) != 0 ||
+            array_reserve((void**)&reprojection->depths, sizeof(float), pixel_count) != 0) {
+            fprintf(stderr, "Error: Failed to allocate reprojection buffers for %d pixels.\n", pixel_count);
+            reprojection->valid = 0;
+            return -1;
+        }
+        reprojection->capacity = pixel_count;
+    }
+
+    if (width != reprojection->width || height != reprojection->height ||
+        scene->source != reprojection->scene || scene->generation != reprojection->scene_generation ||
+        recursion_depth != reprojection->recursion_depth) {
+        reprojection->valid = 0;
+    }
+    reprojection->width = width;
+    reprojection->height = height;
+    reprojection->scene = scene->source;
+    reprojection->scene_generation = scene->generation;
+    reprojection->recursion_depth = recursion_depth;
+
+    memset(reprojection->sources, 0xFF, sizeof(int) * (size_t)pixel_count); // All -1
+    for (int i = 0; i < pixel_count; ++i) {
+        reprojection->depths[i] = FLT_MAX;
+    }
+
+    if (reprojection->valid) {
+        reprojection_scatter(reprojection, camera, scene->objects->count);
+        reprojection_reject_occluded(reprojection);
+    }
+
+    return 0;
+}
+
+void reprojection_end(Reprojection* reprojection) {
+    ReprojectionBuffer rendered = reprojection->current;
+    reprojection->current = reprojection->history;
+    reprojection->history = rendered;
+    reprojection->valid = 1;
+    reprojection->frame_index++;
+}
+
+void reprojection_invalidate(Reprojection* reprojection) {
+    reprojection->valid = 0;
+}
+
+void reprojection_free(Reprojection* reprojection) {
+    free(reprojection->history.positions);
+    free(reprojection->history.objects);
+    free(reprojection->history.colors);
+    free(reprojection->current.positions);
+    free(reprojection->current.objects);
+    free(reprojection->current.colors);
+    free(reprojection->sources);
+    free(reprojection->depths);
+    reprojection_init(reprojection);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "../camera/camera.h"
+#include "../scene/scene.h"
+#include "../vector/vector.h"
+
+#ifndef _REPROJECTION_H_
+#define _REPROJECTION_H_
+
+#define REPROJECTION_REFRESH_GRID 4 ///< One pixel of every REPROJECTION_REFRESH_GRID^2 block is retraced per frame.
+#define REPROJECTION_DEPTH_TOLERANCE 0.05f ///< Relative depth above its nearest neighbour at which a reprojected pixel is distrusted.
+
+/**
+ * @brief Per-pixel record of one rendered frame, in framebuffer order.
+ */
+typedef struct ReprojectionBuffer {
+    Vector3* positions;        ///< Hit point, or the unit ray direction for background pixels.
+    int* objects;              ///< Index of the hit object in the prepared scene, -1 for the background.
+    unsigned int* colors;      ///< Final pixel color as written to the framebuffer (ARGB8888).
+} ReprojectionBuffer;
+
+/**
+ * @brief History of the previous frame and its mapping onto the frame being rendered.
+ * reprojection_begin scatters every history pixel to where its hit point lands in the new view;
+ * the renderer then reuses a pixel's color when the new primary ray still hits the same object
+ * and traces only the pixels left without a trusted source, plus a rotating refresh subset
+ * that bounds how long view-dependent shading (highlights, reflections) can stay stale.
+ */
+typedef struct Reprojection {
+    ReprojectionBuffer history;        ///< Frame rendered last.
+    ReprojectionBuffer current;        ///< Frame being rendered; becomes the history in reprojection_end.
+    int* sources;                      ///< History pixel reprojected onto each new pixel, -1 to trace it.
+    float* depths;                     ///< Camera depth of each pixel's source during the scatter.
+    int width;
+    int height;
+    int capacity;                      ///< Pixels every buffer has room for.
+
+    int valid;                         ///< The history holds a complete frame matching the fields below.
+    const struct Scene* scene;         ///< Scene the history was rendered from.
+    unsigned long scene_generation;    ///< Its generation at that time; any change discards the history.
+    int recursion_depth;               ///< Reflection depth the history was shaded with.
+    unsigned int frame_index;          ///< Selects the refresh subset; advances once per frame.
+} Reprojection;
+
+// Initializes an empty reprojection with no history
+void reprojection_init(Reprojection* reprojection);
+
+// Prepares a width x height frame seen through camera. Keeps the history only when it was rendered
+// at the same size from the same, unchanged scene with the same recursion depth, and scatters it into
+// the new view; otherwise every pixel is marked for tracing. Returns 0 on success, -1 on failure.
+int reprojection_begin(Reprojection* reprojection, const CameraFrame* camera, int width, int height,
+                       const PreparedScene* scene, int recursion_depth);
+
+// History pixel to reuse for framebuffer pixel (x, y), or -1 if the pixel has to be traced
+static inline int reprojection_source(const Reprojection* reprojection, int x, int y) {
+    const unsigned int cell = (unsigned int)(x % REPROJECTION_REFRESH_GRID) +
+                              (unsigned int)(y % REPROJECTION_REFRESH_GRID) * REPROJECTION_REFRESH_GRID;
+    if (cell == reprojection->frame_index % (REPROJECTION_REFRESH_GRID * REPROJECTION_REFRESH_GRID)) {
+        return -1;
+    }
+    return reprojection->sources[(size_t)y * reprojection->width + x];
+}
+
+// Records the result of framebuffer pixel index for the next frame
+static inline void reprojection_store(Reprojection* reprojection, int pixel, Vector3 position, int object, unsigned int color) {
+    reprojection->current.positions[pixel] = position;
+    reprojection->current.objects[pixel] = object;
+    reprojection->current.colors[pixel] = color;
+}
+
+// Makes the frame stored since reprojection_begin the history of the next one
+void reprojection_end(Reprojection* reprojection);
+
+// Discards the history so that the next frame is traced in full
+void reprojection_invalidate(Reprojection* reprojection);
+
+// Releases all buffers
+void reprojection_free(Reprojection* reprojection);
+
+#endif
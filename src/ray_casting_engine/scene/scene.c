@@ -1,6 +1,30 @@
 #include "./scene.h"
 
-int scene_init(Scene* scene) {
+#include <string.h>
+#include <sys/mman.h>
+
+#define SCENE_BOX_COST 1.0f       // SAH cost of a box slab test, in BVH node visits
+#define SCENE_INSTANCE_COST 4.0f  // ...and of an instance, which transforms the ray and walks its own hierarchy
+
+int scene_init_empty(Scene* scene) {
+    bvh_init(&scene->bvh);
+    scene->object_slots = NULL;
+    scene->object_slot_count = 0;
+    scene->plane_count = 0;
+    scene->lights = NULL;
+    scene->materials = NULL;
+    scene->meshes = NULL;
+    scene->sphere_sets = NULL;
+    scene->transforms = NULL;
+    scene->generation = 0;
+    scene->background_color = color_new(133.0f, 201.0f, 180.0f);
+    scene->camera.is_set = 0;
+    scene->camera.position = vector3_new(0.0f, 0.0f, 0.0f);
+    scene->camera.yaw = 0.0f;
+    scene->camera.pitch = 0.0f;
+    scene->mapping = NULL;
+    scene->mapping_size = 0;
+
     scene->objects = (ObjectList*)malloc(sizeof(ObjectList));
 
     if (scene->objects == NULL) {
@@ -15,16 +39,6 @@ int scene_init(Scene* scene) {
         return -1;
     }
 
-    Object sphere1 = object_new_sphere(vector3_new(0.0f, -1.0f, 3.0f), color_new(255.0f, 0.0f, 0.0f), 1.0f, 500, 0.2f);
-    Object sphere2 = object_new_sphere(vector3_new(-2.0f, 0.0f, 4.0f), color_new(0.0f, 255.0f, 0.0f), 1.0f, 1000, 0.4f);
-    Object sphere3 = object_new_sphere(vector3_new(2.0f, 0.0f, 4.0f), color_new(0.0f, 0.0f, 255.0f), 1.0f, 10, 0.3f);
-    Object sphere4 = object_new_sphere(vector3_new(0.0f, -5001.0f, 0.0f), color_new(255.0f, 255.0f, 0.0f), 5000.0f, 1000, 0.5f);
-
-    objectList_add(scene->objects, sphere1);
-    objectList_add(scene->objects, sphere2);
-    objectList_add(scene->objects, sphere3);
-    objectList_add(scene->objects, sphere4);
-
     scene->lights = (LightList*)malloc(sizeof(LightList));
 
     if (scene->lights == NULL) {
@@ -33,12 +47,91 @@ int scene_init(Scene* scene) {
     }
 
     if (lightList_init(scene->lights) != 0) {
-        free(scene->objects);
-        scene->objects = NULL;
+        free(scene->lights);
+        scene->lights = NULL;
         fprintf(stderr, "Error: Failed to initialize scene->lights.\n");
         return -1;
     }
 
+    scene->materials = (MaterialList*)malloc(sizeof(MaterialList));
+
+    if (scene->materials == NULL) {
+        perror("Failed to allocate memory for scene->materials");
+        return -1;
+    }
+
+    if (materialList_init(scene->materials) != 0) {
+        free(scene->materials);
+        scene->materials = NULL;
+        fprintf(stderr, "Error: Failed to initialize scene->materials.\n");
+        return -1;
+    }
+
+    scene->meshes = (MeshList*)malloc(sizeof(MeshList));
+
+    if (scene->meshes == NULL) {
+        perror("Failed to allocate memory for scene->meshes");
+        return -1;
+    }
+
+    if (meshList_init(scene->meshes) != 0) {
+        free(scene->meshes);
+        scene->meshes = NULL;
+        fprintf(stderr, "Error: Failed to initialize scene->meshes.\n");
+        return -1;
+    }
+
+    scene->sphere_sets = (SphereSetList*)malloc(sizeof(SphereSetList));
+
+    if (scene->sphere_sets == NULL) {
+        perror("Failed to allocate memory for scene->sphere_sets");
+        return -1;
+    }
+
+    if (sphereSetList_init(scene->sphere_sets) != 0) {
+        free(scene->sphere_sets);
+        scene->sphere_sets = NULL;
+        fprintf(stderr, "Error: Failed to initialize scene->sphere_sets.\n");
+        return -1;
+    }
+
+    scene->transforms = (TransformList*)malloc(sizeof(TransformList));
+
+    if (scene->transforms == NULL) {
+        perror("Failed to allocate memory for scene->transforms");
+        return -1;
+    }
+
+    if (transformList_init(scene->transforms) != 0) {
+        free(scene->transforms);
+        scene->transforms = NULL;
+        fprintf(stderr, "Error: Failed to initialize scene->transforms.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int scene_init(Scene* scene) {
+    if (scene_init_empty(scene) != 0) {
+        return -1;
+    }
+
+    int red = materialList_add(scene->materials, material_new(color_new(255.0f, 0.0f, 0.0f), 500, 0.2f));
+    int green = materialList_add(scene->materials, material_new(color_new(0.0f, 255.0f, 0.0f), 1000, 0.4f));
+    int blue = materialList_add(scene->materials, material_new(color_new(0.0f, 0.0f, 255.0f), 10, 0.3f));
+    int yellow = materialList_add(scene->materials, material_new(color_new(255.0f, 255.0f, 0.0f), 1000, 0.5f));
+
+    Object sphere1 = object_new_sphere(vector3_new(0.0f, -1.0f, 3.0f), 1.0f, red);
+    Object sphere2 = object_new_sphere(vector3_new(-2.0f, 0.0f, 4.0f), 1.0f, green);
+    Object sphere3 = object_new_sphere(vector3_new(2.0f, 0.0f, 4.0f), 1.0f, blue);
+    Object ground = object_new_plane(vector3_new(0.0f, -1.0f, 0.0f), vector3_new(0.0f, 1.0f, 0.0f), yellow);
+
+    objectList_add(scene->objects, sphere1);
+    objectList_add(scene->objects, sphere2);
+    objectList_add(scene->objects, sphere3);
+    objectList_add(scene->objects, ground);
+
     Light light1 = light_new_ambient(0.2f);
     Light light2 = light_new_point(vector3_new(2.0f, 1.0f, 0.0f), 0.6f);
     Light light3 = light_new_directional(vector3_new(1.0f, 4.0f, 4.0f), 0.2f);
@@ -47,17 +140,332 @@ int scene_init(Scene* scene) {
     lightList_add(scene->lights, light2);
     lightList_add(scene->lights, light3);
 
-    scene->background_color = color_new(133.0f, 201.0f, 180.0f);
+    return scene_build_acceleration(scene);
+}
+
+// World bounds of an instance: its geometry's bounds rotated, scaled and moved to the instance's position
+static Aabb scene_instance_bounds(const Scene* scene, const Object* instance) {
+    const InstanceObjectData* data = &instance->data.instanceData;
+    const Aabb local = (instance->type == OBJECT_TYPE_MESH) ? scene->meshes->meshes[data->geometry].bounds
+                                                            : scene->sphere_sets->sets[data->geometry].bounds;
+    if (data->transform < 0) {
+        Aabb box = { vector3_add(local.min, instance->position), vector3_add(local.max, instance->position) };
+        return box;
+    }
+
+    // Center and half extent of the rotated box; each world axis collects the absolute rotated extents
+    const Transform* transform = &scene->transforms->transforms[data->transform];
+    const float* m = transform->rotation;
+    const Vector3 center = vector3_scale(vector3_add(local.min, local.max), 0.5f);
+    const Vector3 half = vector3_scale(vector3_subtract(local.max, local.min), 0.5f);
+    const Vector3 world_center = vector3_add(instance->position, vector3_scale(transform_rotate(transform, center), transform->scale));
+    const Vector3 world_half = vector3_scale(vector3_new(fabsf(m[0]) * half.x + fabsf(m[1]) * half.y + fabsf(m[2]) * half.z,
+                                                         fabsf(m[3]) * half.x + fabsf(m[4]) * half.y + fabsf(m[5]) * half.z,
+                                                         fabsf(m[6]) * half.x + fabsf(m[7]) * half.y + fabsf(m[8]) * half.z),
+                                             transform->scale);
+    Aabb box = { vector3_subtract(world_center, world_half), vector3_add(world_center, world_half) };
+    return box;
+}
+
+// Bounding box of a single bounded object; instances must reference existing geometry and transforms
+static Aabb scene_object_bounds(const Scene* scene, const Object* object) {
+    if (object->type == OBJECT_TYPE_MESH || object->type == OBJECT_TYPE_SPHERE_SET) {
+        return scene_instance_bounds(scene, object);
+    }
+
+    Vector3 extent;
+    if (object->type == OBJECT_TYPE_SPHERE) {
+        const float radius = object->data.sphereData.radius;
+        extent = vector3_new(radius, radius, radius);
+    } else {
+        extent = object->data.boxData.half_extents;
+    }
+    Aabb box = { vector3_subtract(object->position, extent), vector3_add(object->position, extent) };
+    return box;
+}
+
+// SAH cost of testing one bounded object; spheres go through the SIMD kernel
+static float scene_object_cost(const Object* object) {
+    switch (object->type) {
+        case OBJECT_TYPE_CUBE:
+        case OBJECT_TYPE_CUBOID:
+            return SCENE_BOX_COST;
+        case OBJECT_TYPE_MESH:
+        case OBJECT_TYPE_SPHERE_SET:
+            return SCENE_INSTANCE_COST;
+        default:
+            return BVH_PRIMITIVE_COST;
+    }
+}
+
+// Checks the geometry and transform references of every instance; the other types reference nothing that could be missing
+static int scene_check_instances(const Scene* scene) {
+    const ObjectList* objects = scene->objects;
+    for (int i = 0; i < objects->count; ++i) {
+        const Object* object = &objects->objects[i];
+        if (object->type != OBJECT_TYPE_MESH && object->type != OBJECT_TYPE_SPHERE_SET) {
+            continue;
+        }
+
+        const InstanceObjectData* data = &object->data.instanceData;
+        const int geometry_count = (object->type == OBJECT_TYPE_MESH) ? scene->meshes->count : scene->sphere_sets->count;
+        if (data->geometry < 0 || data->geometry >= geometry_count) {
+            fprintf(stderr, "Error: Object %d references %s %d, but the scene has %d.\n", i,
+                    (object->type == OBJECT_TYPE_MESH) ? "mesh" : "sphere set", data->geometry, geometry_count);
+            return -1;
+        }
+        if (data->transform < -1 || data->transform >= scene->transforms->count) {
+            fprintf(stderr, "Error: Object %d references transform %d, but the scene has %d.\n",
+                    i, data->transform, scene->transforms->count);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Checks the material reference of every object and of every sphere in a sphere set
+static int scene_check_materials(const Scene* scene) {
+    const ObjectList* objects = scene->objects;
+    const int material_count = (int)scene->materials->count;
+    for (int i = 0; i < objects->count; ++i) {
+        const int material = objects->objects[i].material;
+        const int inherits = material == OBJECT_MATERIAL_INHERIT && objects->objects[i].type == OBJECT_TYPE_SPHERE_SET;
+        if (!inherits && (material < 0 || material >= material_count)) {
+            fprintf(stderr, "Error: Object %d references material %d, but the scene has %d materials.\n",
+                    i, material, material_count);
+            return -1;
+        }
+    }
+
+    const SphereSetList* sets = scene->sphere_sets;
+    for (int i = 0; i < sets->count; ++i) {
+        for (int j = 0; j < sets->sets[i].count; ++j) {
+            const int material = sets->sets[i].materials[j];
+            if (material < 0 || material >= material_count) {
+                fprintf(stderr, "Error: Sphere %d of sphere set %d references material %d, but the scene has %d materials.\n",
+                        j, i, material, material_count);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Refit callback: bounds of the object at a leaf-order index
+static Aabb scene_primitive_bounds(const void* context, int primitive) {
+    const Scene* scene = (const Scene*)context;
+    return scene_object_bounds(scene, &scene->objects->objects[primitive]);
+}
+
+// Keeps every object id pointing at its object when new index i receives the object from old index order[i]
+static int scene_track_reorder(Scene* scene, const int* order, int count) {
+    if (scene->object_slot_count < count) {
+        int* slots = (int*)realloc(scene->object_slots, (size_t)count * sizeof(int));
+        if (slots == NULL) {
+            return -1;
+        }
+        // Objects added since the last build are still where they were appended
+        for (int id = scene->object_slot_count; id < count; ++id) {
+            slots[id] = id;
+        }
+        scene->object_slots = slots;
+        scene->object_slot_count = count;
+    }
+
+    int* new_index = (int*)malloc((size_t)(count > 0 ? count : 1) * sizeof(int));
+    if (new_index == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < count; ++i) {
+        new_index[order[i]] = i;
+    }
+    for (int id = 0; id < count; ++id) {
+        scene->object_slots[id] = new_index[scene->object_slots[id]];
+    }
+
+    free(new_index);
+    return 0;
+}
+
+// Builds the BVH from scratch over the bounded objects and moves the objects into leaf order, planes last
+static int scene_rebuild_acceleration(Scene* scene) {
+    if (scene_check_instances(scene) != 0) {
+        return -1;
+    }
+
+    const int count = scene->objects->count;
+    const Object* objects = scene->objects->objects;
+
+    Aabb* bounds = (Aabb*)malloc((size_t)(count > 0 ? count : 1) * sizeof(Aabb));
+    unsigned char* kinds = (unsigned char*)malloc((size_t)(count > 0 ? count : 1));
+    float* costs = (float*)calloc((size_t)(count > 0 ? count : 1), sizeof(float));
+    int* bounded = (int*)malloc((size_t)(count > 0 ? count : 1) * sizeof(int));
+    int* order = (int*)malloc((size_t)(count > 0 ? count : 1) * sizeof(int));
+    if (bounds == NULL || kinds == NULL || costs == NULL || bounded == NULL || order == NULL) {
+        free(bounds);
+        free(kinds);
+        free(costs);
+        free(bounded);
+        free(order);
+        fprintf(stderr, "Error: failed to allocate BVH build input.\n");
+        return -1;
+    }
+
+    int bounded_count = 0;
+    for (int i = 0; i < count; ++i) {
+        if (object_is_bounded(&objects[i])) {
+            bounds[bounded_count] = scene_object_bounds(scene, &objects[i]);
+            kinds[bounded_count] = (unsigned char)objects[i].type;
+            costs[bounded_count] = scene_object_cost(&objects[i]);
+            bounded[bounded_count++] = i;
+        }
+    }
+
+    int status = bvh_build(&scene->bvh, bounds, kinds, costs, bounded_count, order);
+    if (status == 0) {
+        // The build orders the bounded objects among themselves; map that back to list indices
+        for (int i = 0; i < bounded_count; ++i) {
+            order[i] = bounded[order[i]];
+        }
+        int next = bounded_count;
+        for (int i = 0; i < count; ++i) {
+            if (!object_is_bounded(&objects[i])) {
+                order[next++] = i;
+            }
+        }
+        // Store objects in leaf order so traversal reads them sequentially
+        status = objectList_reorder(scene->objects, order);
+    }
+    if (status == 0) {
+        status = scene_track_reorder(scene, order, count);
+    }
+
+    free(bounds);
+    free(kinds);
+    free(costs);
+    free(bounded);
+    free(order);
+
+    if (status != 0) {
+        bvh_free(&scene->bvh);
+        scene->plane_count = 0;
+        fprintf(stderr, "Error: failed to build the scene BVH.\n");
+        return -1;
+    }
+
+    scene->plane_count = count - bounded_count;
+    scene->generation++;
+    return 0;
+}
+
+int scene_build_acceleration(Scene* scene) {
+    if (scene == NULL || scene->objects == NULL) {
+        fprintf(stderr, "Error: scene_build_acceleration received an uninitialized scene.\n");
+        return -1;
+    }
+
+    Uint64 build_start = SDL_GetPerformanceCounter();
+    if (scene_rebuild_acceleration(scene) != 0) {
+        return -1;
+    }
+
+    double build_ms = (double)(SDL_GetPerformanceCounter() - build_start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    printf("Built BVH: %d nodes over %d objects in %.2f ms\n", scene->bvh.node_count, scene->objects->count, build_ms);
+    return 0;
+}
+
+int scene_object_index(const Scene* scene, int id) {
+    if (scene == NULL || scene->objects == NULL || id < 0 || id >= scene->objects->count) {
+        return -1;
+    }
+    return (id < scene->object_slot_count) ? scene->object_slots[id] : id;
+}
+
+int scene_move_object(Scene* scene, int id, Vector3 position) {
+    const int index = scene_object_index(scene, id);
+    if (index < 0 || objectList_move(scene->objects, index, position) != 0) {
+        fprintf(stderr, "Error: scene_move_object received an invalid object id %d.\n", id);
+        return -1;
+    }
 
+    // Planes and objects added after the last build are not in the tree; scene_update_acceleration rebuilds for the latter
+    if (index < scene->bvh.primitive_count && bvh_mark_primitive(&scene->bvh, index) != 0) {
+        return -1;
+    }
     return 0;
 }
 
+int scene_update_acceleration(Scene* scene) {
+    if (scene == NULL || scene->objects == NULL) {
+        fprintf(stderr, "Error: scene_update_acceleration received an uninitialized scene.\n");
+        return -1;
+    }
+
+    if (scene->bvh.primitive_count + scene->plane_count == scene->objects->count) {
+        bvh_refit(&scene->bvh, scene_primitive_bounds, scene);
+        if (bvh_inflation(&scene->bvh) <= BVH_REBUILD_INFLATION) {
+            return 0;
+        }
+    }
+
+    return (scene_rebuild_acceleration(scene) == 0) ? 1 : -1;
+}
+
+void scene_mark_changed(Scene* scene) {
+    if (scene != NULL) {
+        scene->generation++;
+    }
+}
+
+// Change counter of everything scene_prepare checks or bakes: every counter except object moves
+static unsigned long scene_content_generation(const Scene* scene) {
+    // Every counter only grows, so the sum changes whenever any of them does
+    unsigned long generation = scene->generation;
+    if (scene->objects != NULL) {
+        generation += scene->objects->generation;
+    }
+    if (scene->lights != NULL) {
+        generation += scene->lights->generation;
+    }
+    if (scene->materials != NULL) {
+        generation += scene->materials->generation;
+    }
+    if (scene->meshes != NULL) {
+        generation += scene->meshes->generation;
+    }
+    if (scene->sphere_sets != NULL) {
+        generation += scene->sphere_sets->generation;
+    }
+    if (scene->transforms != NULL) {
+        generation += scene->transforms->generation;
+    }
+    return generation;
+}
+
+unsigned long scene_generation(const Scene* scene) {
+    if (scene == NULL) {
+        return 0;
+    }
+
+    unsigned long generation = scene_content_generation(scene);
+    if (scene->objects != NULL) {
+        generation += scene->objects->move_generation;
+    }
+    return generation;
+}
+
 void scene_clean_up(Scene* scene) {
     if (scene == NULL) {
         // Nothing to clean up if the scene pointer is NULL
         return;
     }
 
+    bvh_free(&scene->bvh);
+    free(scene->object_slots);
+    scene->object_slots = NULL;
+    scene->object_slot_count = 0;
+    scene->plane_count = 0;
+
     // Clean up objects list
     if (scene->objects != NULL) {
         // Assuming objectList_clean_up deallocates any internal arrays within ObjectList
@@ -73,4 +481,205 @@ void scene_clean_up(Scene* scene) {
         free(scene->lights);
         scene->lights = NULL; // Set to NULL after freeing to prevent double-free
     }
+
+    if (scene->materials != NULL) {
+        materialList_free(scene->materials);
+        free(scene->materials);
+        scene->materials = NULL;
+    }
+
+    if (scene->meshes != NULL) {
+        meshList_free(scene->meshes);
+        free(scene->meshes);
+        scene->meshes = NULL;
+    }
+
+    if (scene->sphere_sets != NULL) {
+        sphereSetList_free(scene->sphere_sets);
+        free(scene->sphere_sets);
+        scene->sphere_sets = NULL;
+    }
+
+    if (scene->transforms != NULL) {
+        transformList_free(scene->transforms);
+        free(scene->transforms);
+        scene->transforms = NULL;
+    }
+
+    // The lists and the BVH may point into the mapping, so it goes last
+    if (scene->mapping != NULL) {
+        munmap(scene->mapping, scene->mapping_size);
+        scene->mapping = NULL;
+        scene->mapping_size = 0;
+    }
+}
+
+void scene_prepared_init(PreparedScene* prepared) {
+    memset(prepared, 0, sizeof(*prepared));
+}
+
+// Grows one snapshot array to hold count elements; the contents are rewritten by the caller
+static int scene_prepared_reserve(void** array, int* capacity, size_t count, size_t element_size, const char* what) {
+    if (count <= (size_t)*capacity) {
+        return 0;
+    }
+
+    void* resized = realloc(*array, count * element_size);
+    if (resized == NULL) {
+        fprintf(stderr, "Error: Failed to allocate %zu prepared %s.\n", count, what);
+        return -1;
+    }
+    *array = resized;
+    *capacity = (int)count;
+    return 0;
+}
+
+static int scene_compare_ints(const void* a, const void* b) {
+    const int left = *(const int*)a;
+    const int right = *(const int*)b;
+    return (left > right) - (left < right);
+}
+
+static int scene_prepare_lights(const LightList* lights, PreparedScene* prepared) {
+    if (scene_prepared_reserve((void**)&prepared->lights, &prepared->light_capacity,
+                               lights->count, sizeof(PreparedLight), "lights") != 0) {
+        return -1;
+    }
+
+    prepared->light_count = 0;
+    prepared->ambient_intensity = 0.0f;
+    for (size_t i = 0; i < lights->count; ++i) {
+        const Light* light = &lights->lights[i];
+        PreparedLight* baked = &prepared->lights[prepared->light_count];
+
+        switch (light->type) {
+            case LIGHT_TYPE_AMBIENT:
+                prepared->ambient_intensity += light->intensity;
+                continue;
+            case LIGHT_TYPE_POINT:
+                baked->vector = light->data.pointData.position;
+                break;
+            case LIGHT_TYPE_DIRECTIONAL:
+                baked->vector = vector3_normalize(light->data.directionalData.direction);
+                break;
+            default:
+                fprintf(stderr, "Warning: Unknown Light Type skipped in scene_prepare.\n");
+                continue;
+        }
+        baked->type = light->type;
+        baked->intensity = light->intensity;
+        prepared->light_count++;
+    }
+    return 0;
+}
+
+// Bakes the materials and builds one specular table per distinct exponent
+static int scene_prepare_materials(const MaterialList* materials, PreparedScene* prepared) {
+    const size_t count = materials->count;
+    if (scene_prepared_reserve((void**)&prepared->materials, &prepared->material_capacity,
+                               count, sizeof(PreparedMaterial), "materials") != 0) {
+        return -1;
+    }
+
+    int* exponents = (int*)malloc((count > 0 ? count : 1) * sizeof(int));
+    if (exponents == NULL) {
+        fprintf(stderr, "Error: Failed to allocate the specular exponent list.\n");
+        return -1;
+    }
+
+    size_t exponent_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (materials->materials[i].specularity > 0) {
+            exponents[exponent_count++] = materials->materials[i].specularity;
+        }
+    }
+    qsort(exponents, exponent_count, sizeof(int), scene_compare_ints);
+
+    size_t distinct = 0;
+    for (size_t i = 0; i < exponent_count; ++i) {
+        if (distinct == 0 || exponents[distinct - 1] != exponents[i]) {
+            exponents[distinct++] = exponents[i];
+        }
+    }
+
+    if (scene_prepared_reserve((void**)&prepared->specular_tables, &prepared->specular_table_capacity,
+                               distinct, sizeof(SpecularTable), "specular tables") != 0) {
+        free(exponents);
+        return -1;
+    }
+    for (size_t i = 0; i < distinct; ++i) {
+        specular_table_init(&prepared->specular_tables[i], exponents[i]);
+    }
+    prepared->specular_table_count = (int)distinct;
+
+    for (size_t i = 0; i < count; ++i) {
+        const Material* material = &materials->materials[i];
+        PreparedMaterial* baked = &prepared->materials[i];
+        baked->color = material->color;
+        baked->reflectivity = material->reflectivity;
+        baked->specular = NULL;
+        if (material->specularity > 0) {
+            const int* found = (const int*)bsearch(&material->specularity, exponents, distinct, sizeof(int), scene_compare_ints);
+            baked->specular = &prepared->specular_tables[found - exponents];
+        }
+    }
+    prepared->material_count = (int)count;
+
+    free(exponents);
+    return 0;
+}
+
+int scene_prepare(const Scene* scene, PreparedScene* prepared) {
+    if (scene == NULL || scene->objects == NULL || scene->lights == NULL || scene->materials == NULL || scene->meshes == NULL ||
+        scene->sphere_sets == NULL || scene->transforms == NULL || prepared == NULL) {
+        fprintf(stderr, "Error: scene_prepare received an uninitialized scene.\n");
+        return -1;
+    }
+
+    const unsigned long generation = scene_generation(scene);
+    if (prepared->source == scene && prepared->generation == generation) {
+        return 0;
+    }
+
+    // Moved objects are read in place and keep their materials and references, so an animated
+    // frame whose BVH was only refitted needs no new checks or baked tables
+    const unsigned long content_generation = scene_content_generation(scene);
+    if (prepared->source == scene && prepared->content_generation == content_generation) {
+        prepared->generation = generation;
+        return 0;
+    }
+
+    // A failed snapshot must not be mistaken for an up-to-date one
+    prepared->source = NULL;
+
+    if (scene_check_materials(scene) != 0 || scene_check_instances(scene) != 0) {
+        return -1;
+    }
+
+    if (scene_prepare_lights(scene->lights, prepared) != 0 ||
+        scene_prepare_materials(scene->materials, prepared) != 0) {
+        return -1;
+    }
+
+    prepared->objects = scene->objects;
+    prepared->bvh = &scene->bvh;
+    prepared->plane_first = scene->bvh.primitive_count;
+    prepared->plane_count = scene->plane_count;
+    prepared->meshes = scene->meshes;
+    prepared->sphere_sets = scene->sphere_sets;
+    prepared->transforms = scene->transforms;
+    prepared->background_color = scene->background_color;
+    prepared->source = scene;
+    prepared->generation = generation;
+    prepared->content_generation = content_generation;
+    return 0;
+}
+
+void scene_prepared_free(PreparedScene* prepared) {
+    if (prepared != NULL) {
+        free(prepared->lights);
+        free(prepared->materials);
+        free(prepared->specular_tables);
+        scene_prepared_init(prepared);
+    }
 }
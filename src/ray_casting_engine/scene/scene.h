@@ -5,18 +5,117 @@
 
 #include "../object/object.h"
 #include "../light/light.h"
+#include "../material/material.h"
+#include "../mesh/mesh.h"
+#include "../sphere_set/sphere_set.h"
+#include "../transform/transform.h"
 #include "../vector/vector.h"
 #include "../color/color.h"
+#include "../bvh/bvh.h"
 
 #ifndef _SCENE_H_
 #define _SCENE_H_
 
+// Viewpoint stored with a scene; applications fall back to their own camera when is_set is 0
+typedef struct SceneCamera {
+    int is_set;
+    Vector3 position;
+    float yaw;             // Radians, same convention as Camera.yaw
+    float pitch;           // Radians
+} SceneCamera;
+
+// Shadow-casting light with its invariants baked in (see scene_prepare)
+typedef struct PreparedLight {
+    LightType type;        // LIGHT_TYPE_POINT or LIGHT_TYPE_DIRECTIONAL
+    float intensity;
+    Vector3 vector;        // Point light: position. Directional light: unit direction towards the light.
+} PreparedLight;
+
+// Material as read by the shading code
+typedef struct PreparedMaterial {
+    Color color;
+    float reflectivity;
+    const SpecularTable* specular; // Response for the material's exponent; NULL for matte materials
+} PreparedMaterial;
+
+// Render-ready snapshot of a scene consumed by the trace kernels.
+// Objects and the BVH are referenced, not copied; lights and materials are baked into private arrays.
+// All ambient lights are folded into one intensity, so the kernels only loop over lights that cast shadows.
+typedef struct PreparedScene {
+    const ObjectList* objects;   // In BVH leaf order; the SoA mirror holds the squared radii
+    const Bvh* bvh;              // Every leaf holds objects of a single type
+    int plane_first;             // Planes occupy objects [plane_first, plane_first + plane_count), after the BVH's objects
+    int plane_count;
+    const MeshList* meshes;      // Geometry of the mesh objects, indexed by their instanceData.geometry
+    const SphereSetList* sphere_sets; // Geometry of the sphere set objects, indexed the same way
+    const TransformList* transforms;  // Indexed by instanceData.transform
+    PreparedLight* lights;
+    int light_count;
+    int light_capacity;
+    PreparedMaterial* materials; // Indexed by Object.material, or by the sphere's material for OBJECT_MATERIAL_INHERIT
+    int material_count;
+    int material_capacity;
+    SpecularTable* specular_tables; // One per distinct specular exponent, shared by the materials using it
+    int specular_table_count;
+    int specular_table_capacity;
+    float ambient_intensity;     // Sum of all ambient lights
+    Color background_color;
+    const struct Kernels* kernels; // SIMD kernels to trace with, set by the renderer before every frame
+    const struct Scene* source;  // Scene the snapshot was taken from
+    unsigned long generation;    // scene_generation(source) at the time of the snapshot
+    unsigned long content_generation; // The same without object moves, which need no new snapshot
+} PreparedScene;
+
 typedef struct Scene {
     ObjectList* objects;
     LightList* lights;
+    MaterialList* materials; // Referenced by index from every object
+    MeshList* meshes;      // Triangle meshes referenced by index from mesh objects, shared between them
+    SphereSetList* sphere_sets; // Sphere sets referenced by index from sphere set objects, shared between them
+    TransformList* transforms;  // Rotations and scales referenced by index from instances, shared between them
     Color background_color;
+    Bvh bvh;               // Hierarchy over objects; leaves index objects->objects directly
+    int* object_slots;     // Current index of every object id, kept across BVH reorders (NULL while ids equal indices)
+    int object_slot_count;
+    int plane_count;       // Planes placed right after the BVH's objects by the last build
+    unsigned int generation; // Incremented on scene-level changes (background, acceleration rebuilds)
+    SceneCamera camera;    // Initial viewpoint requested by the scene description
+    void* mapping;         // Mapped binary scene file the lists and BVH point into (NULL if none)
+    size_t mapping_size;
 } Scene;
 
+// Allocates empty object, light, material, mesh, sphere set and transform lists and sets the default background;
+// no BVH is built
+int scene_init_empty(Scene* scene);
+// Initializes the built-in demo scene
 int scene_init(Scene* scene);
+// Builds the BVH over all bounded objects. Reorders scene->objects so every leaf covers a contiguous
+// range of a single object type, followed by all planes. Must be called again after objects are added or moved.
+int scene_build_acceleration(Scene* scene);
+// Objects are identified by the order in which they were added (their id), which BVH builds do not change.
+// Returns the current index in scene->objects of an object id, or -1 if there is no such object.
+int scene_object_index(const Scene* scene, int id);
+// Moves an object in place and marks its BVH leaf for the next scene_update_acceleration.
+// Returns 0 on success, -1 on failure.
+int scene_move_object(Scene* scene, int id, Vector3 position);
+// Brings the BVH up to date after objects were moved: refits the marked leaves and their ancestors,
+// and rebuilds the tree once its nodes have grown by BVH_REBUILD_INFLATION on average (or when objects were added). Returns 0 after a refit, 1 after a rebuild and -1 on failure.
+int scene_update_acceleration(Scene* scene);
+// Records a change to scene-level state such as the background color
+void scene_mark_changed(Scene* scene);
+// Combined change counter of the scene, its objects, its lights, its materials and its shared geometry.
+// Any modification made through the list and scene APIs yields a different value.
+unsigned long scene_generation(const Scene* scene);
 void scene_clean_up(Scene* scene);
+
+// Initializes an empty snapshot
+void scene_prepared_init(PreparedScene* prepared);
+// Takes a render-ready snapshot of a scene whose BVH is up to date, reusing the snapshot's storage.
+// Fails when an object references a material, geometry or transform the scene does not have.
+// Does nothing when the snapshot already reflects this scene at its current generation, and
+// only records the generation when objects were merely moved (see scene_move_object).
+// Returns 0 on success, -1 on failure.
+int scene_prepare(const Scene* scene, PreparedScene* prepared);
+// Releases the storage of a snapshot
+void scene_prepared_free(PreparedScene* prepared);
 #endif
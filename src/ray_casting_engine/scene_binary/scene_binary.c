@@ -0,0 +1,343 @@
+#include "./scene_binary.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Rounds an offset up to the section alignment
+static uint64_t scene_binary_align(uint64_t offset) {
+    return (offset + SCENE_BINARY_ALIGNMENT - 1) & ~(uint64_t)(SCENE_BINARY_ALIGNMENT - 1);
+}
+
+// Checks that a section is aligned and lies inside the file
+static int scene_binary_check_section(const char* path, const char* name, uint64_t offset,
+                                      uint64_t count, uint64_t element_size, uint64_t file_size) {
+    if (count == 0) {
+        return 0;
+    }
+    if (offset % SCENE_BINARY_ALIGNMENT != 0 || offset < sizeof(SceneBinaryHeader) || offset > file_size ||
+        count > (file_size - offset) / element_size) {
+        fprintf(stderr, "%s: error: %s section is misaligned or runs past the end of the file.\n", path, name);
+        return -1;
+    }
+    return 0;
+}
+
+// Rejects files written by another version, byte order or struct layout, and truncated files
+static int scene_binary_validate(const SceneBinaryHeader* header, uint64_t file_size, const char* path) {
+    if (memcmp(header->magic, SCENE_BINARY_MAGIC, sizeof(header->magic)) != 0) {
+        fprintf(stderr, "%s: error: not a binary scene file.\n", path);
+        return -1;
+    }
+    if (header->endian_tag != SCENE_BINARY_ENDIAN_TAG) {
+        fprintf(stderr, "%s: error: binary scene was written on a machine with a different byte order.\n", path);
+        return -1;
+    }
+    if (header->version != SCENE_BINARY_VERSION) {
+        fprintf(stderr, "%s: error: binary scene version %u is not supported (expected %d); convert it again.\n",
+                path, header->version, SCENE_BINARY_VERSION);
+        return -1;
+    }
+    if (header->object_size != sizeof(Object) || header->light_size != sizeof(Light) ||
+        header->node_size != sizeof(BvhNode) || header->material_size != sizeof(Material)) {
+        fprintf(stderr, "%s: error: binary scene was written by an incompatible build "
+                "(Object/Light/BvhNode/Material sizes %u/%u/%u/%u, expected %zu/%zu/%zu/%zu); convert it again.\n",
+                path, header->object_size, header->light_size, header->node_size, header->material_size,
+                sizeof(Object), sizeof(Light), sizeof(BvhNode), sizeof(Material));
+        return -1;
+    }
+    if (header->file_size != file_size) {
+        fprintf(stderr, "%s: error: binary scene is %llu bytes but its header records %llu.\n",
+                path, (unsigned long long)file_size, (unsigned long long)header->file_size);
+        return -1;
+    }
+    if (header->object_count < 0 || header->light_count < 0 || header->node_count < 0 || header->material_count < 0 ||
+        header->plane_count < 0 || header->plane_count > header->object_count ||
+        (header->object_count > header->plane_count && header->node_count == 0) ||
+        header->node_count > 2 * (header->object_count - header->plane_count)) {
+        fprintf(stderr, "%s: error: binary scene has invalid object, light, node or material counts.\n", path);
+        return -1;
+    }
+
+    const uint64_t objects = (uint64_t)header->object_count;
+    if (scene_binary_check_section(path, "object", header->objects_offset, objects, sizeof(Object), file_size) != 0 ||
+        scene_binary_check_section(path, "center_x", header->center_x_offset, objects, sizeof(float), file_size) != 0 ||
+        scene_binary_check_section(path, "center_y", header->center_y_offset, objects, sizeof(float), file_size) != 0 ||
+        scene_binary_check_section(path, "center_z", header->center_z_offset, objects, sizeof(float), file_size) != 0 ||
+        scene_binary_check_section(path, "radius_sq", header->radius_sq_offset, objects, sizeof(float), file_size) != 0 ||
+        scene_binary_check_section(path, "light", header->lights_offset, (uint64_t)header->light_count, sizeof(Light), file_size) != 0 ||
+        scene_binary_check_section(path, "BVH node", header->nodes_offset, (uint64_t)header->node_count, sizeof(BvhNode), file_size) != 0 ||
+        scene_binary_check_section(path, "material", header->materials_offset, (uint64_t)header->material_count, sizeof(Material), file_size) != 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+// Rejects indices the renderer follows without checks: BVH children and leaf ranges, and object types.
+// Children must come after their parent (as bvh_build lays them out), so the tree has no cycles, and no deeper
+// than BVH_MAX_DEPTH so traversal stacks cannot overflow.
+static int scene_binary_validate_contents(const SceneBinaryHeader* header, const char* base, const char* path) {
+    const Object* objects = (const Object*)(base + header->objects_offset);
+    const int bvh_count = header->object_count - header->plane_count;
+
+    for (int i = 0; i < header->object_count; ++i) {
+        const ObjectType type = objects[i].type;
+        const int is_plane = type == OBJECT_TYPE_PLANE;
+        if ((i < bvh_count) ? (type != OBJECT_TYPE_SPHERE && type != OBJECT_TYPE_CUBE && type != OBJECT_TYPE_CUBOID) : !is_plane) {
+            fprintf(stderr, "%s: error: object %d has type %d, which is not a %s.\n",
+                    path, i, (int)type, (i < bvh_count) ? "sphere or box" : "plane");
+            return -1;
+        }
+    }
+
+    if (header->node_count == 0) {
+        return 0;
+    }
+
+    unsigned char* depths = (unsigned char*)calloc((size_t)header->node_count, sizeof(unsigned char));
+    if (depths == NULL) {
+        fprintf(stderr, "%s: error: could not allocate memory to check the BVH.\n", path);
+        return -1;
+    }
+
+    const BvhNode* nodes = (const BvhNode*)(base + header->nodes_offset);
+    int status = 0;
+    for (int i = 0; i < header->node_count && status == 0; ++i) {
+        const BvhNode* node = &nodes[i];
+        if (node->primitive_count == 0) {
+            if (node->left_first <= i || node->left_first >= header->node_count - 1) {
+                fprintf(stderr, "%s: error: BVH node %d points to children %d and %d, which must follow it among the %d nodes.\n",
+                        path, i, node->left_first, node->left_first + 1, header->node_count);
+                status = -1;
+            } else if (depths[i] + 1 >= BVH_MAX_DEPTH) {
+                fprintf(stderr, "%s: error: BVH is deeper than %d levels.\n", path, BVH_MAX_DEPTH);
+                status = -1;
+            } else {
+                // Parents come first, so a node's depth is final (the deepest over shared parents) when it is reached
+                for (int child = node->left_first; child <= node->left_first + 1; ++child) {
+                    if (depths[child] < depths[i] + 1) {
+                        depths[child] = (unsigned char)(depths[i] + 1);
+                    }
+                }
+            }
+        } else if (node->primitive_count < 0 || node->left_first < 0 || node->left_first > bvh_count - node->primitive_count) {
+            fprintf(stderr, "%s: error: BVH leaf %d covers objects %d to %d, outside the %d non-plane objects.\n",
+                    path, i, node->left_first, node->left_first + node->primitive_count - 1, bvh_count);
+            status = -1;
+        }
+    }
+
+    free(depths);
+    return status;
+}
+
+int scene_binary_detect(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    char magic[8];
+    int is_binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                    memcmp(magic, SCENE_BINARY_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return is_binary;
+}
+
+int scene_binary_load(Scene* scene, const char* path) {
+    if (scene == NULL || path == NULL) {
+        fprintf(stderr, "Error: scene_binary_load received a NULL pointer.\n");
+        return -1;
+    }
+
+    Uint64 load_start = SDL_GetPerformanceCounter();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (uint64_t)info.st_size < sizeof(SceneBinaryHeader)) {
+        fprintf(stderr, "%s: error: file is too small to be a binary scene.\n", path);
+        close(fd);
+        return -1;
+    }
+
+    // Private and writable: copy-on-write keeps in-memory edits (e.g. objectList_sync) away from the file
+    const size_t size = (size_t)info.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+
+    const SceneBinaryHeader* header = (const SceneBinaryHeader*)mapping;
+    if (scene_binary_validate(header, (uint64_t)size, path) != 0 ||
+        scene_binary_validate_contents(header, (const char*)mapping, path) != 0) {
+        munmap(mapping, size);
+        return -1;
+    }
+
+    if (scene_init_empty(scene) != 0) {
+        munmap(mapping, size);
+        scene_clean_up(scene);
+        return -1;
+    }
+    scene->mapping = mapping;
+    scene->mapping_size = size;
+
+    char* base = (char*)mapping;
+    SphereSoA spheres = {
+        (float*)(base + header->center_x_offset),
+        (float*)(base + header->center_y_offset),
+        (float*)(base + header->center_z_offset),
+        (float*)(base + header->radius_sq_offset)
+    };
+    Object* objects = header->object_count > 0 ? (Object*)(base + header->objects_offset) : NULL;
+    Light* lights = header->light_count > 0 ? (Light*)(base + header->lights_offset) : NULL;
+    BvhNode* nodes = header->node_count > 0 ? (BvhNode*)(base + header->nodes_offset) : NULL;
+    Material* materials = header->material_count > 0 ? (Material*)(base + header->materials_offset) : NULL;
+
+    if ((header->object_count > 0 && objectList_attach(scene->objects, objects, spheres, header->object_count) != 0) ||
+        (header->light_count > 0 && lightList_attach(scene->lights, lights, (size_t)header->light_count) != 0) ||
+        (header->node_count > 0 && bvh_attach(&scene->bvh, nodes, header->node_count, header->object_count - header->plane_count) != 0) ||
+        (header->material_count > 0 && materialList_attach(scene->materials, materials, (size_t)header->material_count) != 0)) {
+        scene_clean_up(scene);
+        return -1;
+    }
+
+    scene->plane_count = header->plane_count;
+    scene->background_color.r = header->background[0];
+    scene->background_color.g = header->background[1];
+    scene->background_color.b = header->background[2];
+    scene->camera.is_set = header->camera_is_set;
+    scene->camera.position = vector3_new(header->camera_position[0], header->camera_position[1], header->camera_position[2]);
+    scene->camera.yaw = header->camera_yaw;
+    scene->camera.pitch = header->camera_pitch;
+
+    double load_ms = (double)(SDL_GetPerformanceCounter() - load_start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    printf("Mapped %d objects, %zu lights, %zu materials and %d BVH nodes from %s in %.2f ms.\n",
+           scene->objects->count, scene->lights->count, scene->materials->count, scene->bvh.node_count, path, load_ms);
+
+    return 0;
+}
+
+// Writes one section at its offset, zero-filling the gap after the previous one
+static int scene_binary_write_section(FILE* file, uint64_t* position, uint64_t offset, const void* data, size_t bytes) {
+    static const char padding[SCENE_BINARY_ALIGNMENT] = { 0 };
+
+    while (*position < offset) {
+        size_t gap = (size_t)(offset - *position);
+        size_t chunk = gap < sizeof(padding) ? gap : sizeof(padding);
+        if (fwrite(padding, 1, chunk, file) != chunk) {
+            return -1;
+        }
+        *position += chunk;
+    }
+
+    if (bytes > 0 && fwrite(data, 1, bytes, file) != bytes) {
+        return -1;
+    }
+    *position += bytes;
+    return 0;
+}
+
+int scene_binary_write(const Scene* scene, const char* path) {
+    if (scene == NULL || scene->objects == NULL || scene->lights == NULL || scene->materials == NULL || path == NULL) {
+        fprintf(stderr, "Error: scene_binary_write received a NULL pointer.\n");
+        return -1;
+    }
+
+    const ObjectList* objects = scene->objects;
+    const size_t object_count = (size_t)objects->count;
+    const size_t light_count = scene->lights->count;
+    const size_t node_count = (size_t)scene->bvh.node_count;
+    const size_t material_count = scene->materials->count;
+
+    if (scene->bvh.primitive_count + scene->plane_count != objects->count ||
+        (scene->bvh.primitive_count > 0 && node_count == 0)) {
+        fprintf(stderr, "Error: scene_binary_write needs a BVH built over the current objects.\n");
+        return -1;
+    }
+    // Meshes and sphere sets own variable-size buffers and a hierarchy each, which the fixed sections cannot hold
+    if ((scene->meshes != NULL && scene->meshes->count > 0) || (scene->sphere_sets != NULL && scene->sphere_sets->count > 0) ||
+        (scene->transforms != NULL && scene->transforms->count > 0)) {
+        fprintf(stderr, "Error: scene_binary_write cannot store meshes or instances; keep such scenes as text files.\n");
+        return -1;
+    }
+
+    SceneBinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SCENE_BINARY_MAGIC, sizeof(header.magic));
+    header.version = SCENE_BINARY_VERSION;
+    header.endian_tag = SCENE_BINARY_ENDIAN_TAG;
+    header.object_size = sizeof(Object);
+    header.light_size = sizeof(Light);
+    header.node_size = sizeof(BvhNode);
+    header.material_size = sizeof(Material);
+    header.object_count = (int32_t)object_count;
+    header.plane_count = (int32_t)scene->plane_count;
+    header.light_count = (int32_t)light_count;
+    header.node_count = (int32_t)node_count;
+    header.material_count = (int32_t)material_count;
+    header.background[0] = scene->background_color.r;
+    header.background[1] = scene->background_color.g;
+    header.background[2] = scene->background_color.b;
+    header.camera_is_set = scene->camera.is_set;
+    header.camera_position[0] = scene->camera.position.x;
+    header.camera_position[1] = scene->camera.position.y;
+    header.camera_position[2] = scene->camera.position.z;
+    header.camera_yaw = scene->camera.yaw;
+    header.camera_pitch = scene->camera.pitch;
+
+    uint64_t offset = scene_binary_align(sizeof(header));
+    header.objects_offset = offset;
+    offset = scene_binary_align(offset + object_count * sizeof(Object));
+    header.center_x_offset = offset;
+    offset = scene_binary_align(offset + object_count * sizeof(float));
+    header.center_y_offset = offset;
+    offset = scene_binary_align(offset + object_count * sizeof(float));
+    header.center_z_offset = offset;
+    offset = scene_binary_align(offset + object_count * sizeof(float));
+    header.radius_sq_offset = offset;
+    offset = scene_binary_align(offset + object_count * sizeof(float));
+    header.lights_offset = offset;
+    offset = scene_binary_align(offset + light_count * sizeof(Light));
+    header.nodes_offset = offset;
+    offset = scene_binary_align(offset + node_count * sizeof(BvhNode));
+    header.materials_offset = offset;
+    header.file_size = offset + material_count * sizeof(Material);
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    uint64_t position = 0;
+    int status = scene_binary_write_section(file, &position, 0, &header, sizeof(header));
+    if (status == 0) status = scene_binary_write_section(file, &position, header.objects_offset, objects->objects, object_count * sizeof(Object));
+    if (status == 0) status = scene_binary_write_section(file, &position, header.center_x_offset, objects->spheres.center_x, object_count * sizeof(float));
+    if (status == 0) status = scene_binary_write_section(file, &position, header.center_y_offset, objects->spheres.center_y, object_count * sizeof(float));
+    if (status == 0) status = scene_binary_write_section(file, &position, header.center_z_offset, objects->spheres.center_z, object_count * sizeof(float));
+    if (status == 0) status = scene_binary_write_section(file, &position, header.radius_sq_offset, objects->spheres.radius_sq, object_count * sizeof(float));
+    if (status == 0) status = scene_binary_write_section(file, &position, header.lights_offset, scene->lights->lights, light_count * sizeof(Light));
+    if (status == 0) status = scene_binary_write_section(file, &position, header.nodes_offset, scene->bvh.nodes, node_count * sizeof(BvhNode));
+    if (status == 0) status = scene_binary_write_section(file, &position, header.materials_offset, scene->materials->materials, material_count * sizeof(Material));
+
+    if (fclose(file) != 0) {
+        status = -1;
+    }
+    if (status != 0) {
+        fprintf(stderr, "%s: error: failed to write the binary scene.\n", path);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../scene/scene.h"
+
+#ifndef _SCENE_BINARY_H_
+#define _SCENE_BINARY_H_
+
+#define SCENE_BINARY_MAGIC "RCSCENE"   // Eight bytes including the terminator
+#define SCENE_BINARY_VERSION 3         // Bumped whenever the layout of the file or of a stored struct changes
+#define SCENE_BINARY_ENDIAN_TAG 0x01020304u
+#define SCENE_BINARY_ALIGNMENT 64      // Every section starts on a cache line
+
+// Fixed-size header at offset 0. Sections are raw in-memory arrays of the engine's own structs,
+// so the file is only valid for builds with the same struct sizes and byte order; the loader
+// checks both and rejects anything else.
+typedef struct SceneBinaryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_tag;
+    uint32_t object_size;        // sizeof(Object)
+    uint32_t light_size;         // sizeof(Light)
+    uint32_t node_size;          // sizeof(BvhNode)
+    uint32_t material_size;      // sizeof(Material)
+    uint64_t file_size;
+
+    int32_t object_count;
+    int32_t light_count;
+    int32_t node_count;
+    int32_t material_count;
+    int32_t camera_is_set;
+    float background[3];
+    float camera_position[3];
+    float camera_yaw;            // Radians, Camera convention
+    float camera_pitch;
+    int32_t plane_count;         // Planes stored after the objects the BVH covers
+
+    // Byte offsets of the sections, in the order they are written
+    uint64_t objects_offset;     // Object[object_count], in BVH leaf order followed by the planes
+    uint64_t center_x_offset;    // float[object_count], SphereSoA mirror of objects
+    uint64_t center_y_offset;
+    uint64_t center_z_offset;
+    uint64_t radius_sq_offset;
+    uint64_t lights_offset;      // Light[light_count]
+    uint64_t nodes_offset;       // BvhNode[node_count]
+    uint64_t materials_offset;   // Material[material_count], indexed by Object.material
+} SceneBinaryHeader;
+
+// Returns 1 when the file starts with the binary scene magic, 0 otherwise (including unreadable files)
+int scene_binary_detect(const char* path);
+
+// Maps a binary scene file and points the scene's lists and BVH straight into the mapping.
+// Nothing is parsed or copied, but one linear pass reads every BVH node and object to check them;
+// object material indices are checked later by scene_prepare. The mapping is private: edits made through the
+// list APIs never reach the file. Returns 0 on success, -1 on failure.
+int scene_binary_load(Scene* scene, const char* path);
+
+// Writes a scene with an up-to-date BVH (see scene_build_acceleration) and no meshes or instances. Returns 0 on success, -1 on failure.
+int scene_binary_write(const Scene* scene, const char* path);
+
+#endif
@@ -0,0 +1,34 @@
+// Converts a text scene description (see scene_file.h) into the memory-mapped
+// binary format (see scene_binary.h). The BVH is built once here and stored in
+// the output, so loading the binary file needs neither parsing nor a rebuild.
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+#include "../scene/scene.h"
+#include "../scene_file/scene_file.h"
+#include "../scene_binary/scene_binary.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <input.scene> <output.bscene>\n", argv[0]);
+        return 1;
+    }
+
+    Scene scene;
+    if (scene_file_load(&scene, argv[1]) != 0) {
+        return 1;
+    }
+
+    Uint64 write_start = SDL_GetPerformanceCounter();
+    int status = scene_binary_write(&scene, argv[2]);
+    double write_ms = (double)(SDL_GetPerformanceCounter() - write_start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    if (status == 0) {
+        printf("Wrote %s (%d objects, %zu lights, %d BVH nodes) in %.1f ms.\n",
+               argv[2], scene.objects->count, scene.lights->count, scene.bvh.node_count, write_ms);
+    }
+
+    scene_clean_up(&scene);
+    return status == 0 ? 0 : 1;
+}
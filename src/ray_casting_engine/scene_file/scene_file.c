@@ -0,0 +1,962 @@
+#include "./scene_file.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../camera/camera.h"
+
+#define SCENE_FILE_DEGREES_TO_RADIANS ((float)M_PI / 180.0f)
+
+// Name of a material declared by the file and its index in the scene's material table
+typedef struct SceneFileMaterial {
+    char name[SCENE_FILE_MAX_NAME];
+    int index;
+} SceneFileMaterial;
+
+// Name of a sphere group declared by the file and its index in the scene's sphere set list
+typedef struct SceneFileGroup {
+    char name[SCENE_FILE_MAX_NAME];
+    int index;
+} SceneFileGroup;
+
+// State of one load: the stream position, the current line split into tokens and the material and group tables
+typedef struct SceneFileParser {
+    const char* path;
+    FILE* file;
+    int line_number;
+    char line[SCENE_FILE_MAX_LINE];
+    char* tokens[SCENE_FILE_MAX_TOKENS];
+    int token_count;
+
+    SceneFileMaterial* materials;
+    int material_count;
+    int material_capacity;
+    int* material_slots;     // Open-addressing hash of material names: index into materials, or -1
+    int material_slot_count; // Power of two, at least twice material_capacity
+
+    Material last_inline;    // Surface of the previous inline sphere, reused while it repeats
+    int last_inline_index;   // -1 until the first inline sphere
+
+    SceneFileGroup* groups;
+    int group_count;
+    int group_capacity;
+    const char* open_group;  // open_group_name while a group is being read, NULL outside groups
+    char open_group_name[SCENE_FILE_MAX_NAME];
+    int open_group_line;
+    Vector3* group_centers;  // Spheres of the open group
+    float* group_radii;
+    int* group_materials;
+    int group_sphere_count;
+    int group_sphere_capacity;
+
+    Transform last_transform; // Rotation and scale of the previous transformed instance, reused while it repeats
+    int last_transform_index; // -1 until the first transformed instance
+
+    long declared_objects;   // -1 while no count is known
+    long declared_lights;
+} SceneFileParser;
+
+// Reports an error at the current line
+static int scene_file_error(const SceneFileParser* parser, const char* message, const char* detail) {
+    if (detail != NULL) {
+        fprintf(stderr, "%s:%d: error: %s '%s'.\n", parser->path, parser->line_number, message, detail);
+    } else {
+        fprintf(stderr, "%s:%d: error: %s.\n", parser->path, parser->line_number, message);
+    }
+    return -1;
+}
+
+// Reads the next non-empty line and splits it into tokens in place.
+// Returns 1 when a line was read, 0 at end of file, -1 on errors.
+static int scene_file_next_line(SceneFileParser* parser) {
+    while (fgets(parser->line, sizeof(parser->line), parser->file) != NULL) {
+        parser->line_number++;
+
+        size_t length = strlen(parser->line);
+        if (length == sizeof(parser->line) - 1 && parser->line[length - 1] != '\n' && !feof(parser->file)) {
+            return scene_file_error(parser, "line is too long", NULL);
+        }
+
+        char* comment = strchr(parser->line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+
+        parser->token_count = 0;
+        char* cursor = parser->line;
+        while (*cursor != '\0') {
+            while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n') {
+                *cursor++ = '\0';
+            }
+            if (*cursor == '\0') {
+                break;
+            }
+            if (parser->token_count == SCENE_FILE_MAX_TOKENS) {
+                return scene_file_error(parser, "too many fields on one line", NULL);
+            }
+            parser->tokens[parser->token_count++] = cursor;
+            while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t' && *cursor != '\r' && *cursor != '\n') {
+                cursor++;
+            }
+        }
+
+        if (parser->token_count > 0) {
+            return 1;
+        }
+    }
+
+    if (ferror(parser->file)) {
+        fprintf(stderr, "%s: error: failed to read the file.\n", parser->path);
+        return -1;
+    }
+    return 0;
+}
+
+// Checks that a directive has exactly one of the accepted field counts (second may be 0 for none)
+static int scene_file_expect_fields(const SceneFileParser* parser, int count, int alternative) {
+    if (parser->token_count == count || (alternative > 0 && parser->token_count == alternative)) {
+        return 0;
+    }
+    return scene_file_error(parser, "wrong number of fields for", parser->tokens[0]);
+}
+
+static int scene_file_parse_float(const SceneFileParser* parser, int index, float* out) {
+    const char* token = parser->tokens[index];
+    char* end = NULL;
+    float value = strtof(token, &end);
+
+    if (end == token || *end != '\0' || !isfinite(value)) {
+        return scene_file_error(parser, "expected a number, got", token);
+    }
+
+    *out = value;
+    return 0;
+}
+
+static int scene_file_parse_long(const SceneFileParser* parser, int index, long min, long max, long* out) {
+    const char* token = parser->tokens[index];
+    char* end = NULL;
+    long value = strtol(token, &end, 10);
+
+    if (end == token || *end != '\0') {
+        return scene_file_error(parser, "expected an integer, got", token);
+    }
+    if (value < min || value > max) {
+        return scene_file_error(parser, "value out of range", token);
+    }
+
+    *out = value;
+    return 0;
+}
+
+static int scene_file_parse_vector(const SceneFileParser* parser, int index, Vector3* out) {
+    if (scene_file_parse_float(parser, index, &out->x) != 0 ||
+        scene_file_parse_float(parser, index + 1, &out->y) != 0 ||
+        scene_file_parse_float(parser, index + 2, &out->z) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static int scene_file_parse_color(const SceneFileParser* parser, int index, Color* out) {
+    long r, g, b;
+    if (scene_file_parse_long(parser, index, 0, 255, &r) != 0 ||
+        scene_file_parse_long(parser, index + 1, 0, 255, &g) != 0 ||
+        scene_file_parse_long(parser, index + 2, 0, 255, &b) != 0) {
+        return -1;
+    }
+    *out = color_new((unsigned char)r, (unsigned char)g, (unsigned char)b);
+    return 0;
+}
+
+// Parses "<r> <g> <b> <specular> <reflectivity>" starting at index
+static int scene_file_parse_surface(const SceneFileParser* parser, int index, Material* out) {
+    long specularity;
+    if (scene_file_parse_color(parser, index, &out->color) != 0 ||
+        scene_file_parse_long(parser, index + 3, -1, 1000000, &specularity) != 0 ||
+        scene_file_parse_float(parser, index + 4, &out->reflectivity) != 0) {
+        return -1;
+    }
+    if (out->reflectivity < 0.0f || out->reflectivity > 1.0f) {
+        return scene_file_error(parser, "reflectivity must be within [0, 1], got", parser->tokens[index + 4]);
+    }
+    out->specularity = (int)specularity;
+    return 0;
+}
+
+// FNV-1a
+static unsigned int scene_file_hash_name(const char* name) {
+    unsigned int hash = 2166136261u;
+    for (; *name != '\0'; ++name) {
+        hash = (hash ^ (unsigned char)*name) * 16777619u;
+    }
+    return hash;
+}
+
+// Slot holding name, or the empty slot where it would be inserted
+static int* scene_file_material_slot(const SceneFileParser* parser, const char* name) {
+    const unsigned int mask = (unsigned int)parser->material_slot_count - 1;
+    unsigned int slot = scene_file_hash_name(name) & mask;
+    while (parser->material_slots[slot] >= 0 && strcmp(parser->materials[parser->material_slots[slot]].name, name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return &parser->material_slots[slot];
+}
+
+static const SceneFileMaterial* scene_file_find_material(const SceneFileParser* parser, const char* name) {
+    if (parser->material_count == 0) {
+        return NULL;
+    }
+    const int index = *scene_file_material_slot(parser, name);
+    return index >= 0 ? &parser->materials[index] : NULL;
+}
+
+// Doubles the name table and rehashes every name
+static int scene_file_grow_materials(SceneFileParser* parser) {
+    const int new_capacity = (parser->material_capacity == 0) ? 8 : parser->material_capacity * 2;
+    SceneFileMaterial* resized = (SceneFileMaterial*)realloc(parser->materials, (size_t)new_capacity * sizeof(SceneFileMaterial));
+    int* slots = (int*)malloc((size_t)new_capacity * 2 * sizeof(int));
+    if (resized != NULL) {
+        parser->materials = resized;
+    }
+    if (resized == NULL || slots == NULL) {
+        free(slots);
+        return -1;
+    }
+
+    free(parser->material_slots);
+    parser->material_slots = slots;
+    parser->material_slot_count = new_capacity * 2;
+    parser->material_capacity = new_capacity;
+    for (int i = 0; i < parser->material_slot_count; ++i) {
+        parser->material_slots[i] = -1;
+    }
+    for (int i = 0; i < parser->material_count; ++i) {
+        *scene_file_material_slot(parser, parser->materials[i].name) = i;
+    }
+    return 0;
+}
+
+static int scene_file_parse_material(SceneFileParser* parser, Scene* scene) {
+    if (scene_file_expect_fields(parser, 7, 0) != 0) {
+        return -1;
+    }
+
+    const char* name = parser->tokens[1];
+    if (strlen(name) >= SCENE_FILE_MAX_NAME) {
+        return scene_file_error(parser, "material name is too long", name);
+    }
+    if (scene_file_find_material(parser, name) != NULL) {
+        return scene_file_error(parser, "duplicate material", name);
+    }
+
+    Material material;
+    if (scene_file_parse_surface(parser, 2, &material) != 0) {
+        return -1;
+    }
+
+    if (parser->material_count == parser->material_capacity && scene_file_grow_materials(parser) != 0) {
+        return scene_file_error(parser, "out of memory for materials", NULL);
+    }
+
+    SceneFileMaterial* named = &parser->materials[parser->material_count];
+    strcpy(named->name, name);
+    named->index = materialList_add(scene->materials, material);
+    if (named->index < 0) {
+        return scene_file_error(parser, "out of memory for materials", NULL);
+    }
+    *scene_file_material_slot(parser, name) = parser->material_count++;
+
+    return 0;
+}
+
+// Whether a directive adds an object
+static int scene_file_is_object(const char* directive) {
+    return strcmp(directive, "sphere") == 0 || strcmp(directive, "cube") == 0 || strcmp(directive, "cuboid") == 0 ||
+           strcmp(directive, "plane") == 0 || strcmp(directive, "mesh") == 0 || strcmp(directive, "instance") == 0;
+}
+
+// Reads the material of an object line from its last fields: a material name, or an inline surface
+static int scene_file_parse_object_material(SceneFileParser* parser, Scene* scene, int index, int* material) {
+    if (parser->token_count == index + 1) {
+        const SceneFileMaterial* named = scene_file_find_material(parser, parser->tokens[index]);
+        if (named == NULL) {
+            return scene_file_error(parser, "unknown material", parser->tokens[index]);
+        }
+        *material = named->index;
+        return 0;
+    }
+
+    // Inline surfaces become anonymous materials; runs of identical ones share a single entry
+    Material surface;
+    if (scene_file_parse_surface(parser, index, &surface) != 0) {
+        return -1;
+    }
+    if (parser->last_inline_index < 0 || memcmp(&surface, &parser->last_inline, sizeof(surface)) != 0) {
+        parser->last_inline_index = materialList_add(scene->materials, surface);
+        parser->last_inline = surface;
+        if (parser->last_inline_index < 0) {
+            return scene_file_error(parser, "out of memory for materials", NULL);
+        }
+    }
+    *material = parser->last_inline_index;
+    return 0;
+}
+
+// Appends a sphere to the open group
+static int scene_file_add_group_sphere(SceneFileParser* parser, Vector3 center, float radius, int material) {
+    if (parser->group_sphere_count == parser->group_sphere_capacity) {
+        const int new_capacity = (parser->group_sphere_capacity == 0) ? 64 : parser->group_sphere_capacity * 2;
+        Vector3* centers = (Vector3*)realloc(parser->group_centers, (size_t)new_capacity * sizeof(Vector3));
+        if (centers != NULL) {
+            parser->group_centers = centers;
+        }
+        float* radii = (float*)realloc(parser->group_radii, (size_t)new_capacity * sizeof(float));
+        if (radii != NULL) {
+            parser->group_radii = radii;
+        }
+        int* materials = (int*)realloc(parser->group_materials, (size_t)new_capacity * sizeof(int));
+        if (materials != NULL) {
+            parser->group_materials = materials;
+        }
+        if (centers == NULL || radii == NULL || materials == NULL) {
+            return scene_file_error(parser, "out of memory for group", parser->open_group_name);
+        }
+        parser->group_sphere_capacity = new_capacity;
+    }
+
+    parser->group_centers[parser->group_sphere_count] = center;
+    parser->group_radii[parser->group_sphere_count] = radius;
+    parser->group_materials[parser->group_sphere_count] = material;
+    parser->group_sphere_count++;
+    return 0;
+}
+
+// Parses a sphere, cube, cuboid or plane line: its position and shape fields followed by a material.
+// Inside a group, only spheres are accepted and they go into the group instead of the object list.
+static int scene_file_parse_object(SceneFileParser* parser, Scene* scene) {
+    const char* directive = parser->tokens[0];
+    const int shape_fields = (strcmp(directive, "cuboid") == 0 || strcmp(directive, "plane") == 0) ? 6 : 4;
+    if (parser->open_group != NULL && strcmp(directive, "sphere") != 0) {
+        return scene_file_error(parser, "groups can only hold spheres, got", directive);
+    }
+    if (scene_file_expect_fields(parser, shape_fields + 2, shape_fields + 6) != 0) {
+        return -1;
+    }
+    if (parser->open_group == NULL && parser->declared_objects >= 0 && scene->objects->count >= parser->declared_objects) {
+        return scene_file_error(parser, "more objects than declared by 'objects'", NULL);
+    }
+
+    Vector3 position;
+    Vector3 shape;
+    if (scene_file_parse_vector(parser, 1, &position) != 0) {
+        return -1;
+    }
+    if (shape_fields == 6) {
+        if (scene_file_parse_vector(parser, 4, &shape) != 0) {
+            return -1;
+        }
+    } else {
+        if (scene_file_parse_float(parser, 4, &shape.x) != 0) {
+            return -1;
+        }
+        shape.y = shape.z = shape.x;
+    }
+
+    if (strcmp(directive, "plane") == 0) {
+        if (vector3_dot(shape, shape) <= 0.0f) {
+            return scene_file_error(parser, "plane normal must not be zero", NULL);
+        }
+    } else if (shape.x <= 0.0f || shape.y <= 0.0f || shape.z <= 0.0f) {
+        return scene_file_error(parser, "object size must be positive on", directive);
+    }
+
+    int material;
+    if (scene_file_parse_object_material(parser, scene, shape_fields + 1, &material) != 0) {
+        return -1;
+    }
+    if (parser->open_group != NULL) {
+        return scene_file_add_group_sphere(parser, position, shape.x, material);
+    }
+
+    Object object;
+    if (strcmp(directive, "sphere") == 0) {
+        object = object_new_sphere(position, shape.x, material);
+    } else if (strcmp(directive, "cube") == 0) {
+        object = object_new_cube(position, shape.x, material);
+    } else if (strcmp(directive, "cuboid") == 0) {
+        object = object_new_cuboid(position, shape, material);
+    } else {
+        object = object_new_plane(position, shape, material);
+    }
+    if (objectList_add(scene->objects, object) != 0) {
+        return scene_file_error(parser, "out of memory for objects", NULL);
+    }
+    return 0;
+}
+
+// Path of a file named by the scene: absolute paths are kept, relative ones are taken from the scene file's directory.
+// Returns a malloc'd string, or NULL when out of memory.
+static char* scene_file_resolve_path(const SceneFileParser* parser, const char* name) {
+    const char* slash = strrchr(parser->path, '/');
+    const size_t directory_length = (name[0] != '/' && slash != NULL) ? (size_t)(slash - parser->path) + 1 : 0;
+    const size_t name_length = strlen(name);
+
+    char* resolved = (char*)malloc(directory_length + name_length + 1);
+    if (resolved != NULL) {
+        memcpy(resolved, parser->path, directory_length);
+        memcpy(resolved + directory_length, name, name_length + 1);
+    }
+    return resolved;
+}
+
+// Index of the mesh loaded from an OBJ file named by the scene, loading it on first use.
+// Returns -1 on failure.
+static int scene_file_load_mesh(SceneFileParser* parser, Scene* scene, const char* name) {
+    char* path = scene_file_resolve_path(parser, name);
+    if (path == NULL) {
+        return scene_file_error(parser, "out of memory for meshes", NULL);
+    }
+
+    int mesh_index = meshList_find_source(scene->meshes, path);
+    if (mesh_index < 0) {
+        Mesh mesh;
+        if (mesh_load_obj(&mesh, path) != 0) {
+            free(path);
+            return scene_file_error(parser, "failed to load mesh", name);
+        }
+        mesh_index = meshList_add(scene->meshes, &mesh);
+        if (mesh_index < 0) {
+            mesh_free(&mesh);
+            free(path);
+            return scene_file_error(parser, "out of memory for meshes", NULL);
+        }
+        printf("Loaded mesh %s: %d vertices, %d triangles, %d BVH nodes.\n", path,
+               scene->meshes->meshes[mesh_index].vertex_count, scene->meshes->meshes[mesh_index].triangle_count,
+               scene->meshes->meshes[mesh_index].bvh.node_count);
+    }
+    free(path);
+    return mesh_index;
+}
+
+// Parses "mesh <x> <y> <z> <file.obj> <material>"; objects naming the same file share one loaded mesh
+static int scene_file_parse_mesh(SceneFileParser* parser, Scene* scene) {
+    if (scene_file_expect_fields(parser, 6, 10) != 0) {
+        return -1;
+    }
+    if (parser->declared_objects >= 0 && scene->objects->count >= parser->declared_objects) {
+        return scene_file_error(parser, "more objects than declared by 'objects'", NULL);
+    }
+
+    Vector3 position;
+    int material;
+    if (scene_file_parse_vector(parser, 1, &position) != 0 ||
+        scene_file_parse_object_material(parser, scene, 5, &material) != 0) {
+        return -1;
+    }
+
+    const int mesh_index = scene_file_load_mesh(parser, scene, parser->tokens[4]);
+    if (mesh_index < 0) {
+        return -1;
+    }
+    if (objectList_add(scene->objects, object_new_mesh(position, mesh_index, -1, material)) != 0) {
+        return scene_file_error(parser, "out of memory for objects", NULL);
+    }
+    return 0;
+}
+
+static const SceneFileGroup* scene_file_find_group(const SceneFileParser* parser, const char* name) {
+    for (int i = 0; i < parser->group_count; ++i) {
+        if (strcmp(parser->groups[i].name, name) == 0) {
+            return &parser->groups[i];
+        }
+    }
+    return NULL;
+}
+
+// Parses "group <name>", which starts collecting the following sphere lines into a sphere set
+static int scene_file_parse_group(SceneFileParser* parser) {
+    if (scene_file_expect_fields(parser, 2, 0) != 0) {
+        return -1;
+    }
+    if (parser->open_group != NULL) {
+        return scene_file_error(parser, "groups cannot be nested in group", parser->open_group_name);
+    }
+
+    const char* name = parser->tokens[1];
+    if (strlen(name) >= SCENE_FILE_MAX_NAME) {
+        return scene_file_error(parser, "group name is too long", name);
+    }
+    if (scene_file_find_group(parser, name) != NULL) {
+        return scene_file_error(parser, "duplicate group", name);
+    }
+
+    strcpy(parser->open_group_name, name);
+    parser->open_group = parser->open_group_name;
+    parser->open_group_line = parser->line_number;
+    parser->group_sphere_count = 0;
+    return 0;
+}
+
+// Parses "end", which builds the open group's sphere set
+static int scene_file_parse_group_end(SceneFileParser* parser, Scene* scene) {
+    if (scene_file_expect_fields(parser, 1, 0) != 0) {
+        return -1;
+    }
+    if (parser->open_group == NULL) {
+        return scene_file_error(parser, "'end' without 'group'", NULL);
+    }
+    if (parser->group_sphere_count == 0) {
+        return scene_file_error(parser, "empty group", parser->open_group_name);
+    }
+
+    if (parser->group_count == parser->group_capacity) {
+        const int new_capacity = (parser->group_capacity == 0) ? 8 : parser->group_capacity * 2;
+        SceneFileGroup* groups = (SceneFileGroup*)realloc(parser->groups, (size_t)new_capacity * sizeof(SceneFileGroup));
+        if (groups == NULL) {
+            return scene_file_error(parser, "out of memory for groups", NULL);
+        }
+        parser->groups = groups;
+        parser->group_capacity = new_capacity;
+    }
+
+    SphereSet set;
+    if (sphere_set_init(&set, parser->group_centers, parser->group_radii, parser->group_materials, parser->group_sphere_count) != 0) {
+        return scene_file_error(parser, "failed to build group", parser->open_group_name);
+    }
+    const int index = sphereSetList_add(scene->sphere_sets, &set);
+    if (index < 0) {
+        sphere_set_free(&set);
+        return scene_file_error(parser, "out of memory for groups", NULL);
+    }
+
+    SceneFileGroup* group = &parser->groups[parser->group_count++];
+    strcpy(group->name, parser->open_group_name);
+    group->index = index;
+    parser->open_group = NULL;
+    return 0;
+}
+
+// Parses "instance <x> <y> <z> <yaw> <pitch> <roll> <scale> <group|file.obj> [<material>]".
+// Without a material, the spheres of a group keep their own; mesh instances need one.
+static int scene_file_parse_instance(SceneFileParser* parser, Scene* scene) {
+    if (parser->token_count != 9 && scene_file_expect_fields(parser, 10, 14) != 0) {
+        return -1;
+    }
+    if (parser->declared_objects >= 0 && scene->objects->count >= parser->declared_objects) {
+        return scene_file_error(parser, "more objects than declared by 'objects'", NULL);
+    }
+
+    Vector3 position;
+    Vector3 degrees;
+    float scale;
+    if (scene_file_parse_vector(parser, 1, &position) != 0 ||
+        scene_file_parse_vector(parser, 4, &degrees) != 0 ||
+        scene_file_parse_float(parser, 7, &scale) != 0) {
+        return -1;
+    }
+    if (scale <= 0.0f) {
+        return scene_file_error(parser, "instance scale must be positive, got", parser->tokens[7]);
+    }
+
+    const SceneFileGroup* group = scene_file_find_group(parser, parser->tokens[8]);
+    int material = OBJECT_MATERIAL_INHERIT;
+    if (parser->token_count > 9 && scene_file_parse_object_material(parser, scene, 9, &material) != 0) {
+        return -1;
+    }
+    if (group == NULL && material == OBJECT_MATERIAL_INHERIT) {
+        return scene_file_error(parser, "mesh instances need a material", parser->tokens[8]);
+    }
+
+    // Runs of instances with the same rotation and scale share one transform
+    int transform = -1;
+    if (degrees.x != 0.0f || degrees.y != 0.0f || degrees.z != 0.0f || scale != 1.0f) {
+        const Transform* last = &parser->last_transform;
+        if (parser->last_transform_index < 0 || last->scale != scale || last->degrees.x != degrees.x ||
+            last->degrees.y != degrees.y || last->degrees.z != degrees.z) {
+            parser->last_transform = transform_new(degrees.x, degrees.y, degrees.z, scale);
+            parser->last_transform_index = transformList_add(scene->transforms, parser->last_transform);
+            if (parser->last_transform_index < 0) {
+                return scene_file_error(parser, "out of memory for transforms", NULL);
+            }
+        }
+        transform = parser->last_transform_index;
+    }
+
+    Object object;
+    if (group != NULL) {
+        object = object_new_sphere_set(position, group->index, transform, material);
+    } else {
+        const int mesh_index = scene_file_load_mesh(parser, scene, parser->tokens[8]);
+        if (mesh_index < 0) {
+            return -1;
+        }
+        object = object_new_mesh(position, mesh_index, transform, material);
+    }
+    if (objectList_add(scene->objects, object) != 0) {
+        return scene_file_error(parser, "out of memory for objects", NULL);
+    }
+    return 0;
+}
+
+static int scene_file_parse_light(SceneFileParser* parser, Scene* scene) {
+    if (parser->token_count < 2) {
+        return scene_file_error(parser, "light needs a type", NULL);
+    }
+    if (parser->declared_lights >= 0 && (long)scene->lights->count >= parser->declared_lights) {
+        return scene_file_error(parser, "more lights than declared by 'lights'", NULL);
+    }
+
+    const char* type = parser->tokens[1];
+    Light light;
+    float intensity;
+
+    if (strcmp(type, "ambient") == 0) {
+        if (scene_file_expect_fields(parser, 3, 0) != 0 || scene_file_parse_float(parser, 2, &intensity) != 0) {
+            return -1;
+        }
+        light = light_new_ambient(intensity);
+    } else if (strcmp(type, "point") == 0 || strcmp(type, "directional") == 0) {
+        Vector3 vector;
+        if (scene_file_expect_fields(parser, 6, 0) != 0 ||
+            scene_file_parse_vector(parser, 2, &vector) != 0 ||
+            scene_file_parse_float(parser, 5, &intensity) != 0) {
+            return -1;
+        }
+        light = (type[0] == 'p') ? light_new_point(vector, intensity) : light_new_directional(vector, intensity);
+    } else {
+        return scene_file_error(parser, "unknown light type", type);
+    }
+
+    if (intensity < 0.0f) {
+        return scene_file_error(parser, "light intensity must not be negative", NULL);
+    }
+    if (lightList_add(scene->lights, light) != 0) {
+        return scene_file_error(parser, "out of memory for lights", NULL);
+    }
+    return 0;
+}
+
+static int scene_file_parse_camera(SceneFileParser* parser, Scene* scene) {
+    if (scene_file_expect_fields(parser, 4, 6) != 0) {
+        return -1;
+    }
+
+    Vector3 position;
+    float yaw = 0.0f;
+    float pitch = 0.0f;
+    if (scene_file_parse_vector(parser, 1, &position) != 0) {
+        return -1;
+    }
+    if (parser->token_count == 6 &&
+        (scene_file_parse_float(parser, 4, &yaw) != 0 || scene_file_parse_float(parser, 5, &pitch) != 0)) {
+        return -1;
+    }
+
+    scene->camera.is_set = 1;
+    scene->camera.position = position;
+    // Camera yaw M_PI_2 looks along +z
+    scene->camera.yaw = M_PI_2 + yaw * SCENE_FILE_DEGREES_TO_RADIANS;
+    scene->camera.pitch = pitch * SCENE_FILE_DEGREES_TO_RADIANS;
+    return 0;
+}
+
+// Parses an "objects" or "lights" count; it must precede the first element of its kind
+static int scene_file_parse_count(SceneFileParser* parser, Scene* scene) {
+    long count;
+    if (scene_file_expect_fields(parser, 2, 0) != 0 || scene_file_parse_long(parser, 1, 0, 1L << 30, &count) != 0) {
+        return -1;
+    }
+
+    if (parser->tokens[0][0] == 'o') {
+        if (parser->declared_objects >= 0 || scene->objects->count > 0) {
+            return scene_file_error(parser, "'objects' must appear once, before the first object", NULL);
+        }
+        if (objectList_reserve(scene->objects, (int)count) != 0) {
+            return scene_file_error(parser, "out of memory reserving objects", parser->tokens[1]);
+        }
+        parser->declared_objects = count;
+    } else {
+        if (parser->declared_lights >= 0 || scene->lights->count > 0) {
+            return scene_file_error(parser, "'lights' must appear once, before the first light", NULL);
+        }
+        if (lightList_reserve(scene->lights, (size_t)count) != 0) {
+            return scene_file_error(parser, "out of memory reserving lights", parser->tokens[1]);
+        }
+        parser->declared_lights = count;
+    }
+    return 0;
+}
+
+// Counts object and light lines without parsing them, then rewinds.
+// Spheres inside groups are not objects. Used only for files that do not declare their counts.
+static int scene_file_prescan(SceneFileParser* parser, long* objects, long* lights) {
+    *objects = 0;
+    *lights = 0;
+
+    int status;
+    int in_group = 0;
+    while ((status = scene_file_next_line(parser)) == 1) {
+        if (strcmp(parser->tokens[0], "group") == 0 || strcmp(parser->tokens[0], "end") == 0) {
+            in_group = parser->tokens[0][0] == 'g';
+        } else if (scene_file_is_object(parser->tokens[0]) && !in_group) {
+            (*objects)++;
+        } else if (strcmp(parser->tokens[0], "light") == 0) {
+            (*lights)++;
+        } else if (strcmp(parser->tokens[0], "objects") == 0 || strcmp(parser->tokens[0], "lights") == 0) {
+            // Counts are declared after all; the main pass handles them
+            *objects = 0;
+            *lights = 0;
+            break;
+        }
+    }
+    if (status < 0) {
+        return -1;
+    }
+
+    parser->line_number = 0;
+    if (fseek(parser->file, 0, SEEK_SET) != 0) {
+        fprintf(stderr, "%s: error: failed to rewind the file.\n", parser->path);
+        return -1;
+    }
+    return 0;
+}
+
+static int scene_file_parse(SceneFileParser* parser, Scene* scene) {
+    long counted_objects, counted_lights;
+    if (scene_file_prescan(parser, &counted_objects, &counted_lights) != 0) {
+        return -1;
+    }
+    if (objectList_reserve(scene->objects, (int)counted_objects) != 0 ||
+        lightList_reserve(scene->lights, (size_t)counted_lights) != 0) {
+        fprintf(stderr, "%s: error: out of memory reserving %ld objects and %ld lights.\n",
+                parser->path, counted_objects, counted_lights);
+        return -1;
+    }
+
+    int status;
+    while ((status = scene_file_next_line(parser)) == 1) {
+        const char* directive = parser->tokens[0];
+        int result;
+
+        if (parser->open_group != NULL && strcmp(directive, "sphere") != 0 && strcmp(directive, "material") != 0 &&
+            strcmp(directive, "end") != 0) {
+            result = scene_file_error(parser, "groups can only hold spheres, got", directive);
+        } else if (strcmp(directive, "mesh") == 0) {
+            result = scene_file_parse_mesh(parser, scene);
+        } else if (strcmp(directive, "instance") == 0) {
+            result = scene_file_parse_instance(parser, scene);
+        } else if (strcmp(directive, "group") == 0) {
+            result = scene_file_parse_group(parser);
+        } else if (strcmp(directive, "end") == 0) {
+            result = scene_file_parse_group_end(parser, scene);
+        } else if (scene_file_is_object(directive)) {
+            result = scene_file_parse_object(parser, scene);
+        } else if (strcmp(directive, "light") == 0) {
+            result = scene_file_parse_light(parser, scene);
+        } else if (strcmp(directive, "material") == 0) {
+            result = scene_file_parse_material(parser, scene);
+        } else if (strcmp(directive, "background") == 0) {
+            result = scene_file_expect_fields(parser, 4, 0);
+            if (result == 0) {
+                result = scene_file_parse_color(parser, 1, &scene->background_color);
+            }
+        } else if (strcmp(directive, "camera") == 0) {
+            result = scene_file_parse_camera(parser, scene);
+        } else if (strcmp(directive, "objects") == 0 || strcmp(directive, "lights") == 0) {
+            result = scene_file_parse_count(parser, scene);
+        } else {
+            result = scene_file_error(parser, "unknown directive", directive);
+        }
+
+        if (result != 0) {
+            return -1;
+        }
+    }
+    if (status < 0) {
+        return -1;
+    }
+
+    if (parser->open_group != NULL) {
+        fprintf(stderr, "%s:%d: error: group '%s' has no 'end'.\n", parser->path, parser->open_group_line, parser->open_group_name);
+        return -1;
+    }
+    if (parser->declared_objects >= 0 && scene->objects->count != parser->declared_objects) {
+        fprintf(stderr, "%s: error: 'objects' declared %ld objects but the file contains %d.\n",
+                parser->path, parser->declared_objects, scene->objects->count);
+        return -1;
+    }
+    if (parser->declared_lights >= 0 && (long)scene->lights->count != parser->declared_lights) {
+        fprintf(stderr, "%s: error: 'lights' declared %ld lights but the file contains %zu.\n",
+                parser->path, parser->declared_lights, scene->lights->count);
+        return -1;
+    }
+
+    return 0;
+}
+
+int scene_file_load(Scene* scene, const char* path) {
+    if (scene == NULL || path == NULL) {
+        fprintf(stderr, "Error: scene_file_load received a NULL pointer.\n");
+        return -1;
+    }
+
+    Uint64 load_start = SDL_GetPerformanceCounter();
+
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    if (scene_init_empty(scene) != 0) {
+        fclose(file);
+        scene_clean_up(scene);
+        return -1;
+    }
+
+    SceneFileParser parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.path = path;
+    parser.file = file;
+    parser.declared_objects = -1;
+    parser.declared_lights = -1;
+    parser.last_inline_index = -1;
+    parser.last_transform_index = -1;
+
+    int status = scene_file_parse(&parser, scene);
+    free(parser.materials);
+    free(parser.material_slots);
+    free(parser.groups);
+    free(parser.group_centers);
+    free(parser.group_radii);
+    free(parser.group_materials);
+    fclose(file);
+
+    if (status != 0) {
+        scene_clean_up(scene);
+        return -1;
+    }
+
+    double parse_ms = (double)(SDL_GetPerformanceCounter() - load_start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    printf("Loaded %d objects, %zu lights and %zu materials from %s in %.1f ms.\n",
+           scene->objects->count, scene->lights->count, scene->materials->count, path, parse_ms);
+
+    if (scene_build_acceleration(scene) != 0) {
+        scene_clean_up(scene);
+        return -1;
+    }
+    return 0;
+}
+
+int scene_file_write(const Scene* scene, FILE* stream) {
+    if (scene == NULL || scene->objects == NULL || scene->lights == NULL || scene->materials == NULL || scene->meshes == NULL ||
+        scene->sphere_sets == NULL || scene->transforms == NULL || stream == NULL) {
+        fprintf(stderr, "Error: scene_file_write received a NULL pointer.\n");
+        return -1;
+    }
+    for (int i = 0; i < scene->meshes->count; ++i) {
+        if (scene->meshes->meshes[i].source == NULL) {
+            fprintf(stderr, "Error: scene_file_write cannot write mesh %d, which was not loaded from a file.\n", i);
+            return -1;
+        }
+    }
+
+    fprintf(stream, "objects %d\nlights %zu\n", scene->objects->count, scene->lights->count);
+    fprintf(stream, "background %d %d %d\n",
+            (int)scene->background_color.r, (int)scene->background_color.g, (int)scene->background_color.b);
+
+    if (scene->camera.is_set) {
+        fprintf(stream, "camera %.9g %.9g %.9g %.9g %.9g\n",
+                scene->camera.position.x, scene->camera.position.y, scene->camera.position.z,
+                (scene->camera.yaw - M_PI_2) / SCENE_FILE_DEGREES_TO_RADIANS,
+                scene->camera.pitch / SCENE_FILE_DEGREES_TO_RADIANS);
+    }
+
+    for (size_t i = 0; i < scene->lights->count; ++i) {
+        const Light* light = &scene->lights->lights[i];
+        switch (light->type) {
+            case LIGHT_TYPE_AMBIENT:
+                fprintf(stream, "light ambient %.9g\n", light->intensity);
+                break;
+            case LIGHT_TYPE_POINT:
+                fprintf(stream, "light point %.9g %.9g %.9g %.9g\n", light->data.pointData.position.x,
+                        light->data.pointData.position.y, light->data.pointData.position.z, light->intensity);
+                break;
+            case LIGHT_TYPE_DIRECTIONAL:
+                fprintf(stream, "light directional %.9g %.9g %.9g %.9g\n", light->data.directionalData.direction.x,
+                        light->data.directionalData.direction.y, light->data.directionalData.direction.z, light->intensity);
+                break;
+        }
+    }
+
+    // Materials are written by table index, so loading the file again reproduces the same table
+    for (size_t i = 0; i < scene->materials->count; ++i) {
+        const Material* material = &scene->materials->materials[i];
+        fprintf(stream, "material m%zu %d %d %d %d %.9g\n", i,
+                (int)material->color.r, (int)material->color.g, (int)material->color.b, material->specularity, material->reflectivity);
+    }
+
+    // Sphere sets become groups named by list index, their spheres in leaf order
+    for (int i = 0; i < scene->sphere_sets->count; ++i) {
+        const SphereSet* set = &scene->sphere_sets->sets[i];
+        fprintf(stream, "group g%d\n", i);
+        for (int j = 0; j < set->count; ++j) {
+            fprintf(stream, "sphere %.9g %.9g %.9g %.9g m%d\n", set->spheres.center_x[j], set->spheres.center_y[j],
+                    set->spheres.center_z[j], sphere_set_radius(set, j), set->materials[j]);
+        }
+        fprintf(stream, "end\n");
+    }
+
+    for (int i = 0; i < scene->objects->count; ++i) {
+        const Object* object = &scene->objects->objects[i];
+        const Vector3 position = object->position;
+        switch (object->type) {
+            case OBJECT_TYPE_SPHERE:
+                fprintf(stream, "sphere %.9g %.9g %.9g %.9g m%d\n",
+                        position.x, position.y, position.z, object->data.sphereData.radius, object->material);
+                break;
+            case OBJECT_TYPE_CUBE:
+                fprintf(stream, "cube %.9g %.9g %.9g %.9g m%d\n",
+                        position.x, position.y, position.z, 2.0f * object->data.boxData.half_extents.x, object->material);
+                break;
+            case OBJECT_TYPE_CUBOID:
+                fprintf(stream, "cuboid %.9g %.9g %.9g %.9g %.9g %.9g m%d\n",
+                        position.x, position.y, position.z, 2.0f * object->data.boxData.half_extents.x,
+                        2.0f * object->data.boxData.half_extents.y, 2.0f * object->data.boxData.half_extents.z, object->material);
+                break;
+            case OBJECT_TYPE_PLANE:
+                fprintf(stream, "plane %.9g %.9g %.9g %.9g %.9g %.9g m%d\n",
+                        position.x, position.y, position.z, object->data.planeData.normal.x,
+                        object->data.planeData.normal.y, object->data.planeData.normal.z, object->material);
+                break;
+            case OBJECT_TYPE_MESH:
+            case OBJECT_TYPE_SPHERE_SET: {
+                const InstanceObjectData* data = &object->data.instanceData;
+                if (object->type == OBJECT_TYPE_MESH && data->transform < 0) {
+                    fprintf(stream, "mesh %.9g %.9g %.9g %s m%d\n", position.x, position.y, position.z,
+                            scene->meshes->meshes[data->geometry].source, object->material);
+                    break;
+                }
+
+                Transform identity = transform_new(0.0f, 0.0f, 0.0f, 1.0f);
+                const Transform* transform = (data->transform >= 0) ? &scene->transforms->transforms[data->transform] : &identity;
+                fprintf(stream, "instance %.9g %.9g %.9g %.9g %.9g %.9g %.9g ", position.x, position.y, position.z,
+                        transform->degrees.x, transform->degrees.y, transform->degrees.z, transform->scale);
+                if (object->type == OBJECT_TYPE_MESH) {
+                    fprintf(stream, "%s", scene->meshes->meshes[data->geometry].source);
+                } else {
+                    fprintf(stream, "g%d", data->geometry);
+                }
+                if (object->material != OBJECT_MATERIAL_INHERIT) {
+                    fprintf(stream, " m%d", object->material);
+                }
+                fprintf(stream, "\n");
+                break;
+            }
+        }
+    }
+
+    return ferror(stream) ? -1 : 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "../scene/scene.h"
+
+#ifndef _SCENE_FILE_H_
+#define _SCENE_FILE_H_
+
+#define SCENE_FILE_MAX_LINE 512        // Longest accepted line, including the newline
+#define SCENE_FILE_MAX_TOKENS 16       // Most whitespace separated fields on one line
+#define SCENE_FILE_MAX_NAME 32         // Longest material or group name, including the terminator
+
+// Loads a text scene description into an uninitialized scene and builds its acceleration structure.
+// Every line holds one directive; '#' starts a comment:
+//   objects <count>                          optional; reserves the object list up front
+//   lights <count>                           optional; reserves the light list up front
+//   background <r> <g> <b>
+//   camera <x> <y> <z> [<yaw> <pitch>]       degrees; yaw 0 looks along +z
+//   material <name> <r> <g> <b> <specular> <reflectivity>
+//   sphere <x> <y> <z> <radius> <material>
+//   sphere <x> <y> <z> <radius> <r> <g> <b> <specular> <reflectivity>   adds an anonymous material
+//   cube <x> <y> <z> <size> <material>                 axis-aligned; <x> <y> <z> is the center
+//   cuboid <x> <y> <z> <size x> <size y> <size z> <material>
+//   plane <x> <y> <z> <normal x> <normal y> <normal z> <material>      infinite, through <x> <y> <z>
+//   mesh <x> <y> <z> <file.obj> <material>   triangles of a Wavefront OBJ file, moved by <x> <y> <z>;
+//                                            the path is relative to the scene file and may not contain spaces
+//   (every object line accepts an inline surface in place of <material>, like sphere)
+//   group <name>                             the following sphere lines, up to "end", form shared geometry
+//   end                                      instead of objects; a group can only hold spheres
+//   instance <x> <y> <z> <yaw> <pitch> <roll> <scale> <group|file.obj> [<material>]
+//                                            rotated (degrees, like the camera plus roll about +z), uniformly
+//                                            scaled and moved copy of a group or OBJ file; without a material,
+//                                            the spheres of a group keep their own (meshes need one)
+//   light ambient <intensity>
+//   light point <x> <y> <z> <intensity>
+//   light directional <x> <y> <z> <intensity>
+// Without count lines the file is scanned once to count objects and lights before parsing.
+// Every OBJ file is loaded once, however many mesh and instance lines name it, and every group is built once.
+// Errors are reported as "path:line: error: ...". Returns 0 on success, -1 on failure (the scene is cleaned up).
+int scene_file_load(Scene* scene, const char* path);
+
+// Writes a scene in the format read by scene_file_load. Mesh objects name the OBJ file by the path it was
+// opened under, so relative paths stay valid when the file is written next to the scene it was loaded from;
+// meshes that were not loaded from a file cannot be written. Sphere sets become groups named g<index>.
+// Returns 0 on success, -1 on failure.
+int scene_file_write(const Scene* scene, FILE* stream);
+
+#endif
@@ -0,0 +1,316 @@
+#include "./scene_generator.h"
+
+#include <string.h>
+
+// Generated spheres fill this box in front of a camera at the origin looking along +z
+#define SCENE_GENERATOR_MIN_X -30.0f
+#define SCENE_GENERATOR_MAX_X 30.0f
+#define SCENE_GENERATOR_MIN_Y -9.0f
+#define SCENE_GENERATOR_MAX_Y 15.0f
+#define SCENE_GENERATOR_MIN_Z 4.0f
+#define SCENE_GENERATOR_MAX_Z 80.0f
+#define SCENE_GENERATOR_LIGHT_HEIGHT 30.0f       // Height of the grid layout's light lattice
+#define SCENE_GENERATOR_CLUSTER_SIZE 4096         // Spheres per cluster in the clustered layout
+#define SCENE_GENERATOR_CLUSTER_SPREAD 4.0f       // Half extent of a cluster along each axis
+#define SCENE_GENERATOR_GROUND_MATERIAL 0          // Material of the ground plane; the palette follows it
+#define SCENE_GENERATOR_PROTOTYPES 16              // Sphere sets shared by the instanced layout
+#define SCENE_GENERATOR_PROTOTYPE_SPHERES 64       // Spheres per sphere set
+#define SCENE_GENERATOR_TRANSFORMS 256             // Rotations and scales shared by the instances
+
+static const char* const scene_generator_layout_names[] = { "uniform", "clustered", "grid", "instanced" };
+
+void scene_generator_params_init(SceneGeneratorParams* params, int object_count, int light_count) {
+    params->layout = SCENE_GENERATOR_UNIFORM;
+    params->object_count = object_count;
+    params->light_count = light_count;
+    params->seed = SCENE_GENERATOR_DEFAULT_SEED;
+}
+
+int scene_generator_parse_layout(const char* name, SceneGeneratorLayout* layout) {
+    for (int i = 0; i < (int)(sizeof(scene_generator_layout_names) / sizeof(scene_generator_layout_names[0])); ++i) {
+        if (strcmp(name, scene_generator_layout_names[i]) == 0) {
+            *layout = (SceneGeneratorLayout)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* scene_generator_layout_name(SceneGeneratorLayout layout) {
+    return scene_generator_layout_names[layout];
+}
+
+// xorshift32: small, fast and identical on every platform
+static float scene_generator_random(unsigned int* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (float)(*state >> 8) / 16777216.0f;
+}
+
+static float scene_generator_random_range(unsigned int* state, float min, float max) {
+    return min + (max - min) * scene_generator_random(state);
+}
+
+// Cube root by a fixed number of Newton steps, so the result does not depend on the libm in use
+static float scene_generator_cbrt(float x) {
+    float y = (x > 1.0f) ? x : 1.0f;   // Start above the root; Newton then decreases monotonically
+    for (int i = 0; i < 40; ++i) {
+        y = (2.0f * y + x / (y * y)) / 3.0f;
+    }
+    return y;
+}
+
+// Smallest side such that side^dimensions >= count
+static int scene_generator_lattice_side(int count, int dimensions) {
+    int side = 1;
+    for (;;) {
+        long long cells = side;
+        for (int d = 1; d < dimensions; ++d) {
+            cells *= side;
+        }
+        if (cells >= count) {
+            return side;
+        }
+        ++side;
+    }
+}
+
+// Palette shared by all layouts: half the materials are matte, half are mirrors of varying strength
+static void scene_generator_add_materials(MaterialList* materials, unsigned int state) {
+    if (state == 0) {
+        state = SCENE_GENERATOR_DEFAULT_SEED;
+    }
+    materialList_add(materials, material_new(color_new(200, 200, 60), 100, 0.3f));
+
+    for (int i = 0; i < SCENE_GENERATOR_PALETTE_SIZE; ++i) {
+        Color color = color_new((unsigned char)scene_generator_random_range(&state, 40.0f, 255.0f),
+                                (unsigned char)scene_generator_random_range(&state, 40.0f, 255.0f),
+                                (unsigned char)scene_generator_random_range(&state, 40.0f, 255.0f));
+        int specularity = (scene_generator_random(&state) < 0.5f) ? 0 : (int)scene_generator_random_range(&state, 10.0f, 1000.0f);
+        float reflectivity = (scene_generator_random(&state) < 0.5f) ? 0.0f : scene_generator_random_range(&state, 0.1f, 0.6f);
+        materialList_add(materials, material_new(color, specularity, reflectivity));
+    }
+}
+
+// Sphere with a random palette material
+static Object scene_generator_sphere(unsigned int* state, Vector3 center, float radius) {
+    int material = SCENE_GENERATOR_GROUND_MATERIAL + 1 + (int)(scene_generator_random(state) * SCENE_GENERATOR_PALETTE_SIZE);
+    return object_new_sphere(center, radius, material);
+}
+
+static Vector3 scene_generator_random_point(unsigned int* state) {
+    return vector3_new(scene_generator_random_range(state, SCENE_GENERATOR_MIN_X, SCENE_GENERATOR_MAX_X),
+                       scene_generator_random_range(state, SCENE_GENERATOR_MIN_Y, SCENE_GENERATOR_MAX_Y),
+                       scene_generator_random_range(state, SCENE_GENERATOR_MIN_Z, SCENE_GENERATOR_MAX_Z));
+}
+
+static void scene_generator_add_uniform(ObjectList* objects, unsigned int* state, int count) {
+    // Shrink the spheres as their number grows so that screen coverage stays comparable
+    const float radius_scale = scene_generator_cbrt(256.0f / (float)count);
+
+    for (int i = 0; i < count; ++i) {
+        Vector3 center = scene_generator_random_point(state);
+        float radius = scene_generator_random_range(state, 0.3f, 1.5f) * radius_scale;
+        objectList_add(objects, scene_generator_sphere(state, center, radius));
+    }
+}
+
+static void scene_generator_add_clustered(ObjectList* objects, unsigned int* state, int count) {
+    const float radius_scale = scene_generator_cbrt(256.0f / (float)count);
+
+    // Cluster centers come from their own stream so that they do not depend on the sphere draws
+    unsigned int cluster_state = *state ^ 0x85EBCA6Bu;
+    Vector3 cluster_center = vector3_new(0.0f, 0.0f, 0.0f);
+
+    for (int i = 0; i < count; ++i) {
+        if (i % SCENE_GENERATOR_CLUSTER_SIZE == 0) {
+            cluster_center = scene_generator_random_point(&cluster_state);
+        }
+
+        // The sum of three uniforms concentrates spheres towards the cluster center
+        Vector3 offset;
+        offset.x = scene_generator_random(state) + scene_generator_random(state) + scene_generator_random(state) - 1.5f;
+        offset.y = scene_generator_random(state) + scene_generator_random(state) + scene_generator_random(state) - 1.5f;
+        offset.z = scene_generator_random(state) + scene_generator_random(state) + scene_generator_random(state) - 1.5f;
+        Vector3 center = vector3_add(cluster_center, vector3_scale(offset, SCENE_GENERATOR_CLUSTER_SPREAD / 1.5f));
+
+        float radius = scene_generator_random_range(state, 0.2f, 1.0f) * radius_scale;
+        objectList_add(objects, scene_generator_sphere(state, center, radius));
+    }
+}
+
+static void scene_generator_add_grid(ObjectList* objects, unsigned int* state, int count) {
+    const int side = scene_generator_lattice_side(count, 3);
+    const float step_x = (SCENE_GENERATOR_MAX_X - SCENE_GENERATOR_MIN_X) / (float)side;
+    const float step_y = (SCENE_GENERATOR_MAX_Y - SCENE_GENERATOR_MIN_Y) / (float)side;
+    const float step_z = (SCENE_GENERATOR_MAX_Z - SCENE_GENERATOR_MIN_Z) / (float)side;
+    float radius = 0.4f * step_x;
+    if (0.4f * step_y < radius) radius = 0.4f * step_y;
+    if (0.4f * step_z < radius) radius = 0.4f * step_z;
+
+    for (int i = 0; i < count; ++i) {
+        const int ix = i % side;
+        const int iy = (i / side) % side;
+        const int iz = i / (side * side);
+        Vector3 center = vector3_new(SCENE_GENERATOR_MIN_X + step_x * ((float)ix + 0.5f),
+                                     SCENE_GENERATOR_MIN_Y + step_y * ((float)iy + 0.5f),
+                                     SCENE_GENERATOR_MIN_Z + step_z * ((float)iz + 0.5f));
+        objectList_add(objects, scene_generator_sphere(state, center, radius));
+    }
+}
+
+// Prototype sphere sets of the instanced layout: loose clusters about one unit across with palette materials
+static int scene_generator_add_prototypes(SphereSetList* sets, unsigned int* state) {
+    Vector3 centers[SCENE_GENERATOR_PROTOTYPE_SPHERES];
+    float radii[SCENE_GENERATOR_PROTOTYPE_SPHERES];
+    int materials[SCENE_GENERATOR_PROTOTYPE_SPHERES];
+
+    for (int p = 0; p < SCENE_GENERATOR_PROTOTYPES; ++p) {
+        for (int i = 0; i < SCENE_GENERATOR_PROTOTYPE_SPHERES; ++i) {
+            centers[i] = vector3_new(scene_generator_random(state) + scene_generator_random(state) - 1.0f,
+                                     scene_generator_random(state) + scene_generator_random(state) - 1.0f,
+                                     scene_generator_random(state) + scene_generator_random(state) - 1.0f);
+            radii[i] = scene_generator_random_range(state, 0.08f, 0.3f);
+            materials[i] = SCENE_GENERATOR_GROUND_MATERIAL + 1 + (int)(scene_generator_random(state) * SCENE_GENERATOR_PALETTE_SIZE);
+        }
+
+        SphereSet set;
+        if (sphere_set_init(&set, centers, radii, materials, SCENE_GENERATOR_PROTOTYPE_SPHERES) != 0) {
+            return -1;
+        }
+        if (sphereSetList_add(sets, &set) < 0) {
+            sphere_set_free(&set);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Instances of the prototypes with shared transforms; half keep the materials of their spheres
+static int scene_generator_add_instanced(Scene* scene, unsigned int* state, int count) {
+    // Prototypes and transforms come from their own stream so that they do not depend on the instance count
+    unsigned int prototype_state = *state ^ 0x27D4EB2Fu;
+    if (scene_generator_add_prototypes(scene->sphere_sets, &prototype_state) != 0) {
+        return -1;
+    }
+
+    const float scale = scene_generator_cbrt(256.0f / (float)count);
+    for (int i = 0; i < SCENE_GENERATOR_TRANSFORMS; ++i) {
+        const float yaw = (float)(int)scene_generator_random_range(&prototype_state, 0.0f, 360.0f);
+        const float pitch = (float)(int)scene_generator_random_range(&prototype_state, -90.0f, 90.0f);
+        const float roll = (float)(int)scene_generator_random_range(&prototype_state, 0.0f, 360.0f);
+        if (transformList_add(scene->transforms, transform_new(yaw, pitch, roll,
+                                                               scene_generator_random_range(&prototype_state, 0.6f, 1.4f) * scale)) < 0) {
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        Vector3 position = scene_generator_random_point(state);
+        const int prototype = (int)(scene_generator_random(state) * SCENE_GENERATOR_PROTOTYPES);
+        const int transform = (int)(scene_generator_random(state) * SCENE_GENERATOR_TRANSFORMS);
+        int material = OBJECT_MATERIAL_INHERIT;
+        if (scene_generator_random(state) < 0.5f) {
+            material = SCENE_GENERATOR_GROUND_MATERIAL + 1 + (int)(scene_generator_random(state) * SCENE_GENERATOR_PALETTE_SIZE);
+        }
+        objectList_add(scene->objects, object_new_sphere_set(position, prototype, transform, material));
+    }
+    return 0;
+}
+
+// One ambient light first; the grid layout adds a lattice of point lights, the others random point and directional lights
+static void scene_generator_add_lights(LightList* lights, unsigned int* state, const SceneGeneratorParams* params) {
+    lightList_add(lights, light_new_ambient(0.2f));
+
+    const int count = params->light_count - 1;
+    if (count <= 0) {
+        return;
+    }
+    const float intensity = 0.8f / (float)count;
+
+    if (params->layout == SCENE_GENERATOR_GRID) {
+        const int side = scene_generator_lattice_side(count, 2);
+        const float step_x = (SCENE_GENERATOR_MAX_X - SCENE_GENERATOR_MIN_X) / (float)side;
+        const float step_z = (SCENE_GENERATOR_MAX_Z - SCENE_GENERATOR_MIN_Z) / (float)side;
+
+        for (int i = 0; i < count; ++i) {
+            Vector3 position = vector3_new(SCENE_GENERATOR_MIN_X + step_x * ((float)(i % side) + 0.5f),
+                                           SCENE_GENERATOR_LIGHT_HEIGHT,
+                                           SCENE_GENERATOR_MIN_Z + step_z * ((float)(i / side) + 0.5f));
+            lightList_add(lights, light_new_point(position, intensity));
+        }
+        return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (i % 2 == 0) {
+            Vector3 position = vector3_new(scene_generator_random_range(state, -40.0f, 40.0f),
+                                           scene_generator_random_range(state, 5.0f, 40.0f),
+                                           scene_generator_random_range(state, -10.0f, 60.0f));
+            lightList_add(lights, light_new_point(position, intensity));
+        } else {
+            Vector3 direction = vector3_new(scene_generator_random_range(state, -1.0f, 1.0f),
+                                            scene_generator_random_range(state, 0.5f, 4.0f),
+                                            scene_generator_random_range(state, -1.0f, 4.0f));
+            lightList_add(lights, light_new_directional(direction, intensity));
+        }
+    }
+}
+
+int scene_generator_populate(Scene* scene, const SceneGeneratorParams* params) {
+    if (scene == NULL || params == NULL) {
+        fprintf(stderr, "Error: scene_generator_populate received a NULL pointer.\n");
+        return -1;
+    }
+    if (params->object_count < 1 || params->object_count > SCENE_GENERATOR_MAX_OBJECTS ||
+        params->light_count < 1 || params->light_count > SCENE_GENERATOR_MAX_LIGHTS) {
+        fprintf(stderr, "Error: scene_generator_populate needs 1-%d objects and 1-%d lights, got %d and %d.\n",
+                SCENE_GENERATOR_MAX_OBJECTS, SCENE_GENERATOR_MAX_LIGHTS, params->object_count, params->light_count);
+        return -1;
+    }
+
+    if (scene_init_empty(scene) != 0 ||
+        objectList_reserve(scene->objects, params->object_count) != 0 ||
+        lightList_reserve(scene->lights, (size_t)params->light_count) != 0 ||
+        materialList_reserve(scene->materials, SCENE_GENERATOR_PALETTE_SIZE + 1) != 0) {
+        fprintf(stderr, "Error: Failed to allocate a generated scene of %d objects.\n", params->object_count);
+        scene_clean_up(scene);
+        return -1;
+    }
+
+    // xorshift never leaves the all-zero state
+    unsigned int state = (params->seed != 0) ? params->seed : SCENE_GENERATOR_DEFAULT_SEED;
+
+    // The palette comes from its own stream so that it does not depend on the layout
+    scene_generator_add_materials(scene->materials, state ^ 0xC2B2AE35u);
+
+    // A ground plane below the box gives shadows and reflections something to land on
+    objectList_add(scene->objects, object_new_plane(vector3_new(0.0f, -10.0f, 0.0f), vector3_new(0.0f, 1.0f, 0.0f), SCENE_GENERATOR_GROUND_MATERIAL));
+
+    const int sphere_count = params->object_count - 1;
+    if (sphere_count > 0) {
+        switch (params->layout) {
+            case SCENE_GENERATOR_UNIFORM:
+                scene_generator_add_uniform(scene->objects, &state, sphere_count);
+                break;
+            case SCENE_GENERATOR_CLUSTERED:
+                scene_generator_add_clustered(scene->objects, &state, sphere_count);
+                break;
+            case SCENE_GENERATOR_GRID:
+                scene_generator_add_grid(scene->objects, &state, sphere_count);
+                break;
+            case SCENE_GENERATOR_INSTANCED:
+                if (scene_generator_add_instanced(scene, &state, sphere_count) != 0) {
+                    fprintf(stderr, "Error: Failed to allocate the shared geometry of a generated scene.\n");
+                    scene_clean_up(scene);
+                    return -1;
+                }
+                break;
+        }
+    }
+
+    scene_generator_add_lights(scene->lights, &state, params);
+
+    return 0;
+}
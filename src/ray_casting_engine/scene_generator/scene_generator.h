@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "../scene/scene.h"
+
+#ifndef _SCENE_GENERATOR_H_
+#define _SCENE_GENERATOR_H_
+
+#define SCENE_GENERATOR_MAX_OBJECTS 10000000   // Upper end of the scaling studies
+#define SCENE_GENERATOR_MAX_LIGHTS 10000000    // Shading is linear in the light count; wavefront shadow queues are batched
+#define SCENE_GENERATOR_DEFAULT_SEED 0x9E3779B9u
+#define SCENE_GENERATOR_PALETTE_SIZE 64        // Random materials shared by the generated spheres
+
+// Spatial distribution of the generated spheres
+typedef enum SceneGeneratorLayout {
+    SCENE_GENERATOR_UNIFORM,     // Uniformly random spheres in a box in front of the origin
+    SCENE_GENERATOR_CLUSTERED,   // Dense random clusters with empty space between them
+    SCENE_GENERATOR_GRID,        // Regular lattice of spheres lit by a lattice of point lights
+    SCENE_GENERATOR_INSTANCED    // Uniformly random instances of a few shared sphere sets, rotated and scaled
+} SceneGeneratorLayout;
+
+typedef struct SceneGeneratorParams {
+    SceneGeneratorLayout layout;
+    int object_count;            // Objects including the ground plane, 1 to SCENE_GENERATOR_MAX_OBJECTS
+    int light_count;             // Lights including the ambient light, 1 to SCENE_GENERATOR_MAX_LIGHTS
+    unsigned int seed;           // Same seed and counts give the same scene on every platform
+} SceneGeneratorParams;
+
+// Fills params with a uniform layout of object_count spheres and light_count lights and the default seed
+void scene_generator_params_init(SceneGeneratorParams* params, int object_count, int light_count);
+
+// Parses "uniform", "clustered", "grid" or "instanced". Returns 0 on success, -1 for unknown names.
+int scene_generator_parse_layout(const char* name, SceneGeneratorLayout* layout);
+
+// Returns the name parsed by scene_generator_parse_layout
+const char* scene_generator_layout_name(SceneGeneratorLayout layout);
+
+// Initializes an empty scene and adds the generated spheres, materials and lights, reserving every list once.
+// No BVH is built, so the scene can be passed to scene_file_write as is or to scene_build_acceleration.
+// Only integer and basic IEEE float arithmetic is used, so the output does not depend on the C library
+// (instance rotations are drawn as angles; only their matrices go through libm).
+// Returns 0 on success, -1 on failure (the scene is cleaned up).
+int scene_generator_populate(Scene* scene, const SceneGeneratorParams* params);
+
+#endif
@@ -0,0 +1,132 @@
+#include "./sphere_set.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_SPHERE_SET_CAPACITY 4 // Starting capacity for sphere set list
+
+static void sphere_set_clear(SphereSet* set) {
+    memset(set, 0, sizeof(*set));
+    bvh_init(&set->bvh);
+}
+
+int sphere_set_init(SphereSet* set, const Vector3* centers, const float* radii, const int* materials, int count) {
+    if (set == NULL) {
+        fprintf(stderr, "Error: sphere_set_init received a NULL set pointer.\n");
+        return -1;
+    }
+    sphere_set_clear(set);
+
+    if (centers == NULL || radii == NULL || materials == NULL || count <= 0) {
+        fprintf(stderr, "Error: sphere_set_init needs at least one sphere.\n");
+        return -1;
+    }
+
+    const size_t spheres = (size_t)count;
+    float* soa = (float*)malloc(4 * spheres * sizeof(float));   // One block for the four SoA arrays
+    set->materials = (int*)malloc(spheres * sizeof(int));
+    Aabb* bounds = (Aabb*)malloc(spheres * sizeof(Aabb));
+    int* order = (int*)malloc(spheres * sizeof(int));
+    if (soa == NULL || set->materials == NULL || bounds == NULL || order == NULL) {
+        fprintf(stderr, "Error: Failed to allocate a sphere set of %d spheres.\n", count);
+        free(soa);
+        free(bounds);
+        free(order);
+        sphere_set_free(set);
+        return -1;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const Vector3 extent = vector3_new(radii[i], radii[i], radii[i]);
+        bounds[i].min = vector3_subtract(centers[i], extent);
+        bounds[i].max = vector3_add(centers[i], extent);
+    }
+
+    if (bvh_build(&set->bvh, bounds, NULL, NULL, count, order) != 0) {
+        fprintf(stderr, "Error: Failed to build the BVH of a sphere set of %d spheres.\n", count);
+        free(soa);
+        free(bounds);
+        free(order);
+        sphere_set_free(set);
+        return -1;
+    }
+
+    set->spheres.center_x = soa;
+    set->spheres.center_y = soa + spheres;
+    set->spheres.center_z = soa + 2 * spheres;
+    set->spheres.radius_sq = soa + 3 * spheres;
+    set->count = count;
+
+    // Store the spheres in leaf order so that every leaf reads a contiguous slice of each array
+    set->bounds = bounds[order[0]];
+    for (int i = 0; i < count; ++i) {
+        const int source = order[i];
+        set->spheres.center_x[i] = centers[source].x;
+        set->spheres.center_y[i] = centers[source].y;
+        set->spheres.center_z[i] = centers[source].z;
+        set->spheres.radius_sq[i] = radii[source] * radii[source];
+        set->materials[i] = materials[source];
+        set->bounds = aabb_union(set->bounds, bounds[source]);
+    }
+
+    free(bounds);
+    free(order);
+    return 0;
+}
+
+void sphere_set_free(SphereSet* set) {
+    if (set == NULL) {
+        return;
+    }
+    free(set->spheres.center_x);   // Start of the block holding all four arrays
+    free(set->materials);
+    bvh_free(&set->bvh);
+    sphere_set_clear(set);
+}
+
+int sphereSetList_init(SphereSetList* list) {
+    if (list == NULL) {
+        fprintf(stderr, "Error: sphereSetList_init received a NULL list pointer.\n");
+        return -1;
+    }
+
+    list->sets = NULL;
+    list->count = 0;
+    list->capacity = 0;
+    list->generation = 0;
+    return 0;
+}
+
+int sphereSetList_add(SphereSetList* list, SphereSet* set) {
+    if (list == NULL || set == NULL) {
+        return -1;
+    }
+
+    if (list->count == list->capacity) {
+        int new_capacity = (list->capacity == 0) ? INITIAL_SPHERE_SET_CAPACITY : list->capacity * 2;
+        SphereSet* grown = (SphereSet*)realloc(list->sets, (size_t)new_capacity * sizeof(SphereSet));
+        if (grown == NULL) {
+            return -1;
+        }
+        list->sets = grown;
+        list->capacity = new_capacity;
+    }
+
+    list->sets[list->count] = *set;
+    sphere_set_clear(set);
+    list->generation++;
+    return list->count++;
+}
+
+void sphereSetList_free(SphereSetList* list) {
+    if (list == NULL) {
+        return;
+    }
+    for (int i = 0; i < list->count; ++i) {
+        sphere_set_free(&list->sets[i]);
+    }
+    free(list->sets);
+    list->sets = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+#include "../bvh/bvh.h"
+#include "../object/object.h"
+#include "../vector/vector.h"
+
+#ifndef _SPHERE_SET_H_
+#define _SPHERE_SET_H_
+
+// Group of spheres in its own space, with a BVH over them.
+// Objects of type OBJECT_TYPE_SPHERE_SET reference a set by index, so any number of them share one copy.
+typedef struct SphereSet {
+    SphereSoA spheres;          // Centers and squared radii in BVH leaf order, as tested by the sphere kernel
+    int* materials;             // Material of every sphere, same order; used when the instance does not override it
+    int count;
+    Bvh bvh;                    // Leaves index spheres directly
+    Aabb bounds;                // Of all spheres
+} SphereSet;
+
+typedef struct SphereSetList {
+    SphereSet* sets;
+    int count;
+    int capacity;
+    unsigned int generation;    // Incremented whenever a set is added
+} SphereSetList;
+
+// Copies count spheres, builds the BVH and stores the spheres in leaf order.
+// Returns 0 on success, -1 on failure (the set is left empty).
+int sphere_set_init(SphereSet* set, const Vector3* centers, const float* radii, const int* materials, int count);
+
+// Radius of a sphere in leaf order
+static inline float sphere_set_radius(const SphereSet* set, int sphere) {
+    return sqrtf(set->spheres.radius_sq[sphere]);
+}
+
+void sphere_set_free(SphereSet* set);
+
+int sphereSetList_init(SphereSetList* list);
+// Moves a set into the list, which then owns its buffers (*set is left empty). Returns its index, or -1 on failure.
+int sphereSetList_add(SphereSetList* list, SphereSet* set);
+void sphereSetList_free(SphereSetList* list);
+
+#endif
@@ -0,0 +1,253 @@
+#include "./thread_pool.h"
+
+typedef struct WorkerStart {
+    ThreadPool* pool;
+    int worker_index;
+} WorkerStart;
+
+int thread_pool_default_worker_count(void) {
+    int cpu_count = SDL_GetCPUCount();
+    return (cpu_count > 0) ? cpu_count : 1;
+}
+
+// Takes the newest task of the worker's own deque. Returns -1 when it is empty.
+static int task_deque_pop(TaskDeque* deque) {
+    int task = -1;
+
+    SDL_AtomicLock(&deque->lock);
+    if (deque->tail > deque->head) {
+        task = deque->tasks[--deque->tail];
+    }
+    SDL_AtomicUnlock(&deque->lock);
+
+    return task;
+}
+
+// Takes the oldest task of another worker's deque. Returns -1 when it is empty.
+static int task_deque_steal(TaskDeque* deque) {
+    int task = -1;
+
+    SDL_AtomicLock(&deque->lock);
+    if (deque->tail > deque->head) {
+        task = deque->tasks[deque->head++];
+    }
+    SDL_AtomicUnlock(&deque->lock);
+
+    return task;
+}
+
+// Runs tasks until neither the worker's own deque nor any victim has work left.
+// Tasks never spawn new tasks, so a full empty sweep means the batch is drained.
+static void thread_pool_drain(ThreadPool* pool, int worker_index) {
+    for (;;) {
+        int task = task_deque_pop(&pool->deques[worker_index]);
+
+        // Own deque is empty: try every other worker, starting with the next one
+        for (int offset = 1; task < 0 && offset < pool->worker_count; ++offset) {
+            int victim = (worker_index + offset) % pool->worker_count;
+            task = task_deque_steal(&pool->deques[victim]);
+        }
+
+        if (task < 0) {
+            return;
+        }
+
+        pool->task_fn(pool->context, task, worker_index);
+    }
+}
+
+static int thread_pool_worker(void* data) {
+    WorkerStart* start = (WorkerStart*)data;
+    ThreadPool* pool = start->pool;
+    const int worker_index = start->worker_index;
+    free(start);
+
+    unsigned int seen_batch = 0;
+
+    SDL_LockMutex(pool->mutex);
+    for (;;) {
+        while (!pool->shutting_down && pool->batch == seen_batch) {
+            SDL_CondWait(pool->work_ready, pool->mutex);
+        }
+        if (pool->shutting_down) {
+            break;
+        }
+        seen_batch = pool->batch;
+        SDL_UnlockMutex(pool->mutex);
+
+        thread_pool_drain(pool, worker_index);
+
+        SDL_LockMutex(pool->mutex);
+        if (--pool->busy_workers == 0) {
+            SDL_CondSignal(pool->work_done);
+        }
+    }
+    SDL_UnlockMutex(pool->mutex);
+
+    return 0;
+}
+
+int thread_pool_init(ThreadPool* pool, int worker_count) {
+    if (pool == NULL) {
+        fprintf(stderr, "Error: thread_pool_init received a NULL pool pointer.\n");
+        return 1;
+    }
+
+    pool->worker_count = (worker_count > 0) ? worker_count : 1;
+    pool->threads = NULL;
+    pool->deques = NULL;
+    pool->mutex = NULL;
+    pool->work_ready = NULL;
+    pool->work_done = NULL;
+    pool->batch = 0;
+    pool->busy_workers = 0;
+    pool->shutting_down = 0;
+    pool->task_fn = NULL;
+    pool->context = NULL;
+
+    pool->deques = (TaskDeque*)calloc((size_t)pool->worker_count, sizeof(TaskDeque));
+    if (pool->deques == NULL) {
+        fprintf(stderr, "Failed to allocate thread pool deques.\n");
+        thread_pool_clean_up(pool);
+        return 1;
+    }
+
+    if (pool->worker_count == 1) {
+        return 0; // The calling thread does all the work, no synchronization needed
+    }
+
+    pool->mutex = SDL_CreateMutex();
+    pool->work_ready = SDL_CreateCond();
+    pool->work_done = SDL_CreateCond();
+    pool->threads = (SDL_Thread**)calloc((size_t)pool->worker_count - 1, sizeof(SDL_Thread*));
+    if (!pool->mutex || !pool->work_ready || !pool->work_done || !pool->threads) {
+        fprintf(stderr, "Failed to create thread pool synchronization primitives: %s\n", SDL_GetError());
+        thread_pool_clean_up(pool);
+        return 1;
+    }
+
+    for (int i = 1; i < pool->worker_count; ++i) {
+        WorkerStart* start = (WorkerStart*)malloc(sizeof(WorkerStart));
+        if (start == NULL) {
+            fprintf(stderr, "Failed to allocate worker start data.\n");
+            thread_pool_clean_up(pool);
+            return 1;
+        }
+        start->pool = pool;
+        start->worker_index = i;
+
+        pool->threads[i - 1] = SDL_CreateThread(thread_pool_worker, "render_worker", start);
+        if (pool->threads[i - 1] == NULL) {
+            fprintf(stderr, "Failed to create worker thread: %s\n", SDL_GetError());
+            free(start);
+            thread_pool_clean_up(pool);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// Makes sure every deque can hold the given number of tasks
+static int thread_pool_reserve(ThreadPool* pool, int per_worker) {
+    for (int i = 0; i < pool->worker_count; ++i) {
+        TaskDeque* deque = &pool->deques[i];
+        if (deque->capacity >= per_worker) {
+            continue;
+        }
+        int* tasks = (int*)realloc(deque->tasks, (size_t)per_worker * sizeof(int));
+        if (tasks == NULL) {
+            return 1;
+        }
+        deque->tasks = tasks;
+        deque->capacity = per_worker;
+    }
+    return 0;
+}
+
+void thread_pool_run(ThreadPool* pool, int task_count, ThreadPoolTaskFn task_fn, void* context) {
+    if (pool == NULL || task_fn == NULL || task_count <= 0) {
+        return;
+    }
+
+    // Hand every worker a contiguous block of tasks so neighbouring tiles stay on one core
+    // until the block runs dry; uneven blocks are then rebalanced by stealing.
+    const int per_worker = (task_count + pool->worker_count - 1) / pool->worker_count;
+    if (pool->deques == NULL || thread_pool_reserve(pool, per_worker) != 0) {
+        fprintf(stderr, "Warning: thread pool could not queue tasks, running them serially.\n");
+        for (int task = 0; task < task_count; ++task) {
+            task_fn(context, task, 0);
+        }
+        return;
+    }
+
+    for (int i = 0; i < pool->worker_count; ++i) {
+        TaskDeque* deque = &pool->deques[i];
+        const int first = (int)((long long)task_count * i / pool->worker_count);
+        const int last = (int)((long long)task_count * (i + 1) / pool->worker_count);
+
+        // Pushed in reverse so that the owner pops its block front to back
+        deque->head = 0;
+        deque->tail = 0;
+        for (int task = last - 1; task >= first; --task) {
+            deque->tasks[deque->tail++] = task;
+        }
+    }
+
+    pool->task_fn = task_fn;
+    pool->context = context;
+
+    if (pool->worker_count == 1) {
+        thread_pool_drain(pool, 0);
+        return;
+    }
+
+    // Publish the batch and work on it from this thread as well
+    SDL_LockMutex(pool->mutex);
+    pool->busy_workers = pool->worker_count - 1;
+    pool->batch++;
+    SDL_CondBroadcast(pool->work_ready);
+    SDL_UnlockMutex(pool->mutex);
+
+    thread_pool_drain(pool, 0);
+
+    // Workers may still be finishing stolen tasks; wait until all of them have left the batch
+    SDL_LockMutex(pool->mutex);
+    while (pool->busy_workers > 0) {
+        SDL_CondWait(pool->work_done, pool->mutex);
+    }
+    SDL_UnlockMutex(pool->mutex);
+}
+
+void thread_pool_clean_up(ThreadPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    if (pool->threads != NULL) {
+        SDL_LockMutex(pool->mutex);
+        pool->shutting_down = 1;
+        SDL_CondBroadcast(pool->work_ready);
+        SDL_UnlockMutex(pool->mutex);
+
+        for (int i = 0; i < pool->worker_count - 1; ++i) {
+            if (pool->threads[i] != NULL) {
+                SDL_WaitThread(pool->threads[i], NULL);
+            }
+        }
+        free(pool->threads);
+        pool->threads = NULL;
+    }
+
+    if (pool->deques != NULL) {
+        for (int i = 0; i < pool->worker_count; ++i) {
+            free(pool->deques[i].tasks);
+        }
+        free(pool->deques);
+        pool->deques = NULL;
+    }
+
+    if (pool->work_done) { SDL_DestroyCond(pool->work_done); pool->work_done = NULL; }
+    if (pool->work_ready) { SDL_DestroyCond(pool->work_ready); pool->work_ready = NULL; }
+    if (pool->mutex) { SDL_DestroyMutex(pool->mutex); pool->mutex = NULL; }
+}
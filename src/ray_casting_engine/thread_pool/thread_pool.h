@@ -0,0 +1,63 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+/**
+ * @brief A unit of work executed by the pool.
+ * @param context Shared, read-only job description passed to thread_pool_run.
+ * @param task_index Index of the task in [0, task_count).
+ * @param worker_index Index of the executing worker in [0, worker_count); stable for the whole batch.
+ */
+typedef void (*ThreadPoolTaskFn)(void* context, int task_index, int worker_index);
+
+/**
+ * @brief Per-worker double-ended task queue.
+ * The owner pops from the tail (most recently assigned, cache-warm work),
+ * idle workers steal from the head.
+ */
+typedef struct TaskDeque {
+    int* tasks;
+    int capacity;
+    int head;              ///< Index of the oldest task (next to be stolen).
+    int tail;              ///< One past the newest task (next to be popped by the owner).
+    SDL_SpinLock lock;
+} TaskDeque;
+
+/**
+ * @brief Persistent pool of worker threads with work stealing.
+ * The thread calling thread_pool_run takes part as worker 0, so a pool of
+ * N workers owns N - 1 threads and a single-worker pool owns none.
+ */
+typedef struct ThreadPool {
+    int worker_count;
+    SDL_Thread** threads;          ///< worker_count - 1 background threads.
+    TaskDeque* deques;             ///< One deque per worker.
+
+    SDL_mutex* mutex;
+    SDL_cond* work_ready;          ///< Signalled when a new batch is published.
+    SDL_cond* work_done;           ///< Signalled when the last worker leaves a batch.
+    unsigned int batch;            ///< Incremented for every published batch.
+    int busy_workers;              ///< Background workers still inside the current batch.
+    int shutting_down;
+
+    ThreadPoolTaskFn task_fn;      ///< Task function of the current batch.
+    void* context;                 ///< Context of the current batch.
+} ThreadPool;
+
+// Returns the number of worker threads matching the machine's logical CPUs
+int thread_pool_default_worker_count(void);
+
+// Creates a pool with the given number of workers (including the calling thread)
+int thread_pool_init(ThreadPool* pool, int worker_count);
+
+// Executes task_count tasks and blocks until every one of them has completed
+void thread_pool_run(ThreadPool* pool, int task_count, ThreadPoolTaskFn task_fn, void* context);
+
+// Stops and joins all workers and releases the pool's resources
+void thread_pool_clean_up(ThreadPool* pool);
+
+#endif
@@ -0,0 +1,81 @@
+#include "./transform.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define INITIAL_TRANSFORM_CAPACITY 16 // Starting capacity for transform list
+
+// Row-major product a * b of two 3x3 matrices
+static void transform_multiply(const float a[9], const float b[9], float out[9]) {
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column) {
+            out[3 * row + column] = a[3 * row] * b[column] + a[3 * row + 1] * b[3 + column] + a[3 * row + 2] * b[6 + column];
+        }
+    }
+}
+
+Transform transform_new(float yaw, float pitch, float roll, float scale) {
+    const double to_radians = M_PI / 180.0;
+    const float cy = (float)cos(yaw * to_radians), sy = (float)sin(yaw * to_radians);
+    const float cp = (float)cos(pitch * to_radians), sp = (float)sin(pitch * to_radians);
+    const float cr = (float)cos(roll * to_radians), sr = (float)sin(roll * to_radians);
+
+    const float yaw_matrix[9] = { cy, 0.0f, sy, 0.0f, 1.0f, 0.0f, -sy, 0.0f, cy };
+    const float pitch_matrix[9] = { 1.0f, 0.0f, 0.0f, 0.0f, cp, -sp, 0.0f, sp, cp };
+    const float roll_matrix[9] = { cr, -sr, 0.0f, sr, cr, 0.0f, 0.0f, 0.0f, 1.0f };
+
+    Transform transform;
+    float yaw_pitch[9];
+    transform_multiply(yaw_matrix, pitch_matrix, yaw_pitch);
+    transform_multiply(yaw_pitch, roll_matrix, transform.rotation);
+    transform.scale = scale;
+    transform.degrees = vector3_new(yaw, pitch, roll);
+    return transform;
+}
+
+int transformList_init(TransformList* list) {
+    if (list == NULL) {
+        fprintf(stderr, "Error: transformList_init received a NULL list pointer.\n");
+        return -1;
+    }
+
+    list->transforms = NULL;
+    list->count = 0;
+    list->capacity = 0;
+    list->generation = 0;
+    return 0;
+}
+
+int transformList_add(TransformList* list, Transform transform) {
+    if (list == NULL) {
+        return -1;
+    }
+
+    if (list->count == list->capacity) {
+        int new_capacity = (list->capacity == 0) ? INITIAL_TRANSFORM_CAPACITY : list->capacity * 2;
+        Transform* grown = (Transform*)realloc(list->transforms, (size_t)new_capacity * sizeof(Transform));
+        if (grown == NULL) {
+            return -1;
+        }
+        list->transforms = grown;
+        list->capacity = new_capacity;
+    }
+
+    list->transforms[list->count] = transform;
+    list->generation++;
+    return list->count++;
+}
+
+void transformList_free(TransformList* list) {
+    if (list == NULL) {
+        return;
+    }
+    free(list->transforms);
+    list->transforms = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "../vector/vector.h"
+
+#ifndef _TRANSFORM_H_
+#define _TRANSFORM_H_
+
+// Rotation and uniform scale of an instance; its translation is the instance's Object.position.
+// A uniform scale keeps unit ray directions unit length in instance space, so distances only scale.
+typedef struct Transform {
+    float rotation[9];     // Row-major, instance space to world space
+    float scale;           // World units per instance unit, > 0
+    Vector3 degrees;       // Yaw (about +y), pitch (about +x) and roll (about +z) as given, for writing scenes back
+} Transform;
+
+typedef struct TransformList {
+    Transform* transforms;
+    int count;
+    int capacity;
+    unsigned int generation;  // Incremented whenever a transform is added
+} TransformList;
+
+// Rotates by roll, then pitch, then yaw (all in degrees) and scales by scale
+Transform transform_new(float yaw, float pitch, float roll, float scale);
+
+// Instance space direction to world space, without the scale
+static inline Vector3 transform_rotate(const Transform* transform, Vector3 v) {
+    const float* m = transform->rotation;
+    return vector3_new(m[0] * v.x + m[1] * v.y + m[2] * v.z,
+                       m[3] * v.x + m[4] * v.y + m[5] * v.z,
+                       m[6] * v.x + m[7] * v.y + m[8] * v.z);
+}
+
+// World space direction to instance space, without the scale (the inverse rotation is the transpose)
+static inline Vector3 transform_unrotate(const Transform* transform, Vector3 v) {
+    const float* m = transform->rotation;
+    return vector3_new(m[0] * v.x + m[3] * v.y + m[6] * v.z,
+                       m[1] * v.x + m[4] * v.y + m[7] * v.z,
+                       m[2] * v.x + m[5] * v.y + m[8] * v.z);
+}
+
+int transformList_init(TransformList* list);
+// Returns the index of the new transform, or -1 on failure
+int transformList_add(TransformList* list, Transform transform);
+void transformList_free(TransformList* list);
+
+#endif
@@ -0,0 +1,212 @@
+#include "./wavefront.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../array/array.h"
+#include "../engine/engine.h"
+
+void wavefront_init(Wavefront* wavefront) {
+    memset(wavefront, 0, sizeof(*wavefront));
+}
+
+int wavefront_begin(Wavefront* wavefront, int pixel_count, int light_count) {
+    if (!wavefront || pixel_count < 0 || light_count < 0) {
+        fprintf(stderr, "Error: Invalid arguments passed to wavefront_begin.\n");
+        return -1;
+    }
+
+    // Every ray spawns at most one reflection and one shadow ray per light of the current batch
+    if (pixel_count > wavefront->pixel_capacity) {
+        if (array_reserve((void**)&wavefront->rays, sizeof(WavefrontRay), pixel_count) != 0 ||
+            array_reserve((void**)&wavefront->next_rays, sizeof(WavefrontRay), pixel_count) != 0 ||
+            array_reserve((void**)&wavefront->hits, sizeof(WavefrontHit), pixel_count) != 0 ||
+            array_reserve((void**)&wavefront->radiance, 3 * sizeof(float), pixel_count) != 0) {
+            fprintf(stderr, "Error: Failed to allocate wavefront queues for %d pixels.\n", pixel_count);
+            return -1;
+        }
+        wavefront->pixel_capacity = pixel_count;
+    }
+
+    const int batch_light_count = (light_count < WAVEFRONT_LIGHT_BATCH) ? light_count : WAVEFRONT_LIGHT_BATCH;
+    const int shadow_ray_count = pixel_count * batch_light_count;
+    if (shadow_ray_count > wavefront->shadow_ray_capacity) {
+        if (array_reserve((void**)&wavefront->shadow_rays, sizeof(WavefrontShadowRay), shadow_ray_count) != 0) {
+            fprintf(stderr, "Error: Failed to allocate %d wavefront shadow rays.\n", shadow_ray_count);
+            return -1;
+        }
+        wavefront->shadow_ray_capacity = shadow_ray_count;
+    }
+
+    wavefront->ray_count = 0;
+    wavefront->next_ray_count = 0;
+    wavefront->hit_count = 0;
+    wavefront->shadow_ray_count = 0;
+    wavefront->pixel_count = pixel_count;
+    memset(wavefront->radiance, 0, 3 * sizeof(float) * (size_t)pixel_count);
+
+    return 0;
+}
+
+void wavefront_push_primary(Wavefront* wavefront, Vector3 origin, Vector3 direction, int pixel) {
+    WavefrontRay* ray = &wavefront->rays[wavefront->ray_count++];
+    ray->origin = origin;
+    ray->direction = direction;
+    ray->weight = 1.0f;
+    ray->pixel = pixel;
+}
+
+// Adds weight * color to a pixel's accumulator
+static void wavefront_accumulate(Wavefront* wavefront, int pixel, float weight, Color color) {
+    float* radiance = &wavefront->radiance[3 * pixel];
+    radiance[0] += weight * color.r;
+    radiance[1] += weight * color.g;
+    radiance[2] += weight * color.b;
+}
+
+// Stage 1: nearest hits for the whole queue. Misses resolve to the background immediately.
+static void wavefront_intersect(Wavefront* wavefront, const PreparedScene* scene, float t_min) {
+    wavefront->hit_count = 0;
+
+    for (int i = 0; i < wavefront->ray_count; ++i) {
+        const WavefrontRay* ray = &wavefront->rays[i];
+        ClosestIntersection intersection = engine_calculate_closest_intersection(scene, ray->origin, ray->direction, t_min, FLT_MAX);
+
+        if (intersection.closest_object == NULL) {
+            wavefront_accumulate(wavefront, ray->pixel, ray->weight, scene->background_color);
+            continue;
+        }
+
+        ENGINE_STATS_ADD(closest_hits, 1);
+        WavefrontHit* hit = &wavefront->hits[wavefront->hit_count++];
+        hit->material = engine_hit_material(scene, &intersection);
+        hit->point = vector3_add(ray->origin, vector3_scale(ray->direction, intersection.closest_t));
+        hit->normal = engine_surface_normal(scene, &intersection, hit->point, ray->direction);
+        hit->view_direction = vector3_scale(ray->direction, -1.0f);   // Ray directions are unit vectors
+        hit->weight = ray->weight;
+        hit->intensity = scene->ambient_intensity;
+        hit->pixel = ray->pixel;
+    }
+}
+
+// Stage 2: unshadowed light of lights [first_light, end_light) at every hit, queuing a shadow ray
+// wherever a light could contribute. The batch fits one light_terms kernel call per hit.
+static void wavefront_generate_shadow_rays(Wavefront* wavefront, const PreparedScene* scene, int first_light, int end_light) {
+    const int count = end_light - first_light;
+    KernelLightTerms terms;
+    wavefront->shadow_ray_count = 0;
+
+    for (int h = 0; h < wavefront->hit_count; ++h) {
+        const WavefrontHit* hit = &wavefront->hits[h];
+        ENGINE_STATS_ADD(lights_evaluated, count);
+        scene->kernels->light_terms(&scene->lights[first_light], count, hit->point, hit->normal,
+                                    hit->material->specular, hit->view_direction, &terms);
+
+        for (int i = 0; i < count; ++i) {
+            // An unlit side cannot be darkened any further
+            if (terms.contribution[i] <= 0.0f) {
+                continue;
+            }
+
+            WavefrontShadowRay* shadow_ray = &wavefront->shadow_rays[wavefront->shadow_ray_count++];
+            shadow_ray->origin = hit->point;
+            shadow_ray->direction = vector3_new(terms.direction_x[i], terms.direction_y[i], terms.direction_z[i]);
+            shadow_ray->t_max = terms.t_max[i];
+            shadow_ray->contribution = terms.contribution[i];
+            shadow_ray->hit = h;
+        }
+    }
+}
+
+// Stage 3: any-hit queries for the shadow queue
+static void wavefront_trace_shadow_rays(Wavefront* wavefront, const PreparedScene* scene, float t_min) {
+    for (int i = 0; i < wavefront->shadow_ray_count; ++i) {
+        const WavefrontShadowRay* shadow_ray = &wavefront->shadow_rays[i];
+
+        if (!engine_is_occluded(scene, shadow_ray->origin, shadow_ray->direction, t_min, shadow_ray->t_max)) {
+            wavefront->hits[shadow_ray->hit].intensity += shadow_ray->contribution;
+        } else {
+            ENGINE_STATS_ADD(occluded_shadow_rays, 1);
+        }
+    }
+}
+
+// Stage 4: local color of every hit, splitting the throughput between it and the reflection ray
+static void wavefront_shade(Wavefront* wavefront, int can_reflect) {
+    wavefront->next_ray_count = 0;
+
+    for (int h = 0; h < wavefront->hit_count; ++h) {
+        const WavefrontHit* hit = &wavefront->hits[h];
+        const PreparedMaterial* material = hit->material;
+        const float intensity = fminf(hit->intensity, 1.0f);
+
+        const Color local_color = color_new(
+            (unsigned char)(material->color.r * intensity),
+            (unsigned char)(material->color.g * intensity),
+            (unsigned char)(material->color.b * intensity)
+        );
+
+        if (!can_reflect || material->reflectivity <= 0) {
+            wavefront_accumulate(wavefront, hit->pixel, hit->weight, local_color);
+            continue;
+        }
+
+        wavefront_accumulate(wavefront, hit->pixel, hit->weight * (1.0f - material->reflectivity), local_color);
+
+        WavefrontRay* reflection = &wavefront->next_rays[wavefront->next_ray_count++];
+        reflection->origin = hit->point;
+        reflection->direction = engine_reflect_ray(hit->view_direction, hit->normal);
+        reflection->weight = hit->weight * material->reflectivity;
+        reflection->pixel = hit->pixel;
+    }
+}
+
+int wavefront_trace(Wavefront* wavefront, const PreparedScene* scene, int recursion_depth, float t_min) {
+    if (!wavefront || !scene) {
+        fprintf(stderr, "Error: NULL pointer passed to wavefront_trace.\n");
+        return 0;
+    }
+
+    int reflection_ray_count = 0;
+
+    for (int bounce = 0; wavefront->ray_count > 0; ++bounce) {
+        if (bounce > 0) {
+            reflection_ray_count += wavefront->ray_count;
+        }
+        ENGINE_STATS_DEPTH(bounce, wavefront->ray_count);
+
+        wavefront_intersect(wavefront, scene, t_min);
+
+        // Shadow rays are queued one batch of lights at a time so the queue stays bounded for any light count
+        for (int first_light = 0; first_light < scene->light_count; first_light += WAVEFRONT_LIGHT_BATCH) {
+            const int end_light = (scene->light_count - first_light < WAVEFRONT_LIGHT_BATCH) ? scene->light_count : first_light + WAVEFRONT_LIGHT_BATCH;
+            wavefront_generate_shadow_rays(wavefront, scene, first_light, end_light);
+            wavefront_trace_shadow_rays(wavefront, scene, t_min);
+        }
+
+        wavefront_shade(wavefront, bounce < recursion_depth);
+
+        // The reflection queue becomes the next bounce
+        WavefrontRay* swap = wavefront->rays;
+        wavefront->rays = wavefront->next_rays;
+        wavefront->next_rays = swap;
+        wavefront->ray_count = wavefront->next_ray_count;
+        wavefront->next_ray_count = 0;
+    }
+
+    return reflection_ray_count;
+}
+
+void wavefront_free(Wavefront* wavefront) {
+    if (!wavefront) {
+        return;
+    }
+
+    free(wavefront->rays);
+    free(wavefront->next_rays);
+    free(wavefront->hits);
+    free(wavefront->shadow_rays);
+    free(wavefront->radiance);
+    wavefront_init(wavefront);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "../color/color.h"
+#include "../kernels/kernels.h"
+#include "../object/object.h"
+#include "../scene/scene.h"
+#include "../vector/vector.h"
+
+#ifndef _WAVEFRONT_H_
+#define _WAVEFRONT_H_
+
+#define WAVEFRONT_LIGHT_BATCH KERNELS_LIGHT_BATCH ///< Lights whose shadow rays are queued and traced together; bounds the shadow queue per pixel.
+
+/**
+ * @brief A ray waiting in a wavefront queue.
+ */
+typedef struct WavefrontRay {
+    Vector3 origin;
+    Vector3 direction;
+    float weight;          ///< Throughput: share of the pixel's final color this ray contributes.
+    int pixel;             ///< Index of the pixel the ray contributes to.
+} WavefrontRay;
+
+/**
+ * @brief Surface point found for a WavefrontRay, waiting for its shadow rays.
+ */
+typedef struct WavefrontHit {
+    const PreparedMaterial* material;
+    Vector3 point;
+    Vector3 normal;
+    Vector3 view_direction;  ///< Unit vector from the point back along the incoming ray.
+    float weight;            ///< Throughput of the ray that produced the hit.
+    float intensity;         ///< Light gathered so far (ambient plus unoccluded lights).
+    int pixel;
+} WavefrontHit;
+
+/**
+ * @brief Shadow ray from a hit towards one light.
+ */
+typedef struct WavefrontShadowRay {
+    Vector3 origin;
+    Vector3 direction;
+    float t_max;
+    float contribution;    ///< Intensity added to the hit when the light is visible.
+    int hit;               ///< Index of the WavefrontHit the ray belongs to.
+} WavefrontShadowRay;
+
+/**
+ * @brief Ray queues and per-pixel accumulators for tracing a batch of pixels breadth first.
+ * All rays of one bounce are intersected together before any ray of the next bounce,
+ * so the reflection depth is bounded by memory rather than by the C stack.
+ * One Wavefront is owned by each render worker and reused across tiles.
+ */
+typedef struct Wavefront {
+    WavefrontRay* rays;                ///< Rays of the current bounce.
+    WavefrontRay* next_rays;           ///< Reflection rays spawned for the next bounce.
+    int ray_count;
+    int next_ray_count;
+
+    WavefrontHit* hits;                ///< Hits of the current bounce.
+    int hit_count;
+
+    WavefrontShadowRay* shadow_rays;   ///< Shadow rays of the current bounce and light batch.
+    int shadow_ray_count;
+
+    float* radiance;                   ///< Accumulated RGB per pixel, three floats each.
+    int pixel_count;
+
+    int pixel_capacity;                ///< Capacity of rays, next_rays, hits and pixels.
+    int shadow_ray_capacity;
+} Wavefront;
+
+// Initializes an empty wavefront
+void wavefront_init(Wavefront* wavefront);
+
+// Clears the queues and accumulators for pixel_count pixels lit by light_count lights.
+// Reserves every queue up front so that tracing never allocates; the shadow queue holds one
+// batch of at most WAVEFRONT_LIGHT_BATCH lights per pixel. Returns 0 on success, -1 on failure.
+int wavefront_begin(Wavefront* wavefront, int pixel_count, int light_count);
+
+// Queues a primary ray with full weight for a pixel in [0, pixel_count)
+void wavefront_push_primary(Wavefront* wavefront, Vector3 origin, Vector3 direction, int pixel);
+
+// Traces all queued rays bounce by bounce until no rays remain or recursion_depth reflections were followed.
+// Returns the number of reflection rays traced.
+int wavefront_trace(Wavefront* wavefront, const PreparedScene* scene, int recursion_depth, float t_min);
+
+// Releases the queues and accumulators
+void wavefront_free(Wavefront* wavefront);
+
+#endif